@@ -0,0 +1,97 @@
+#include "little/compat.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "little/arena.h"
+
+using namespace hf;
+
+// Simulate request handling: create M small maps, insert K entries into
+// each, and destroy them all at the end of the request.
+
+struct use_std_allocator {
+    using map = small::map<int, int>;
+
+    void begin_request() {}
+    map make() { return map(); }
+    void end_request() {}
+};
+
+struct use_arena {
+    using map = small::arena_map<int, int>;
+
+    arena a;
+
+    void begin_request() {}
+    map make() { return map(arena_allocator<std::pair<int, int>>(a)); }
+    void end_request() { a.release(); }
+};
+
+struct use_arena_no_release {
+    using map = small::arena_map<int, int>;
+
+    arena a;
+
+    void begin_request() {}
+    map make() { return map(arena_allocator<std::pair<int, int>>(a)); }
+    void end_request() {}
+};
+
+#ifdef HF_HAVE_PMR
+struct use_pmr_monotonic {
+    using map = small::pmr::map<int, int>;
+
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> r;
+
+    void begin_request() { r.reset(new std::pmr::monotonic_buffer_resource); }
+    map make() { return map(r.get()); }
+    void end_request() { r.reset(); }
+};
+#endif
+
+template <typename Alloc>
+void bench_request(benchmark::State& state) {
+    int M = state.range(0);
+    int K = state.range(1);
+
+    Alloc alloc;
+    while (state.KeepRunning()) {
+        alloc.begin_request();
+        {
+            std::vector<typename Alloc::map> maps;
+            maps.reserve(M);
+            for (int i = 0; i<M; ++i) {
+                maps.push_back(alloc.make());
+                for (int k = 0; k<K; ++k) maps.back()[k] = i;
+            }
+            benchmark::DoNotOptimize(maps.data());
+        }
+        alloc.end_request();
+    }
+    state.SetItemsProcessed(state.iterations()*M);
+}
+
+template <typename Alloc>
+void register_benches(const std::string& label) {
+    auto args = [](benchmark::internal::Benchmark* b) {
+        for (int m: {100, 10000}) for (int k: {1, 4, 16}) b->Args({m, k});
+    };
+
+    benchmark::RegisterBenchmark((label+".request").c_str(), bench_request<Alloc>)->Apply(args);
+}
+
+int main(int argc, char** argv) {
+    register_benches<use_std_allocator>("smallmap/std_allocator");
+    register_benches<use_arena>("smallmap/arena");
+    register_benches<use_arena_no_release>("smallmap/arena_reuse");
+#ifdef HF_HAVE_PMR
+    register_benches<use_pmr_monotonic>("smallmap/pmr_monotonic");
+#endif
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
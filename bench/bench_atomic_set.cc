@@ -0,0 +1,75 @@
+#include "little/compat.h"
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "little/atomic_set.h"
+#include "little/multiset.h"
+
+using namespace hf;
+
+// Deduplication in a parallel traversal: V per-vertex visited sets, each
+// of capacity 32, shared by all threads. Each operation visits a random
+// id from [0,U) at a random vertex, inserting it if not already present.
+// Sets are never reset, so after warm-up nearly every visit finds its id
+// already present, after a scan of up to U entries; the benchmark thus
+// measures contended lookups in sets filled to U.
+
+constexpr int V = 64;
+constexpr std::size_t cap = 32;
+
+struct atomic_visited {
+    tiny::atomic_set<std::uint32_t, cap> s;
+
+    bool visit(std::uint32_t id) { return s.insert_unique(id); }
+};
+
+struct spinlock_visited {
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    tiny::multiset<std::uint32_t, cap> s;
+
+    bool visit(std::uint32_t id) {
+        while (lock.test_and_set(std::memory_order_acquire)) ;
+        bool fresh = !s.count(id);
+        if (fresh) s.insert(id);
+        lock.clear(std::memory_order_release);
+        return fresh;
+    }
+};
+
+template <typename Visited>
+void bench_visit(benchmark::State& state) {
+    static std::vector<Visited> sets(V);
+    static std::atomic<unsigned> seed(0);
+
+    std::uint32_t U = state.range(0);
+    std::minstd_rand gen(++seed);
+    std::uniform_int_distribution<int> vertex(0, V-1);
+    std::uniform_int_distribution<std::uint32_t> id(0, U-1);
+
+    std::size_t n_fresh = 0;
+    while (state.KeepRunning()) {
+        n_fresh += sets[vertex(gen)].visit(id(gen));
+    }
+    benchmark::DoNotOptimize(n_fresh);
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Visited>
+void register_benches(const std::string& label) {
+    for (int u: {8, 32}) {
+        benchmark::RegisterBenchmark((label+".visit").c_str(), bench_visit<Visited>)->Arg(u)->ThreadRange(2, 64)->UseRealTime();
+    }
+}
+
+int main(int argc, char** argv) {
+    register_benches<atomic_visited>("tinyset/atomic");
+    register_benches<spinlock_visited>("tinyset/spinlock");
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
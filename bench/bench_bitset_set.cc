@@ -0,0 +1,116 @@
+#include "little/compat.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "little/bitset_set.h"
+#include "little/multiset.h"
+
+using namespace hf;
+
+constexpr std::size_t domain = 256;
+
+// Hand-written std::bitset set, for reference.
+
+struct std_bitset_set {
+    void insert(std::uint8_t k) { bits.set(k); }
+    bool contains(std::uint8_t k) const { return bits.test(k); }
+    std::size_t intersection_size(const std_bitset_set& other) const { return (bits&other.bits).count(); }
+
+    std::bitset<domain> bits;
+};
+
+// Uniform operations over the set representations under test.
+
+template <typename Set>
+bool contains(const Set& s, std::uint8_t k) { return s.contains(k); }
+
+template <typename Set>
+std::size_t intersection_size(const Set& a, const Set& b) { return a.intersection_size(b); }
+
+template <std::size_t N>
+bool contains(const tiny::multiset<std::uint8_t, N>& s, std::uint8_t k) { return s.find(k)!=s.end(); }
+
+template <std::size_t N>
+std::size_t intersection_size(const tiny::multiset<std::uint8_t, N>& a, const tiny::multiset<std::uint8_t, N>& b) {
+    std::size_t c = 0;
+    for (auto k: a) c += b.find(k)!=b.end();
+    return c;
+}
+
+// N distinct random keys from the domain.
+
+template <typename Gen>
+std::vector<std::uint8_t> random_keys(Gen& gen, std::size_t N) {
+    std::vector<std::uint8_t> keys(domain);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), gen);
+    keys.resize(N);
+    return keys;
+}
+
+template <typename Set>
+Set make_set(const std::vector<std::uint8_t>& keys) {
+    Set s;
+    for (auto k: keys) s.insert(k);
+    return s;
+}
+
+// Look up every key in the domain against a set of N elements.
+
+template <typename Set>
+void bench_contains(benchmark::State& state) {
+    std::minstd_rand gen;
+    std::size_t N = state.range(0);
+
+    auto keys = random_keys(gen, N);
+    Set s = make_set<Set>(keys);
+
+    std::vector<std::uint8_t> queries = random_keys(gen, domain);
+
+    while (state.KeepRunning()) {
+        std::size_t hits = 0;
+        for (auto q: queries) hits += contains(s, q);
+        benchmark::DoNotOptimize(hits);
+        if (hits!=N) throw std::runtime_error("lookup mismatch");
+    }
+}
+
+// Intersect two sets of N elements each.
+
+template <typename Set>
+void bench_intersection_size(benchmark::State& state) {
+    std::minstd_rand gen;
+    std::size_t N = state.range(0);
+
+    Set a = make_set<Set>(random_keys(gen, N));
+    Set b = make_set<Set>(random_keys(gen, N));
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(intersection_size(a, b));
+    }
+}
+
+template <typename Set>
+void register_benches(const std::string& label) {
+    auto sizes = [](benchmark::internal::Benchmark* b) { for (int n: {1, 2, 4, 8, 16, 32, 64}) b->Arg(n); };
+
+    benchmark::RegisterBenchmark((label+".contains").c_str(), bench_contains<Set>)->Apply(sizes);
+    benchmark::RegisterBenchmark((label+".intersection_size").c_str(), bench_intersection_size<Set>)->Apply(sizes);
+}
+
+int main(int argc, char** argv) {
+    register_benches<tiny::bitset_set<domain, std::uint8_t>>("bitset_set");
+    register_benches<tiny::multiset<std::uint8_t, 64>>("tinymultiset");
+    register_benches<std_bitset_set>("std_bitset");
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,114 @@
+#include "little/compat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "little/cache.h"
+
+using namespace hf;
+
+// Reference LRU cache: hash map into a recency-ordered list.
+
+template <typename Key, typename Value, std::size_t N>
+struct std_lru_cache {
+    template <typename F>
+    Value& get_or_insert(const Key& key, F compute) {
+        auto i = index.find(key);
+        if (i!=index.end()) {
+            ++n_hit;
+            entries.splice(entries.begin(), entries, i->second);
+            return i->second->second;
+        }
+
+        ++n_miss;
+        if (entries.size()==N) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        entries.emplace_front(key, compute());
+        index[key] = entries.begin();
+        return entries.front().second;
+    }
+
+    std::size_t hits() const { return n_hit; }
+    std::size_t misses() const { return n_miss; }
+
+private:
+    std::list<std::pair<Key, Value>> entries;
+    std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator> index;
+    std::size_t n_hit = 0, n_miss = 0;
+};
+
+// Zipf-distributed keys in [0, universe) with exponent s.
+
+template <typename Gen>
+std::vector<int> zipf_keys(Gen& gen, std::size_t count, int universe, double s) {
+    std::vector<double> cdf(universe);
+    double total = 0;
+    for (int k = 0; k<universe; ++k) cdf[k] = total += 1.0/std::pow(k+1, s);
+
+    std::uniform_real_distribution<double> U(0, total);
+    std::vector<int> keys(count);
+    for (auto& k: keys) k = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), U(gen))-cdf.begin());
+
+    // decorrelate key values from popularity
+    std::vector<int> perm(universe);
+    for (int k = 0; k<universe; ++k) perm[k] = k;
+    std::shuffle(perm.begin(), perm.end(), gen);
+    for (auto& k: keys) k = perm[k];
+    return keys;
+}
+
+// Memoise a cheap function of the key over a Zipf key stream, reporting
+// the hit rate.
+
+template <typename Cache>
+void bench_zipf(benchmark::State& state) {
+    std::minstd_rand gen;
+    auto keys = zipf_keys(gen, 1<<16, 1000, state.range(0)/100.);
+
+    Cache cache;
+    std::uint64_t sum = 0;
+    while (state.KeepRunning()) {
+        for (int k: keys) {
+            sum += cache.get_or_insert(k, [k]() { return std::uint64_t(k)*k; });
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+
+    state.SetItemsProcessed(state.iterations()*keys.size());
+    state.counters["hit_rate"] = double(cache.hits())/(cache.hits()+cache.misses());
+}
+
+template <template <typename, typename, std::size_t> class Cache>
+void register_benches(const std::string& label) {
+    auto exponents = [](benchmark::internal::Benchmark* b) { for (int s: {80, 100, 120}) b->Arg(s); };
+
+    benchmark::RegisterBenchmark((label+"/8.zipf").c_str(), bench_zipf<Cache<int, std::uint64_t, 8>>)->Apply(exponents);
+    benchmark::RegisterBenchmark((label+"/16.zipf").c_str(), bench_zipf<Cache<int, std::uint64_t, 16>>)->Apply(exponents);
+    benchmark::RegisterBenchmark((label+"/32.zipf").c_str(), bench_zipf<Cache<int, std::uint64_t, 32>>)->Apply(exponents);
+    benchmark::RegisterBenchmark((label+"/64.zipf").c_str(), bench_zipf<Cache<int, std::uint64_t, 64>>)->Apply(exponents);
+}
+
+template <typename Key, typename Value, std::size_t N>
+using lru_cache = tiny::lru_cache<Key, Value, N>;
+
+template <typename Key, typename Value, std::size_t N>
+using clock_cache = tiny::clock_cache<Key, Value, N>;
+
+int main(int argc, char** argv) {
+    register_benches<lru_cache>("lru_cache");
+    register_benches<clock_cache>("clock_cache");
+    register_benches<std_lru_cache>("std_lru_cache");
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,104 @@
+#include "little/compat.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "benchmark/benchmark.h"
+#include "little/concurrent_map.h"
+#include "little/map.h"
+
+using namespace hf;
+
+// A configuration map of K entries shared between reader threads and,
+// optionally, a background writer updating one entry every 100 µs.
+
+constexpr int K = 12;
+
+struct seqlock_map {
+    tiny::concurrent_map<int, int, 16> m;
+
+    seqlock_map() { for (int k = 0; k<K; ++k) m.insert_or_assign(k, k); }
+    int get(int k) const { return m.get_or(k, -1); }
+    void set(int k, int v) { m.insert_or_assign(k, v); }
+};
+
+struct mutex_map {
+    mutable std::mutex mx;
+    tiny::map<int, int, 16> m;
+
+    mutex_map() { for (int k = 0; k<K; ++k) m[k] = k; }
+
+    int get(int k) const {
+        std::lock_guard<std::mutex> lock(mx);
+        auto i = m.find(k);
+        return i==m.end()? -1: i->second;
+    }
+
+    void set(int k, int v) {
+        std::lock_guard<std::mutex> lock(mx);
+        m[k] = v;
+    }
+};
+
+template <typename Shared, bool with_writer>
+Shared& instance() {
+    static Shared s;
+    return s;
+}
+
+template <typename Shared>
+struct background_writer {
+    std::atomic<bool> stop;
+    std::thread t;
+
+    background_writer(): stop(false) {
+        t = std::thread([this]() {
+            Shared& s = instance<Shared, true>();
+            for (int v = 0; !stop.load(); ++v) {
+                s.set(v%K, v);
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+    }
+
+    ~background_writer() {
+        stop.store(true);
+        t.join();
+    }
+};
+
+template <typename Shared, bool with_writer>
+void bench_read(benchmark::State& state) {
+    const Shared& s = instance<Shared, with_writer>();
+
+    while (state.KeepRunning()) {
+        int sum = 0;
+        for (int k = 0; k<K; ++k) sum += s.get(k);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*K);
+}
+
+template <typename Shared>
+void register_benches(const std::string& label) {
+    // construct shared instances before any timing
+    instance<Shared, false>();
+    instance<Shared, true>();
+
+    benchmark::RegisterBenchmark((label+".read").c_str(), bench_read<Shared, false>)->ThreadRange(1, 64)->UseRealTime();
+    benchmark::RegisterBenchmark((label+".read_with_writer").c_str(), bench_read<Shared, true>)->ThreadRange(1, 64)->UseRealTime();
+}
+
+int main(int argc, char** argv) {
+    register_benches<seqlock_map>("tinymap/seqlock");
+    register_benches<mutex_map>("tinymap/mutex");
+
+    background_writer<seqlock_map> w1;
+    background_writer<mutex_map> w2;
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
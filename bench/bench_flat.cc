@@ -0,0 +1,176 @@
+#include "little/compat.h"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "little/flat.h"
+#include "little/map.h"
+
+using namespace hf;
+
+// A checkpoint of M maps of up to 8 uint32_t to float entries, each
+// holding between 0 and 8 entries with keys drawn from [0,16), is
+// written once to a temporary file. Restart times getting from the file
+// to a state that answers lookups: either reading it element by element
+// and rebuilding the maps, or mapping the flat image and viewing it in
+// place. Lookups are of a random key at a random map. The file is read
+// through the page cache, warm after the first run.
+
+constexpr std::size_t N = 8;
+typedef tiny::map<std::uint32_t, float, N> map_type;
+
+struct checkpoint {
+    std::string elementwise_path, flat_path;
+
+    explicit checkpoint(std::size_t M) {
+        std::minstd_rand gen;
+        std::uniform_int_distribution<std::uint32_t> key(0, 15);
+        std::uniform_int_distribution<std::size_t> fill_to(0, N);
+
+        std::vector<map_type> maps(M);
+        for (std::size_t h = 0; h<M; ++h) {
+            std::size_t n = fill_to(gen);
+            while (maps[h].size()<n) maps[h][key(gen)] = float(h);
+        }
+
+        elementwise_path = temp_path();
+        std::ofstream out(elementwise_path, std::ios::binary);
+        std::uint64_t m = M;
+        out.write(reinterpret_cast<const char*>(&m), sizeof(m));
+        for (const auto& x: maps) {
+            std::uint32_t n = x.size();
+            out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+            for (const auto& e: x) {
+                out.write(reinterpret_cast<const char*>(&e.first), sizeof(e.first));
+                out.write(reinterpret_cast<const char*>(&e.second), sizeof(e.second));
+            }
+        }
+
+        flat_path = temp_path();
+        std::ofstream flat_out(flat_path, std::ios::binary);
+        tiny::write_flat(flat_out, maps.begin(), maps.end());
+    }
+
+    ~checkpoint() {
+        std::remove(elementwise_path.c_str());
+        std::remove(flat_path.c_str());
+    }
+
+    static std::string temp_path() {
+        char path[] = "/tmp/bench_flat.XXXXXX";
+        int fd = mkstemp(path);
+        if (fd<0) throw std::runtime_error("mkstemp failed");
+        ::close(fd);
+        return path;
+    }
+};
+
+// checkpoint files are kept for the run, one for each M
+const checkpoint& instance(std::size_t M) {
+    static std::map<std::size_t, std::unique_ptr<checkpoint>> files;
+    auto& c = files[M];
+    if (!c) c.reset(new checkpoint(M));
+    return *c;
+}
+
+struct use_rebuild {
+    std::vector<map_type> maps;
+
+    explicit use_rebuild(const checkpoint& c) {
+        std::ifstream in(c.elementwise_path, std::ios::binary);
+        std::uint64_t m;
+        in.read(reinterpret_cast<char*>(&m), sizeof(m));
+        maps.resize(m);
+        for (auto& x: maps) {
+            std::uint32_t n;
+            in.read(reinterpret_cast<char*>(&n), sizeof(n));
+            for (std::uint32_t i = 0; i<n; ++i) {
+                std::uint32_t k;
+                float v;
+                in.read(reinterpret_cast<char*>(&k), sizeof(k));
+                in.read(reinterpret_cast<char*>(&v), sizeof(v));
+                x.insert(std::make_pair(k, v));
+            }
+        }
+    }
+
+    std::size_t size() const { return maps.size(); }
+
+    float get(std::size_t h, std::uint32_t k) const {
+        auto i = maps[h].find(k);
+        return i==maps[h].end()? 0.f: i->second;
+    }
+};
+
+struct use_mmap {
+    mapped_file file;
+    tiny::view_array<tiny::map_view<std::uint32_t, float, N>> views;
+
+    explicit use_mmap(const checkpoint& c): file(c.flat_path), views(file.data(), file.size()) {}
+
+    std::size_t size() const { return views.size(); }
+
+    float get(std::size_t h, std::uint32_t k) const {
+        const float* v = views[h].get_ptr(k);
+        return v? *v: 0.f;
+    }
+};
+
+template <typename Store>
+void bench_restart(benchmark::State& state) {
+    const checkpoint& c = instance(state.range(0));
+
+    while (state.KeepRunning()) {
+        Store store(c);
+        benchmark::DoNotOptimize(store.get(0, 0));
+    }
+    state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+
+template <typename Store>
+void bench_lookup(benchmark::State& state) {
+    std::size_t M = state.range(0);
+    const checkpoint& c = instance(M);
+    Store store(c);
+
+    constexpr std::size_t Q = 4096;
+    std::minstd_rand gen;
+    std::uniform_int_distribution<std::size_t> node(0, M-1);
+    std::uniform_int_distribution<std::uint32_t> key(0, 15);
+    std::vector<std::pair<std::size_t, std::uint32_t>> queries(Q);
+    for (auto& q: queries) q = {node(gen), key(gen)};
+
+    while (state.KeepRunning()) {
+        float s = 0;
+        for (const auto& q: queries) s += store.get(q.first, q.second);
+        benchmark::DoNotOptimize(s);
+    }
+    state.SetItemsProcessed(state.iterations()*Q);
+}
+
+template <typename Store>
+void register_benches(const std::string& label) {
+    for (int m: {10000, 1000000}) {
+        benchmark::RegisterBenchmark((label+".restart").c_str(), bench_restart<Store>)->Arg(m);
+        benchmark::RegisterBenchmark((label+".lookup").c_str(), bench_lookup<Store>)->Arg(m);
+    }
+}
+
+int main(int argc, char** argv) {
+    register_benches<use_rebuild>("tinymap/rebuild");
+    register_benches<use_mmap>("tinymap/mmap");
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
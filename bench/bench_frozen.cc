@@ -0,0 +1,91 @@
+#include "little/compat.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "little/frozen.h"
+#include "little/map.h"
+
+using namespace hf;
+
+// Look up keys of a constant table of N entries: all hits, in random
+// order, as for keyword or opcode recognition.
+
+template <typename Key>
+Key make_key(int i);
+
+template <>
+int make_key<int>(int i) { return i*7919; }
+
+template <>
+std::string make_key<std::string>(int i) { return "kw_" + std::to_string(i*7919); }
+
+template <typename Key>
+std::vector<std::pair<Key, int>> make_entries(int N) {
+    std::vector<std::pair<Key, int>> entries;
+    for (int i = 0; i<N; ++i) entries.emplace_back(make_key<Key>(i), i);
+    return entries;
+}
+
+template <typename Map>
+void bench_lookup(benchmark::State& state) {
+    using Key = typename Map::key_type;
+    int N = state.range(0);
+    if (static_cast<std::size_t>(N)>Map().max_size()) {
+        state.SkipWithError("N exceeds capacity");
+        return;
+    }
+
+    auto entries = make_entries<Key>(N);
+    Map m(entries.begin(), entries.end());
+
+    std::vector<Key> queries;
+    for (int i = 0; i<1024; ++i) queries.push_back(entries[i%N].first);
+    std::shuffle(queries.begin(), queries.end(), std::minstd_rand{});
+
+    long sum = 0;
+    while (state.KeepRunning()) {
+        for (const auto& q: queries) sum += m.find(q)->second;
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations()*queries.size());
+}
+
+template <typename Map>
+void bench_build(benchmark::State& state) {
+    using Key = typename Map::key_type;
+    auto entries = make_entries<Key>(state.range(0));
+
+    while (state.KeepRunning()) {
+        Map m(entries.begin(), entries.end());
+        benchmark::DoNotOptimize(m.size());
+    }
+}
+
+template <typename Map>
+void register_benches(const std::string& label) {
+    auto sizes = [](benchmark::internal::Benchmark* b) { for (int n: {8, 16, 32, 64, 128, 256, 512}) b->Arg(n); };
+
+    benchmark::RegisterBenchmark((label+".lookup").c_str(), bench_lookup<Map>)->Apply(sizes);
+    benchmark::RegisterBenchmark((label+".build").c_str(), bench_build<Map>)->Apply(sizes);
+}
+
+int main(int argc, char** argv) {
+    register_benches<tiny::frozen_map<int, int, 512>>("frozen_map/int");
+    register_benches<tiny::map<int, int, 512>>("tinymap/int");
+    register_benches<std::unordered_map<int, int>>("unordered_map/int");
+
+    register_benches<tiny::frozen_map<std::string, int, 512>>("frozen_map/string");
+    register_benches<tiny::map<std::string, int, 512>>("tinymap/string");
+    register_benches<tiny::map<std::string, int, 512, hash_tagged<std::string>>>("tinymap/string/tagged");
+    register_benches<std::unordered_map<std::string, int>>("unordered_map/string");
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
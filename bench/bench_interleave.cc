@@ -0,0 +1,111 @@
+#include "little/compat.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "little/interleave.h"
+#include "little/map.h"
+
+using namespace hf;
+
+// Shards of small::map<int, int>, each holding 8 entries with keys drawn
+// from [0,16), enough of them that objects and heap storage together
+// span the working set given as the benchmark argument in MiB. Storage
+// is allocated in a shuffled shard order, so that neither is laid out
+// in query order. Each iteration answers a batch of 4096 lookups of a
+// random key in a random shard, one at a time or interleaved with
+// prefetch group size G.
+
+typedef small::map<int, int> map_type;
+typedef std::pair<const map_type*, int> query;
+
+constexpr std::size_t Q = 4096;
+constexpr std::size_t entries = 8;
+
+struct shards {
+    std::vector<map_type> maps;
+    std::vector<query> queries;
+
+    explicit shards(std::size_t mib) {
+        // object, entries and allocator overhead
+        std::size_t per_map = sizeof(map_type)+entries*sizeof(map_type::value_type)+16;
+        std::size_t n = (mib<<20)/per_map;
+
+        std::minstd_rand gen;
+        maps.resize(n);
+        std::vector<std::size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), gen);
+
+        std::uniform_int_distribution<int> key(0, 15);
+        for (std::size_t i: order) {
+            map_type& m = maps[i];
+            while (m.size()<entries) m[key(gen)] = int(i);
+        }
+
+        std::uniform_int_distribution<std::size_t> which(0, n-1);
+        queries.resize(Q);
+        for (auto& q: queries) q = query(&maps[which(gen)], key(gen));
+    }
+};
+
+const shards& instance(std::size_t mib) {
+    static std::size_t loaded = 0;
+    static shards* s = nullptr;
+    if (loaded!=mib) {
+        delete s;
+        s = new shards(mib);
+        loaded = mib;
+    }
+    return *s;
+}
+
+void bench_one_at_a_time(benchmark::State& state) {
+    const shards& s = instance(state.range(0));
+
+    while (state.KeepRunning()) {
+        long sum = 0;
+        for (const auto& q: s.queries) {
+            const int* v = q.first->get_ptr(q.second);
+            sum += v? *v: 0;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*Q);
+}
+
+template <std::size_t G>
+void bench_interleaved(benchmark::State& state) {
+    const shards& s = instance(state.range(0));
+
+    while (state.KeepRunning()) {
+        long sum = 0;
+        for_each_interleaved<G>(s.queries.begin(), s.queries.end(), [&](const map_type& m, int k) {
+            const int* v = m.get_ptr(k);
+            sum += v? *v: 0;
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*Q);
+}
+
+void working_sets(benchmark::internal::Benchmark* b) {
+    for (int mib: {1, 1024}) b->Arg(mib);
+}
+
+int main(int argc, char** argv) {
+    benchmark::RegisterBenchmark("smallmap/one_at_a_time", bench_one_at_a_time)->Apply(working_sets);
+    benchmark::RegisterBenchmark("smallmap/interleaved/G=2", bench_interleaved<2>)->Apply(working_sets);
+    benchmark::RegisterBenchmark("smallmap/interleaved/G=4", bench_interleaved<4>)->Apply(working_sets);
+    benchmark::RegisterBenchmark("smallmap/interleaved/G=8", bench_interleaved<8>)->Apply(working_sets);
+    benchmark::RegisterBenchmark("smallmap/interleaved/G=16", bench_interleaved<16>)->Apply(working_sets);
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,458 @@
+#include "little/compat.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "little/map.h"
+
+using namespace hf;
+
+// Count heap allocations, to check lookups with heterogeneous keys
+// do not construct temporary key_type objects.
+//
+// Every form of the global operator new and delete is replaced, and
+// none are inlined: GCC otherwise pairs an inlined free() with a call
+// to operator new and warns of a mismatched deallocation.
+
+static std::size_t g_alloc_count = 0;
+
+#define NOINLINE __attribute__((noinline))
+
+NOINLINE void* operator new(std::size_t n) {
+    ++g_alloc_count;
+    if (void* p = std::malloc(n? n: 1)) return p;
+    throw std::bad_alloc();
+}
+
+NOINLINE void* operator new[](std::size_t n) { return operator new(n); }
+
+NOINLINE void operator delete(void* p) noexcept { std::free(p); }
+NOINLINE void operator delete[](void* p) noexcept { operator delete(p); }
+NOINLINE void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+NOINLINE void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+
+// Transparent string equality and hash, accepting std::string or C strings.
+
+struct string_equal {
+    using is_transparent = void;
+
+    static const char* c_str(const std::string& s) { return s.c_str(); }
+    static const char* c_str(const char* s) { return s; }
+
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const { return std::strcmp(c_str(a), c_str(b))==0; }
+};
+
+struct string_hash {
+    using is_transparent = void;
+
+    // FNV-1a
+    template <typename S>
+    std::size_t operator()(const S& s) const {
+        std::uint64_t h = 0xcbf29ce484222325ull;
+        for (const char* p = string_equal::c_str(s); *p; ++p) h = (h^static_cast<unsigned char>(*p))*0x100000001b3ull;
+        return static_cast<std::size_t>(h);
+    }
+};
+
+// Random keys of fixed length sharing a common prefix, so that
+// comparisons of non-matching keys are not trivially short.
+
+template <typename Gen>
+std::vector<std::string> random_string_keys(Gen& gen, std::size_t count, std::size_t length) {
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::vector<std::string> keys;
+
+    while (keys.size()<count) {
+        std::string k(length, 'k');
+        for (std::size_t i = length/2; i<length; ++i) k[i] = static_cast<char>(letter(gen));
+        if (std::find(keys.begin(), keys.end(), k)==keys.end()) keys.push_back(k);
+    }
+    return keys;
+}
+
+// Look up every key in the map (hit) or none of them (miss).
+
+template <typename Map, bool hit>
+void bench_string_find(benchmark::State& state) {
+    using Gen = std::minstd_rand;
+    Gen gen;
+
+    std::size_t N = state.range(0);
+    std::size_t length = state.range(1);
+
+    auto keys = random_string_keys(gen, 2*N, length);
+
+    Map m;
+    for (std::size_t i = 0; i<N; ++i) m[keys[i]] = i;
+
+    std::vector<std::string> queries(hit? keys.begin(): keys.begin()+N, hit? keys.begin()+N: keys.end());
+    std::shuffle(queries.begin(), queries.end(), gen);
+
+    while (state.KeepRunning()) {
+        for (const auto& q: queries) {
+            benchmark::DoNotOptimize(m.find(q));
+        }
+    }
+
+    for (const auto& q: queries) {
+        if ((m.find(q)!=m.end())!=hit) throw std::runtime_error("map lookup mismatch");
+    }
+}
+
+// Look up C string keys: with a non-transparent KeyEqual, each query
+// constructs a temporary std::string (and allocates, if the key is too
+// long for the small string optimisation).
+
+template <typename Map>
+void bench_cstring_find(benchmark::State& state) {
+    using Gen = std::minstd_rand;
+    Gen gen;
+
+    std::size_t N = state.range(0);
+    std::size_t length = state.range(1);
+
+    auto keys = random_string_keys(gen, N, length);
+
+    Map m;
+    for (std::size_t i = 0; i<N; ++i) m[keys[i]] = i;
+
+    std::vector<const char*> queries;
+    for (const auto& k: keys) queries.push_back(k.c_str());
+    std::shuffle(queries.begin(), queries.end(), gen);
+
+    std::size_t n_lookup = 0;
+    std::size_t n_alloc = g_alloc_count;
+    while (state.KeepRunning()) {
+        for (const char* q: queries) {
+            benchmark::DoNotOptimize(m.find(q));
+        }
+        n_lookup += queries.size();
+    }
+    n_alloc = g_alloc_count-n_alloc;
+
+    state.counters["allocs_per_lookup"] = n_lookup? double(n_alloc)/n_lookup: 0.;
+}
+
+// Instrumented heavyweight mapped value, counting constructions and
+// copies (including copy and move assignment).
+
+struct counted_value {
+    static std::size_t n_ctor, n_copy;
+
+    counted_value() { ++n_ctor; }
+    explicit counted_value(int x) { ++n_ctor; payload[0] = x; }
+    counted_value(const counted_value& other): payload(other.payload) { ++n_ctor; ++n_copy; }
+    counted_value(counted_value&& other): payload(other.payload) { ++n_ctor; ++n_copy; }
+
+    counted_value& operator=(const counted_value& other) { payload = other.payload; ++n_copy; return *this; }
+    counted_value& operator=(counted_value&& other) { payload = other.payload; ++n_copy; return *this; }
+
+    std::array<double, 32> payload;
+};
+
+std::size_t counted_value::n_ctor = 0;
+std::size_t counted_value::n_copy = 0;
+
+// Insert operations under test: each inserts key k with a value built
+// from k if k is absent.
+
+struct op_emplace {
+    template <typename Map>
+    static void run(Map& m, int k) { m.emplace(k, counted_value(k)); }
+};
+
+struct op_insert {
+    template <typename Map>
+    static void run(Map& m, int k) { m.insert(typename Map::value_type(k, counted_value(k))); }
+};
+
+struct op_try_emplace {
+    template <typename Map>
+    static void run(Map& m, int k) { m.try_emplace(k, k); }
+};
+
+struct op_insert_or_assign {
+    template <typename Map>
+    static void run(Map& m, int k) { m.insert_or_assign(k, counted_value(k)); }
+};
+
+// Repeatedly insert keys that are (almost all) already present.
+
+template <typename Map, typename Op>
+void bench_duplicate_insert(benchmark::State& state) {
+    std::size_t N = state.range(0);
+
+    Map m;
+    for (std::size_t i = 0; i<N; ++i) m.try_emplace(static_cast<int>(i), static_cast<int>(i));
+
+    std::vector<int> keys(N);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::minstd_rand{});
+
+    std::size_t n_op = 0;
+    counted_value::n_ctor = counted_value::n_copy = 0;
+    while (state.KeepRunning()) {
+        for (int k: keys) Op::run(m, k);
+        benchmark::ClobberMemory();
+        n_op += keys.size();
+    }
+
+    state.counters["ctors_per_op"] = n_op? double(counted_value::n_ctor)/n_op: 0.;
+    state.counters["copies_per_op"] = n_op? double(counted_value::n_copy)/n_op: 0.;
+}
+
+// Zipf-distributed keys in [0, universe) with exponent s.
+
+template <typename Gen>
+std::vector<int> zipf_keys(Gen& gen, std::size_t count, int universe, double s) {
+    std::vector<double> cdf(universe);
+    double total = 0;
+    for (int k = 0; k<universe; ++k) cdf[k] = total += 1.0/std::pow(k+1, s);
+
+    std::uniform_real_distribution<double> U(0, total);
+    std::vector<int> keys(count);
+    for (auto& k: keys) k = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), U(gen))-cdf.begin());
+
+    // decorrelate popularity from insertion order
+    std::vector<int> perm(universe);
+    std::iota(perm.begin(), perm.end(), 0);
+    std::shuffle(perm.begin(), perm.end(), gen);
+    for (auto& k: keys) k = perm[k];
+    return keys;
+}
+
+// Look up every key of a map of N keys with Zipf-distributed frequency;
+// with a self-organising access policy, the map reorders as it goes.
+
+template <typename Map>
+void bench_zipf_find(benchmark::State& state) {
+    std::minstd_rand gen;
+    int N = state.range(0);
+    auto keys = zipf_keys(gen, 1<<14, N, state.range(1)/100.);
+
+    Map m;
+    for (int i = 0; i<N; ++i) m.try_emplace(i, i);
+
+    std::int64_t sum = 0;
+    while (state.KeepRunning()) {
+        for (int k: keys) sum += m.find(k)->second;
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations()*keys.size());
+}
+
+// Counter-increment operations under test: each adds one to the count
+// for key k, starting the count at 1 if k is absent.
+
+struct op_find_bracket {
+    template <typename Map, typename K>
+    static void run(Map& m, const K& k) {
+        auto i = m.find(k);
+        if (i!=m.end()) m[k] = i->second+1;
+        else m[k] = 1;
+    }
+};
+
+struct op_bracket {
+    template <typename Map, typename K>
+    static void run(Map& m, const K& k) { ++m[k]; }
+};
+
+struct op_get_ptr {
+    template <typename Map, typename K>
+    static void run(Map& m, const K& k) {
+        if (auto p = m.get_ptr(k)) ++*p;
+        else m.try_emplace(k, 1);
+    }
+};
+
+struct op_upsert {
+    template <typename Map, typename K>
+    static void run(Map& m, const K& k) { m.upsert(k, 1, [](int& c) { ++c; }); }
+};
+
+// Count occurrences of Zipf-distributed keys drawn from N distinct
+// strings, starting from an empty map each iteration.
+
+template <typename Map, typename Op>
+void bench_counter(benchmark::State& state) {
+    std::minstd_rand gen;
+    int N = state.range(0);
+    auto words = random_string_keys(gen, N, 16);
+    auto indices = zipf_keys(gen, 1<<12, N, 1.0);
+
+    std::vector<std::string> keys;
+    for (int i: indices) keys.push_back(words[i]);
+
+    Map m;
+    while (state.KeepRunning()) {
+        m.clear();
+        for (const auto& k: keys) Op::run(m, k);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations()*keys.size());
+
+    int total = 0;
+    for (const auto& e: m) total += e.second;
+    if (total!=static_cast<int>(keys.size())) throw std::runtime_error("counter mismatch");
+}
+
+// Build a map from N entries with about N/8 repeated keys, either one
+// entry at a time or with the bulk range insertion.
+
+template <typename Key>
+Key make_key(int i) { return i; }
+
+template <>
+std::string make_key<std::string>(int i) { return "config.key." + std::to_string(i); }
+
+template <typename Map>
+std::vector<typename Map::value_type> build_entries(std::size_t N) {
+    std::minstd_rand gen;
+    std::uniform_int_distribution<int> U(0, static_cast<int>(N+N/8));
+
+    std::vector<typename Map::value_type> entries;
+    for (std::size_t i = 0; i<N; ++i) entries.emplace_back(make_key<typename Map::key_type>(U(gen)), static_cast<int>(i));
+    return entries;
+}
+
+template <typename Map>
+void bench_build_elementwise(benchmark::State& state) {
+    auto entries = build_entries<Map>(state.range(0));
+
+    while (state.KeepRunning()) {
+        Map m;
+        for (const auto& e: entries) m.insert(e);
+        benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations()*entries.size());
+}
+
+template <typename Map>
+void bench_build_bulk(benchmark::State& state) {
+    auto entries = build_entries<Map>(state.range(0));
+
+    while (state.KeepRunning()) {
+        Map m(entries.begin(), entries.end());
+        benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations()*entries.size());
+}
+
+template <typename Map>
+void string_key_args(benchmark::internal::Benchmark* b) {
+    for (int n: {4, 8, 16, 32, 64}) {
+        for (int len: {8, 16, 32, 64}) {
+            if (n<=static_cast<int>(Map().max_size())) b->Args({n, len});
+        }
+    }
+}
+
+// Benchmark registration...
+
+template <typename Map>
+void register_string_find(const std::string& label) {
+    benchmark::RegisterBenchmark((label+".find_hit").c_str(), bench_string_find<Map, true>)->Apply(string_key_args<Map>);
+    benchmark::RegisterBenchmark((label+".find_miss").c_str(), bench_string_find<Map, false>)->Apply(string_key_args<Map>);
+}
+
+template <typename Map>
+void register_cstring_find(const std::string& label) {
+    benchmark::RegisterBenchmark((label+".find_cstring").c_str(), bench_cstring_find<Map>)->Apply(string_key_args<Map>);
+}
+
+template <typename Map>
+void register_duplicate_insert(const std::string& label) {
+    auto sizes = [](benchmark::internal::Benchmark* b) { for (int n: {4, 16, 64}) b->Arg(n); };
+
+    benchmark::RegisterBenchmark((label+".emplace").c_str(), bench_duplicate_insert<Map, op_emplace>)->Apply(sizes);
+    benchmark::RegisterBenchmark((label+".insert").c_str(), bench_duplicate_insert<Map, op_insert>)->Apply(sizes);
+    benchmark::RegisterBenchmark((label+".try_emplace").c_str(), bench_duplicate_insert<Map, op_try_emplace>)->Apply(sizes);
+    benchmark::RegisterBenchmark((label+".insert_or_assign").c_str(), bench_duplicate_insert<Map, op_insert_or_assign>)->Apply(sizes);
+}
+
+template <typename Map>
+void register_zipf_find(const std::string& label) {
+    auto args = [](benchmark::internal::Benchmark* b) {
+        for (int n: {8, 16, 32, 64}) for (int s: {80, 100, 120}) b->Args({n, s});
+    };
+
+    benchmark::RegisterBenchmark((label+".zipf_find").c_str(), bench_zipf_find<Map>)->Apply(args);
+}
+
+template <typename Map>
+void register_counter(const std::string& label) {
+    auto sizes = [](benchmark::internal::Benchmark* b) { for (int n: {8, 16, 32, 64}) b->Arg(n); };
+
+    benchmark::RegisterBenchmark((label+".counter_find_bracket").c_str(), bench_counter<Map, op_find_bracket>)->Apply(sizes);
+    benchmark::RegisterBenchmark((label+".counter_bracket").c_str(), bench_counter<Map, op_bracket>)->Apply(sizes);
+    benchmark::RegisterBenchmark((label+".counter_get_ptr").c_str(), bench_counter<Map, op_get_ptr>)->Apply(sizes);
+    benchmark::RegisterBenchmark((label+".counter_upsert").c_str(), bench_counter<Map, op_upsert>)->Apply(sizes);
+}
+
+template <typename Map>
+void register_build(const std::string& label, int max_elementwise, int max_bulk) {
+    auto elementwise = benchmark::RegisterBenchmark((label+".build_elementwise").c_str(), bench_build_elementwise<Map>);
+    auto bulk = benchmark::RegisterBenchmark((label+".build_bulk").c_str(), bench_build_bulk<Map>);
+
+    for (int n: {16, 64, 256, 1024, 4096, 16384, 100000}) {
+        if (n<=max_elementwise) elementwise->Arg(n);
+        if (n<=max_bulk) bulk->Arg(n);
+    }
+}
+
+int main(int argc, char** argv) {
+    using tagged = hash_tagged<std::string>;
+    using transparent_tagged = hash_tagged<std::string, string_hash, string_equal>;
+
+    register_string_find<tiny::map<std::string, int, 64>>("tinymap/string");
+    register_string_find<tiny::map<std::string, int, 64, tagged>>("tinymap/string/tagged");
+    register_string_find<small::map<std::string, int>>("smallmap/string");
+    register_string_find<small::map<std::string, int, tagged>>("smallmap/string/tagged");
+
+    register_cstring_find<tiny::map<std::string, int, 64>>("tinymap/string");
+    register_cstring_find<tiny::map<std::string, int, 64, string_equal>>("tinymap/string/transparent");
+    register_cstring_find<tiny::map<std::string, int, 64, transparent_tagged>>("tinymap/string/transparent_tagged");
+    register_cstring_find<small::map<std::string, int>>("smallmap/string");
+    register_cstring_find<small::map<std::string, int, string_equal>>("smallmap/string/transparent");
+    register_cstring_find<small::map<std::string, int, transparent_tagged>>("smallmap/string/transparent_tagged");
+
+    register_duplicate_insert<tiny::map<int, counted_value, 64>>("tinymap/counted");
+    register_duplicate_insert<small::map<int, counted_value>>("smallmap/counted");
+
+    using std_eq = std::equal_to<int>;
+    using alloc = std::allocator<std::pair<int, int>>;
+
+    register_zipf_find<tiny::map<int, int, 64>>("tinymap/int/static_order");
+    register_zipf_find<tiny::map<int, int, 64, std_eq, unchecked_overflow, move_to_front>>("tinymap/int/move_to_front");
+    register_zipf_find<tiny::map<int, int, 64, std_eq, unchecked_overflow, transpose>>("tinymap/int/transpose");
+    register_zipf_find<small::map<int, int>>("smallmap/int/static_order");
+    register_zipf_find<small::map<int, int, std_eq, alloc, stable_erase, move_to_front>>("smallmap/int/move_to_front");
+    register_zipf_find<small::map<int, int, std_eq, alloc, stable_erase, transpose>>("smallmap/int/transpose");
+
+    register_counter<tiny::map<std::string, int, 64>>("tinymap/string");
+    register_counter<tiny::map<std::string, int, 64, tagged>>("tinymap/string/tagged");
+    register_counter<small::map<std::string, int>>("smallmap/string");
+    register_counter<small::map<std::string, int, tagged>>("smallmap/string/tagged");
+
+    register_build<tiny::map<int, int, 256>>("tinymap/int", 256, 256);
+    register_build<small::map<int, int>>("smallmap/int", 4096, 100000);
+    register_build<small::map<std::string, int>>("smallmap/string", 4096, 100000);
+    register_build<small::map<std::string, int, tagged>>("smallmap/string/tagged", 4096, 100000);
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
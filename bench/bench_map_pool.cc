@@ -0,0 +1,132 @@
+#include "little/compat.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "little/map.h"
+#include "little/map_pool.h"
+
+using namespace hf;
+
+// Per-node maps of up to 8 int to V entries for M graph nodes, each
+// holding between 0 and 8 entries with keys drawn from [0,16). Lookups
+// are of a random key at a random node; visits sum every value.
+
+constexpr std::size_t N = 8;
+
+template <typename V>
+struct use_vector {
+    std::vector<tiny::map<int, V, N>> maps;
+
+    explicit use_vector(std::size_t M): maps(M) {}
+
+    void set(std::size_t h, int k, V v) { maps[h][k] = v; }
+    std::size_t size(std::size_t h) const { return maps[h].size(); }
+
+    V get(std::size_t h, int k) const {
+        auto i = maps[h].find(k);
+        return i==maps[h].end()? V(0): i->second;
+    }
+
+    V sum() const {
+        V s = 0;
+        for (const auto& m: maps) for (const auto& e: m) s += e.second;
+        return s;
+    }
+
+    std::size_t bytes() const { return maps.capacity()*sizeof(maps[0]); }
+};
+
+template <typename V>
+struct use_pool {
+    tiny::map_pool<int, V, N> pool;
+
+    explicit use_pool(std::size_t M): pool(M) {}
+
+    void set(std::size_t h, int k, V v) { pool[h][k] = v; }
+    std::size_t size(std::size_t h) const { return pool[h].size(); }
+
+    V get(std::size_t h, int k) const {
+        const V* v = pool[h].get_ptr(k);
+        return v? *v: V(0);
+    }
+
+    V sum() const {
+        V s = 0;
+        pool.for_each([&](std::size_t, int, V v) { s += v; });
+        return s;
+    }
+
+    std::size_t bytes() const { return pool.memory_usage(); }
+};
+
+template <typename Store>
+void fill(Store& store, std::size_t M, std::minstd_rand& gen) {
+    std::uniform_int_distribution<int> key(0, 15);
+    std::uniform_int_distribution<int> fill_to(0, N);
+    for (std::size_t h = 0; h<M; ++h) {
+        std::size_t n = fill_to(gen);
+        while (store.size(h)<n) store.set(h, key(gen), h);
+    }
+}
+
+template <typename Store>
+void bench_lookup(benchmark::State& state) {
+    std::size_t M = state.range(0);
+    std::minstd_rand gen;
+
+    Store store(M);
+    fill(store, M, gen);
+
+    constexpr std::size_t Q = 4096;
+    std::uniform_int_distribution<std::size_t> node(0, M-1);
+    std::uniform_int_distribution<int> key(0, 15);
+    std::vector<std::pair<std::size_t, int>> queries(Q);
+    for (auto& q: queries) q = {node(gen), key(gen)};
+
+    while (state.KeepRunning()) {
+        decltype(store.get(0, 0)) s = 0;
+        for (const auto& q: queries) s += store.get(q.first, q.second);
+        benchmark::DoNotOptimize(s);
+    }
+
+    state.SetItemsProcessed(state.iterations()*Q);
+    state.counters["bytes_per_node"] = double(store.bytes())/M;
+}
+
+template <typename Store>
+void bench_visit(benchmark::State& state) {
+    std::size_t M = state.range(0);
+    std::minstd_rand gen;
+
+    Store store(M);
+    fill(store, M, gen);
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(store.sum());
+    }
+
+    state.SetItemsProcessed(state.iterations()*M);
+    state.counters["bytes_per_node"] = double(store.bytes())/M;
+}
+
+template <typename Store>
+void register_benches(const std::string& label) {
+    for (int m: {10000, 1000000, 10000000}) {
+        benchmark::RegisterBenchmark((label+".lookup").c_str(), bench_lookup<Store>)->Arg(m);
+        benchmark::RegisterBenchmark((label+".visit").c_str(), bench_visit<Store>)->Arg(m);
+    }
+}
+
+int main(int argc, char** argv) {
+    register_benches<use_vector<float>>("tinymap/vector/float");
+    register_benches<use_pool<float>>("tinymap/map_pool/float");
+    register_benches<use_vector<double>>("tinymap/vector/double");
+    register_benches<use_pool<double>>("tinymap/map_pool/double");
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
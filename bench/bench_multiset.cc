@@ -1,10 +1,14 @@
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <random>
 #include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 #include "benchmark/benchmark.h"
+#include "little/counted_multiset.h"
 #include "little/multiset.h"
 
 using namespace hf;
@@ -64,6 +68,347 @@ void bench_count(benchmark::State& state) {
     }
 }
 
+// Count Q query keys in a multiset of N elements, either one
+// query at a time or with a single count_many call.
+
+template <typename MSet, bool batched>
+void bench_count_queries(benchmark::State& state) {
+    using value_type = typename MSet::value_type;
+
+    std::minstd_rand gen;
+
+    std::size_t N = state.range(0);
+    std::size_t Q = state.range(1);
+
+    MSet mset;
+    std::uniform_int_distribution<int> key(0, 2*N);
+    for (std::size_t j = 0; j<N; ++j) mset.insert(static_cast<value_type>(key(gen)));
+
+    std::vector<value_type> queries(Q);
+    std::generate(queries.begin(), queries.end(), [&]() { return static_cast<value_type>(key(gen)); });
+
+    std::vector<std::size_t> counts(Q);
+    while (state.KeepRunning()) {
+        if (batched) {
+            mset.count_many(queries.begin(), queries.end(), counts.begin());
+        }
+        else {
+            for (std::size_t j = 0; j<Q; ++j) counts[j] = mset.count(queries[j]);
+        }
+        benchmark::DoNotOptimize(counts.data());
+        benchmark::ClobberMemory();
+    }
+
+    for (std::size_t j = 0; j<Q; ++j) {
+        if (counts[j]!=mset.count(queries[j])) throw std::runtime_error("multiset counts do not match");
+    }
+}
+
+template <typename MSet>
+void register_count_queries(const std::string& label) {
+    auto args = [](benchmark::internal::Benchmark* b) {
+        for (int n: {4, 8, 16, 32, 64}) for (int q: {4, 16, 64}) b->Args({n, q});
+    };
+
+    benchmark::RegisterBenchmark((label+".count").c_str(), bench_count_queries<MSet, false>)->Apply(args);
+    benchmark::RegisterBenchmark((label+".count_many").c_str(), bench_count_queries<MSet, true>)->Apply(args);
+}
+
+// Remove half of the elements of a multiset, by key or by predicate.
+
+struct erase_key_loop {
+    // element-at-a-time removal via find and erase(pos)
+    template <typename MSet>
+    static std::size_t run(MSet& mset) {
+        std::size_t n = 0;
+        for (auto i = mset.find(0); i!=mset.end(); i = mset.find(0)) mset.erase(i), ++n;
+        return n;
+    }
+};
+
+struct erase_key {
+    template <typename MSet>
+    static std::size_t run(MSet& mset) { return mset.erase(0); }
+};
+
+struct erase_pred {
+    template <typename MSet>
+    static std::size_t run(MSet& mset) {
+        using value_type = typename MSet::value_type;
+        return erase_if(mset, [](const value_type& x) { return x==0; });
+    }
+};
+
+template <typename MSet, typename Op>
+void bench_erase_half(benchmark::State& state) {
+    std::size_t N = state.range(0);
+
+    std::minstd_rand gen;
+    std::bernoulli_distribution coin;
+
+    MSet initial;
+    for (std::size_t i = 0; i<N; ++i) initial.insert(coin(gen)? 0: static_cast<int>(i));
+    std::size_t expected = initial.count(0);
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        MSet mset(initial);
+        state.ResumeTiming();
+
+        std::size_t n = Op::run(mset);
+        benchmark::DoNotOptimize(n);
+
+        state.PauseTiming();
+        if (n!=expected) throw std::runtime_error("erased count mismatch");
+        state.ResumeTiming();
+    }
+}
+
+template <typename MSet>
+void register_erase_benches(const std::string& label) {
+    benchmark::RegisterBenchmark((label+".erase_loop").c_str(), bench_erase_half<MSet, erase_key_loop>)->Arg(1000);
+    benchmark::RegisterBenchmark((label+".erase_key").c_str(), bench_erase_half<MSet, erase_key>)->Arg(1000);
+    benchmark::RegisterBenchmark((label+".erase_if").c_str(), bench_erase_half<MSet, erase_pred>)->Arg(1000);
+}
+
+// Compare two multisets holding the same elements in different orders.
+// A custom (but equivalent) equality functor forces the quadratic
+// comparison, for reference against the sorted comparison.
+
+struct int_equal {
+    bool operator()(int a, int b) const { return a==b; }
+};
+
+template <typename MSet>
+void bench_equality(benchmark::State& state) {
+    std::size_t N = state.range(0);
+
+    std::minstd_rand gen;
+    std::uniform_int_distribution<int> dist(0, static_cast<int>(N));
+
+    std::vector<int> values(N);
+    for (auto& v: values) v = dist(gen);
+
+    MSet a(values.begin(), values.end());
+    std::shuffle(values.begin(), values.end(), gen);
+    MSet b(values.begin(), values.end());
+
+    while (state.KeepRunning()) {
+        bool eq = a==b;
+        benchmark::DoNotOptimize(eq);
+        if (!eq) throw std::runtime_error("equality mismatch");
+    }
+}
+
+template <typename MSet>
+void register_equality_benches(const std::string& label) {
+    benchmark::RegisterBenchmark((label+".equality").c_str(), bench_equality<MSet>)->RangeMultiplier(2)->Range(8, 1024);
+}
+
+// Allocator recording the number of bytes currently allocated through
+// it (for any value type).
+
+static std::size_t g_live_bytes = 0;
+
+template <typename T>
+struct tracking_allocator: std::allocator<T> {
+    template <typename U> struct rebind { using other = tracking_allocator<U>; };
+
+    tracking_allocator() = default;
+    template <typename U>
+    tracking_allocator(const tracking_allocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        g_live_bytes += n*sizeof(T);
+        return std::allocator<T>::allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        g_live_bytes -= n*sizeof(T);
+        std::allocator<T>::deallocate(p, n);
+    }
+};
+
+// Count queries against a multiset of K distinct keys, each present
+// D times, reporting the storage used.
+
+template <typename MSet>
+void bench_duplicate_count(benchmark::State& state) {
+    std::size_t K = state.range(0);
+    std::size_t D = state.range(1);
+
+    std::vector<int> values;
+    for (std::size_t d = 0; d<D; ++d) {
+        for (std::size_t k = 0; k<K; ++k) values.push_back(static_cast<int>(k));
+    }
+    std::shuffle(values.begin(), values.end(), std::minstd_rand{});
+
+    std::size_t bytes = g_live_bytes;
+    MSet mset;
+    for (int v: values) mset.insert(v);
+    bytes = g_live_bytes-bytes;
+
+    int k = 0;
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(mset.count(k));
+        k = (k+1)%static_cast<int>(K);
+    }
+
+    if (mset.count(0)!=D) throw std::runtime_error("count mismatch");
+    state.counters["bytes"] = bytes;
+}
+
+template <typename MSet>
+void register_duplicate_count(const std::string& label) {
+    auto args = [](benchmark::internal::Benchmark* b) {
+        for (int k: {4, 16}) for (int d: {1, 10, 100, 1000, 10000}) b->Args({k, d});
+    };
+
+    benchmark::RegisterBenchmark((label+".duplicate_count").c_str(), bench_duplicate_count<MSet>)->Apply(args);
+}
+
+// Fill a tiny multiset to capacity under each overflow policy, or with
+// an explicit size check around each insertion as user code would.
+
+struct insert_plain {
+    template <typename MSet>
+    static void run(MSet& mset, int x) { mset.insert(x); }
+};
+
+struct insert_size_checked {
+    template <typename MSet>
+    static void run(MSet& mset, int x) {
+        if (mset.size()<mset.max_size()) mset.insert(x);
+        else throw std::length_error("full");
+    }
+};
+
+struct insert_try {
+    template <typename MSet>
+    static void run(MSet& mset, int x) { benchmark::DoNotOptimize(mset.try_insert(x).second); }
+};
+
+template <typename MSet, typename Op>
+void bench_fill(benchmark::State& state) {
+    std::size_t N = state.range(0);
+    std::size_t n_insert = state.range(1);
+
+    MSet mset;
+    while (state.KeepRunning()) {
+        mset.clear();
+        for (std::size_t i = 0; i<n_insert; ++i) Op::run(mset, static_cast<int>(i));
+        benchmark::ClobberMemory();
+    }
+
+    if (mset.size()!=std::min(N, n_insert)) throw std::runtime_error("fill size mismatch");
+}
+
+template <typename Policy>
+void register_fill(const std::string& label) {
+    using mset = tiny::multiset<int, 64, std::equal_to<int>, Policy>;
+    benchmark::RegisterBenchmark((label+".fill").c_str(), bench_fill<mset, insert_plain>)->Args({64, 64});
+}
+
+// Copy, move and swap a tiny multiset of capacity 256 holding n elements;
+// whole_copy copies the entire object, as a defaulted copy would.
+
+template <typename MSet>
+MSet make_filled(int n) {
+    MSet mset;
+    for (int i = 0; i<n; ++i) mset.insert(i);
+    return mset;
+}
+
+template <typename MSet>
+void bench_copy(benchmark::State& state) {
+    MSet a = make_filled<MSet>(state.range(0));
+    while (state.KeepRunning()) {
+        MSet b(a);
+        benchmark::DoNotOptimize(&b);
+        benchmark::ClobberMemory();
+    }
+}
+
+template <typename MSet>
+void bench_whole_copy(benchmark::State& state) {
+    MSet a = make_filled<MSet>(state.range(0));
+    typename std::aligned_storage<sizeof(MSet), alignof(MSet)>::type b;
+    while (state.KeepRunning()) {
+        std::memcpy(&b, &a, sizeof(MSet));
+        benchmark::DoNotOptimize(&b);
+        benchmark::ClobberMemory();
+    }
+}
+
+template <typename MSet>
+void bench_move(benchmark::State& state) {
+    MSet a = make_filled<MSet>(state.range(0));
+    while (state.KeepRunning()) {
+        MSet b(std::move(a));
+        a = std::move(b);
+        benchmark::ClobberMemory();
+    }
+}
+
+template <typename MSet>
+void bench_swap(benchmark::State& state) {
+    MSet a = make_filled<MSet>(state.range(0)), b = make_filled<MSet>(state.range(0));
+    while (state.KeepRunning()) {
+        a.swap(b);
+        benchmark::ClobberMemory();
+    }
+}
+
+template <typename MSet>
+void register_copy_benches(const std::string& label) {
+    auto fills = [](benchmark::internal::Benchmark* b) { for (int n: {0, 3, 16, 64, 255, 256}) b->Arg(n); };
+
+    benchmark::RegisterBenchmark((label+".copy").c_str(), bench_copy<MSet>)->Apply(fills);
+    benchmark::RegisterBenchmark((label+".whole_copy").c_str(), bench_whole_copy<MSet>)->Apply(fills);
+    benchmark::RegisterBenchmark((label+".move").c_str(), bench_move<MSet>)->Apply(fills);
+    benchmark::RegisterBenchmark((label+".swap").c_str(), bench_swap<MSet>)->Apply(fills);
+}
+
+// Count a key in each of M tiny multisets stored contiguously, each
+// holding K small keys: with many multisets, time is dominated by memory
+// traffic and so by the per-multiset footprint, reported as "bytes".
+
+// equality carrying state, which cannot be elided from the layout
+struct eq_masked {
+    unsigned mask = ~0u;
+    bool operator()(unsigned a, unsigned b) const { return ((a^b)&mask)==0; }
+};
+
+template <typename MSet>
+void bench_footprint(benchmark::State& state) {
+    using value_type = typename MSet::value_type;
+
+    std::size_t M = state.range(0);
+    std::size_t K = state.range(1);
+
+    std::minstd_rand gen;
+    std::uniform_int_distribution<int> dist(0, 15);
+
+    std::vector<MSet> msets(M);
+    for (auto& m: msets) {
+        for (std::size_t j = 0; j<K; ++j) m.insert(static_cast<value_type>(dist(gen)));
+    }
+
+    while (state.KeepRunning()) {
+        std::size_t total = 0;
+        for (const auto& m: msets) total += m.count(static_cast<value_type>(3));
+        benchmark::DoNotOptimize(total);
+    }
+
+    state.SetItemsProcessed(state.iterations()*M);
+    state.counters["bytes"] = sizeof(MSet);
+}
+
+template <typename MSet>
+void register_footprint(const std::string& label) {
+    benchmark::RegisterBenchmark((label+".footprint").c_str(), bench_footprint<MSet>)->Args({1000, 4})->Args({1000000, 4});
+}
+
 // Type list chicanery... 
 
 template <typename V, V...>
@@ -141,6 +486,37 @@ int main(int argc,char** argv) {
     using sizes = intlist<2,3,4,5,6,7,8,9,10>;
     foreach_type<int, double>::run<register_benches, sizes>();
 
+    register_erase_benches<small::multiset<int>>("smallmultiset/stable");
+    register_erase_benches<small::multiset<int, std::equal_to<int>, std::allocator<int>, unordered_erase>>("smallmultiset/unordered");
+    register_erase_benches<tiny::multiset<int, 1000>>("tinymultiset");
+
+    register_count_queries<tiny::multiset<int, 64>>("tinymultiset/int");
+    register_count_queries<tiny::multiset<double, 64>>("tinymultiset/double");
+    register_count_queries<small::multiset<int>>("smallmultiset/int");
+
+    register_equality_benches<small::multiset<int>>("smallmultiset/sorted");
+    register_equality_benches<small::multiset<int, int_equal>>("smallmultiset/quadratic");
+    register_equality_benches<tiny::multiset<int, 1024>>("tinymultiset/sorted");
+    register_equality_benches<tiny::multiset<int, 1024, int_equal>>("tinymultiset/quadratic");
+
+    register_duplicate_count<small::multiset<int, std::equal_to<int>, tracking_allocator<int>>>("smallmultiset");
+    register_duplicate_count<small::counted_multiset<int, std::equal_to<int>, tracking_allocator<int>>>("smallcountedmultiset");
+
+    register_footprint<tiny::multiset<std::uint8_t, 6>>("tinymultiset/uint8_6");
+    register_footprint<tiny::multiset<std::uint8_t, 6, eq_masked>>("tinymultiset/uint8_6_stateful_eq");
+    register_footprint<tiny::multiset_fit<std::uint8_t, 16>>("tinymultiset/uint8_fit16");
+    register_footprint<tiny::multiset<int, 14>>("tinymultiset/int_14");
+
+    register_fill<unchecked_overflow>("tinymultiset/unchecked");
+    register_fill<assert_overflow>("tinymultiset/assert");
+    register_fill<throw_overflow>("tinymultiset/throw");
+    register_fill<fail_overflow>("tinymultiset/fail");
+    benchmark::RegisterBenchmark("tinymultiset/user_checked.fill", bench_fill<tiny::multiset<int, 64>, insert_size_checked>)->Args({64, 64});
+    benchmark::RegisterBenchmark("tinymultiset/try_insert.fill", bench_fill<tiny::multiset<int, 64>, insert_try>)->Args({64, 64});
+    benchmark::RegisterBenchmark("tinymultiset/evict_oldest.fill", bench_fill<tiny::multiset<int, 64, std::equal_to<int>, evict_oldest>, insert_plain>)->Args({64, 64})->Args({64, 128});
+
+    register_copy_benches<tiny::multiset<int, 256>>("tinymultiset/int256");
+
     benchmark::Initialize(&argc, argv);
     benchmark::RunSpecifiedBenchmarks();
 }
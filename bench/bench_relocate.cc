@@ -0,0 +1,101 @@
+#include "little/compat.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "benchmark/benchmark.h"
+#include "little/multiset.h"
+
+using namespace hf;
+
+// A unique_ptr that is not marked trivially relocatable, to measure the
+// element-wise move and destroy path on the same data.
+
+template <typename T>
+struct opaque_ptr: std::unique_ptr<T> {
+    using std::unique_ptr<T>::unique_ptr;
+};
+
+template <typename T>
+struct make_value;
+
+template <typename T>
+struct make_value<std::unique_ptr<T>> {
+    static std::unique_ptr<T> run(int i) { return std::unique_ptr<T>(new T(i)); }
+};
+
+template <typename T>
+struct make_value<opaque_ptr<T>> {
+    static opaque_ptr<T> run(int i) { return opaque_ptr<T>(new T(i)); }
+};
+
+template <>
+struct make_value<std::string> {
+    static std::string run(int i) { return std::to_string(i); }
+};
+
+template <typename MSet>
+MSet make_full(int n) {
+    MSet m;
+    for (int i = 0; i<n; ++i) m.insert(make_value<typename MSet::value_type>::run(i));
+    return m;
+}
+
+// Swap a multiset with one a quarter the size: elements beyond the
+// common prefix are relocated between the two.
+
+template <typename MSet>
+void bench_swap(benchmark::State& state) {
+    MSet a = make_full<MSet>(state.range(0)), b = make_full<MSet>(state.range(0)/4);
+    while (state.KeepRunning()) {
+        a.swap(b);
+        benchmark::ClobberMemory();
+    }
+}
+
+// Move a multiset back and forth between two containers.
+
+template <typename MSet>
+void bench_move(benchmark::State& state) {
+    MSet a = make_full<MSet>(state.range(0));
+    while (state.KeepRunning()) {
+        MSet b(std::move(a));
+        a = std::move(b);
+        benchmark::ClobberMemory();
+    }
+}
+
+// Erase from the front of a full multiset, refilling it untimed.
+
+template <typename MSet>
+void bench_erase(benchmark::State& state) {
+    int n = state.range(0);
+    MSet a = make_full<MSet>(n);
+    while (state.KeepRunning()) {
+        for (int i = 0; i<n; ++i) a.erase(a.begin());
+
+        state.PauseTiming();
+        a = make_full<MSet>(n);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations()*n);
+}
+
+template <typename MSet>
+void register_benches(const std::string& label) {
+    auto sizes = [](benchmark::internal::Benchmark* b) { for (int n: {8, 32, 128}) b->Arg(n); };
+
+    benchmark::RegisterBenchmark((label+".swap").c_str(), bench_swap<MSet>)->Apply(sizes);
+    benchmark::RegisterBenchmark((label+".move").c_str(), bench_move<MSet>)->Apply(sizes);
+    benchmark::RegisterBenchmark((label+".erase").c_str(), bench_erase<MSet>)->Apply(sizes);
+}
+
+int main(int argc, char** argv) {
+    register_benches<tiny::multiset<std::unique_ptr<int>, 128>>("tinymultiset/unique_ptr");
+    register_benches<tiny::multiset<opaque_ptr<int>, 128>>("tinymultiset/opaque_ptr");
+    register_benches<tiny::multiset<std::string, 128>>("tinymultiset/string");
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
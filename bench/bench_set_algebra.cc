@@ -0,0 +1,118 @@
+#include "little/compat.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "little/set_algebra.h"
+
+using namespace hf;
+
+// Random multiset contents with about half the keys in common between
+// two sets of the same size.
+
+template <typename Gen>
+std::vector<int> random_keys(Gen& gen, std::size_t n) {
+    std::uniform_int_distribution<int> dist(0, static_cast<int>(n));
+    std::vector<int> keys(n);
+    for (auto& k: keys) k = dist(gen);
+    return keys;
+}
+
+// Intersection size as user code would compute it with find: match each
+// element of a with an as-yet-unmatched equal element of b.
+
+template <typename MSet>
+std::size_t naive_intersection_size(const MSet& a, const MSet& b) {
+    std::vector<const int*> rest;
+    for (const auto& x: b) rest.push_back(&x);
+
+    std::size_t c = 0;
+    for (const auto& x: a) {
+        auto i = std::find_if(rest.begin(), rest.end(), [&](const int* y) { return *y==x; });
+        if (i!=rest.end()) {
+            *i = rest.back();
+            rest.pop_back();
+            ++c;
+        }
+    }
+    return c;
+}
+
+struct op_naive {
+    template <typename MSet>
+    static std::size_t run(const MSet& a, const MSet& b) { return naive_intersection_size(a, b); }
+};
+
+struct op_intersection_size {
+    template <typename MSet>
+    static std::size_t run(const MSet& a, const MSet& b) { return intersection_size(a, b); }
+};
+
+struct op_set_intersection {
+    template <typename MSet>
+    static std::size_t run(const MSet& a, const MSet& b) { return set_intersection(a, b).size(); }
+};
+
+// The two matching strategies, called directly for threshold tuning.
+
+struct op_pairwise {
+    template <typename MSet>
+    static std::size_t run(const MSet& a, const MSet& b) {
+        std::size_t c = 0;
+        impl::select_pairwise(&*a.begin(), a.size(), &*b.begin(), b.size(), std::equal_to<int>(), true, [&](int) { ++c; });
+        return c;
+    }
+};
+
+struct op_sorted {
+    template <typename MSet>
+    static std::size_t run(const MSet& a, const MSet& b) {
+        std::size_t c = 0;
+        impl::select_sorted(&*a.begin(), a.size(), &*b.begin(), b.size(), true, [&](int) { ++c; });
+        return c;
+    }
+};
+
+template <typename MSet, typename Op>
+void bench_intersect(benchmark::State& state) {
+    std::minstd_rand gen;
+    std::size_t N = state.range(0);
+    std::size_t M = state.range(1);
+
+    auto xs = random_keys(gen, N);
+    auto ys = random_keys(gen, M);
+    MSet a(xs.begin(), xs.end()), b(ys.begin(), ys.end());
+
+    std::size_t expected = naive_intersection_size(a, b);
+    while (state.KeepRunning()) {
+        std::size_t c = Op::run(a, b);
+        benchmark::DoNotOptimize(c);
+        if (c!=expected) throw std::runtime_error("intersection size mismatch");
+    }
+}
+
+template <typename MSet>
+void register_benches(const std::string& label) {
+    auto args = [](benchmark::internal::Benchmark* b) {
+        for (int n: {4, 16, 64, 256}) for (int m: {4, 16, 64, 256}) b->Args({n, m});
+    };
+
+    benchmark::RegisterBenchmark((label+".naive").c_str(), bench_intersect<MSet, op_naive>)->Apply(args);
+    benchmark::RegisterBenchmark((label+".intersection_size").c_str(), bench_intersect<MSet, op_intersection_size>)->Apply(args);
+    benchmark::RegisterBenchmark((label+".set_intersection").c_str(), bench_intersect<MSet, op_set_intersection>)->Apply(args);
+    benchmark::RegisterBenchmark((label+".pairwise").c_str(), bench_intersect<MSet, op_pairwise>)->Apply(args);
+    benchmark::RegisterBenchmark((label+".sorted").c_str(), bench_intersect<MSet, op_sorted>)->Apply(args);
+}
+
+int main(int argc, char** argv) {
+    register_benches<tiny::multiset<int, 256>>("tinymultiset/int");
+    register_benches<small::multiset<int>>("smallmultiset/int");
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,140 @@
+#include "little/compat.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "little/map.h"
+#include "little/shared_map.h"
+
+using namespace hf;
+
+// A routing table of K entries read by every reader thread, while a
+// background writer changes one entry every millisecond. Each reader
+// times individual lookups and reports the median and 99th percentile
+// latency in nanoseconds, averaged over threads.
+
+constexpr int K = 64;
+
+struct cow_table {
+    small::shared_map<int, int> m;
+
+    cow_table() {
+        m.update([](small::map<int, int>& x) { for (int k = 0; k<K; ++k) x[k] = k; });
+    }
+
+    int get(int k) const { return m.get_or(k, -1); }
+    void set(int k, int v) { m.insert_or_assign(k, v); }
+};
+
+// Reader-writer lock baseline; pthread_rwlock_t stands in for
+// std::shared_mutex, which requires C++17.
+struct rwlock_table {
+    mutable pthread_rwlock_t lock;
+    small::map<int, int> m;
+
+    rwlock_table() {
+        pthread_rwlock_init(&lock, nullptr);
+        for (int k = 0; k<K; ++k) m[k] = k;
+    }
+
+    ~rwlock_table() { pthread_rwlock_destroy(&lock); }
+
+    int get(int k) const {
+        pthread_rwlock_rdlock(&lock);
+        auto i = m.find(k);
+        int v = i==m.end()? -1: i->second;
+        pthread_rwlock_unlock(&lock);
+        return v;
+    }
+
+    void set(int k, int v) {
+        pthread_rwlock_wrlock(&lock);
+        m[k] = v;
+        pthread_rwlock_unlock(&lock);
+    }
+};
+
+template <typename Table>
+Table& instance() {
+    static Table t;
+    return t;
+}
+
+template <typename Table>
+struct background_writer {
+    std::atomic<bool> stop;
+    std::thread t;
+
+    background_writer(): stop(false) {
+        t = std::thread([this]() {
+            Table& table = instance<Table>();
+            for (int v = 0; !stop.load(); ++v) {
+                table.set(v%K, v);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+
+    ~background_writer() {
+        stop.store(true);
+        t.join();
+    }
+};
+
+template <typename Table>
+void bench_lookup_latency(benchmark::State& state) {
+    using clock = std::chrono::steady_clock;
+    static std::atomic<unsigned> seed(0);
+
+    const Table& table = instance<Table>();
+    std::minstd_rand gen(++seed);
+    std::uniform_int_distribution<int> key(0, K-1);
+
+    std::vector<double> ns;
+    ns.reserve(1<<20);
+
+    while (state.KeepRunning()) {
+        int k = key(gen);
+        auto t0 = clock::now();
+        benchmark::DoNotOptimize(table.get(k));
+        auto t1 = clock::now();
+        if (ns.size()<ns.capacity()) ns.push_back(std::chrono::duration<double, std::nano>(t1-t0).count());
+    }
+
+    if (!ns.empty()) {
+        std::size_t i50 = ns.size()/2, i99 = ns.size()*99/100;
+        std::nth_element(ns.begin(), ns.begin()+i50, ns.end());
+        double p50 = ns[i50];
+        std::nth_element(ns.begin(), ns.begin()+i99, ns.end());
+        double p99 = ns[i99];
+
+        state.counters["p50_ns"] = benchmark::Counter(p50, benchmark::Counter::kAvgThreads);
+        state.counters["p99_ns"] = benchmark::Counter(p99, benchmark::Counter::kAvgThreads);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Table>
+void register_benches(const std::string& label) {
+    instance<Table>();
+    benchmark::RegisterBenchmark((label+".lookup").c_str(), bench_lookup_latency<Table>)->ThreadRange(1, 16)->UseRealTime();
+}
+
+int main(int argc, char** argv) {
+    register_benches<cow_table>("smallmap/shared_map");
+    register_benches<rwlock_table>("smallmap/rwlock");
+
+    background_writer<cow_table> w1;
+    background_writer<rwlock_table> w2;
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
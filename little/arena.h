@@ -0,0 +1,222 @@
+#ifndef HF_ARENA_H_
+#define HF_ARENA_H_
+
+/** Arena allocation for short-lived small containers.
+ *
+ * `hf::arena` hands out memory from large chunks obtained from the global
+ * `operator new`, and returns it all at once with `release()` (or on
+ * destruction). Blocks freed before then are kept on per-size free
+ * lists and reused: a vector that grows from 1 to 8 elements leaves
+ * behind blocks that the next such vector picks up, so that many
+ * containers of the same element type are served without touching the
+ * heap once the arena is warm.
+ *
+ * Requests of up to `arena::max_pooled` bytes are rounded up to a power
+ * of two and pooled; larger requests get a chunk of their own, which is
+ * only freed by `release()`. An arena is not thread-safe.
+ *
+ * `arena_allocator<T>` refers to an arena, and can be used as the
+ * `Allocator` parameter of `small::multiset`, `small::map` or any standard
+ * container; `small::arena_multiset` and `small::arena_map` are the
+ * corresponding aliases. Containers must be destroyed before their
+ * arena is released.
+ *
+ * With C++17 `<memory_resource>`, `arena_resource` wraps an arena as a
+ * `std::pmr::memory_resource`, and `small::pmr::multiset` and
+ * `small::pmr::map` alias the containers with a
+ * `std::pmr::polymorphic_allocator`.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <new>
+#include <utility>
+
+#if __cplusplus>=201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define HF_HAVE_PMR 1
+#endif
+#endif
+
+#include "map.h"
+#include "multiset.h"
+
+namespace hf {
+
+class arena {
+public:
+    static constexpr std::size_t min_block=16;
+    static constexpr std::size_t max_pooled=4096;
+    static constexpr std::size_t default_chunk_size=64*1024;
+
+    explicit arena(std::size_t chunk_size_=default_chunk_size):
+        chunk_size(chunk_size_<2*max_pooled? 2*max_pooled: chunk_size_)
+    {
+        for (auto &f: free_lists) f=nullptr;
+    }
+
+    arena(const arena &) =delete;
+    arena &operator=(const arena &) =delete;
+
+    ~arena() { release(); }
+
+    void *allocate(std::size_t bytes,std::size_t align=alignof(std::max_align_t)) {
+        if (bytes>max_pooled || align>alignof(std::max_align_t)) {
+            return new_chunk(bytes+align)->data(align);
+        }
+
+        std::size_t k=size_class(bytes);
+        if (free_block *b=free_lists[k]) {
+            free_lists[k]=b->next;
+            return b;
+        }
+
+        std::size_t size=min_block<<k;
+        if (static_cast<std::size_t>(end-cur)<size) {
+            cur=static_cast<char *>(new_chunk(chunk_size)->data(alignof(std::max_align_t)));
+            end=cur+chunk_size;
+        }
+        void *p=cur;
+        cur+=size;
+        return p;
+    }
+
+    void deallocate(void *p,std::size_t bytes,std::size_t align=alignof(std::max_align_t)) noexcept {
+        if (!p || bytes>max_pooled || align>alignof(std::max_align_t)) return;
+
+        std::size_t k=size_class(bytes);
+        free_block *b=static_cast<free_block *>(p);
+        b->next=free_lists[k];
+        free_lists[k]=b;
+    }
+
+    // free all memory obtained by the arena
+    void release() noexcept {
+        while (chunks) {
+            chunk *next=chunks->next;
+            ::operator delete(chunks);
+            chunks=next;
+        }
+        for (auto &f: free_lists) f=nullptr;
+        cur=end=nullptr;
+        upstream_bytes=0;
+    }
+
+    // total bytes currently obtained from operator new
+    std::size_t bytes_reserved() const { return upstream_bytes; }
+
+private:
+    struct free_block {
+        free_block *next;
+    };
+
+    struct chunk {
+        chunk *next;
+
+        void *data(std::size_t align) {
+            std::uintptr_t p=reinterpret_cast<std::uintptr_t>(this+1);
+            p=(p+align-1)&~std::uintptr_t(align-1);
+            return reinterpret_cast<void *>(p);
+        }
+    };
+
+    static constexpr std::size_t n_classes=10; // 16 to 4096 bytes
+
+    std::size_t chunk_size;
+    chunk *chunks=nullptr;
+    char *cur=nullptr;
+    char *end=nullptr;
+    std::size_t upstream_bytes=0;
+    free_block *free_lists[n_classes];
+
+    // index k of the smallest block size min_block<<k holding n bytes
+    static std::size_t size_class(std::size_t n) {
+        std::size_t k=0;
+        while ((min_block<<k)<n) ++k;
+        return k;
+    }
+
+    chunk *new_chunk(std::size_t bytes) {
+        std::size_t total=sizeof(chunk)+alignof(std::max_align_t)+bytes;
+        chunk *c=static_cast<chunk *>(::operator new(total));
+        c->next=chunks;
+        chunks=c;
+        upstream_bytes+=total;
+        return c;
+    }
+};
+
+template <typename T>
+struct arena_allocator {
+    typedef T value_type;
+
+    explicit arena_allocator(arena &a) noexcept: a(&a) {}
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U> &other) noexcept: a(other.a) {}
+
+    T *allocate(std::size_t n) {
+        if (n>std::numeric_limits<std::size_t>::max()/sizeof(T)) throw std::bad_alloc();
+        return static_cast<T *>(a->allocate(n*sizeof(T),alignof(T)));
+    }
+
+    void deallocate(T *p,std::size_t n) noexcept {
+        a->deallocate(p,n*sizeof(T),alignof(T));
+    }
+
+    arena *get_arena() const { return a; }
+
+    template <typename U>
+    bool operator==(const arena_allocator<U> &other) const { return a==other.a; }
+
+    template <typename U>
+    bool operator!=(const arena_allocator<U> &other) const { return a!=other.a; }
+
+private:
+    template <typename U> friend struct arena_allocator;
+    arena *a;
+};
+
+#ifdef HF_HAVE_PMR
+class arena_resource: public std::pmr::memory_resource {
+public:
+    explicit arena_resource(std::size_t chunk_size=arena::default_chunk_size): a(chunk_size) {}
+
+    arena &get_arena() { return a; }
+    void release() { a.release(); }
+
+private:
+    arena a;
+
+    void *do_allocate(std::size_t bytes,std::size_t align) override { return a.allocate(bytes,align); }
+    void do_deallocate(void *p,std::size_t bytes,std::size_t align) override { a.deallocate(p,bytes,align); }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this==&other; }
+};
+#endif
+
+namespace small {
+
+template <typename Key,class KeyEqual=std::equal_to<Key>>
+using arena_multiset=multiset<Key,KeyEqual,arena_allocator<Key>>;
+
+template <typename Key,typename Value,class KeyEqual=std::equal_to<Key>>
+using arena_map=map<Key,Value,KeyEqual,arena_allocator<std::pair<Key,Value>>>;
+
+#ifdef HF_HAVE_PMR
+namespace pmr {
+    template <typename Key,class KeyEqual=std::equal_to<Key>>
+    using multiset=small::multiset<Key,KeyEqual,std::pmr::polymorphic_allocator<Key>>;
+
+    template <typename Key,typename Value,class KeyEqual=std::equal_to<Key>>
+    using map=small::map<Key,Value,KeyEqual,std::pmr::polymorphic_allocator<std::pair<Key,Value>>>;
+} // namespace pmr
+#endif
+
+} // namespace small
+
+} // namespace hf
+
+#endif // ndef HF_ARENA_H_
@@ -0,0 +1,123 @@
+#ifndef HF_ATOMIC_SET_H_
+#define HF_ATOMIC_SET_H_
+
+/** Fixed-capacity insert-only set of integers with lock-free operations.
+ *
+ * `tiny::atomic_set<Int,N>` holds at most N distinct integers in an inline
+ * array of atomic slots, of which unused slots hold the value `Empty`
+ * (by default the largest `Int`), which cannot itself be inserted.
+ *
+ * `insert_unique(x)` scans the slots in order: it returns false on
+ * finding x, and otherwise tries to claim the first empty slot for x
+ * with a compare-and-swap; if another thread claims the slot first, the
+ * scan continues from that slot. As elements are never removed, the
+ * occupied slots always form a prefix of the array, and any thread
+ * inserting x must pass the slot in which x was first stored, so that x
+ * is stored at most once. Exactly one of any number of concurrent
+ * `insert_unique(x)` calls returns true.
+ *
+ * `insert_unique`, `contains`, `count`, `size` and `for_each` may be
+ * called concurrently. `reset()` empties the set for reuse, and must not
+ * overlap any other operation.
+ *
+ * Insertion into a full set fails, returning false as for a present
+ * element; `contains` distinguishes the two.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace hf {
+
+namespace tiny {
+
+template <typename Int,std::size_t N,Int Empty=std::numeric_limits<Int>::max()>
+struct atomic_set {
+    static_assert(std::is_integral<Int>::value,"atomic_set requires an integral type");
+    static_assert(N>0,"atomic_set requires non-zero capacity");
+
+    typedef Int key_type;
+    typedef Int value_type;
+    typedef std::size_t size_type;
+
+    static constexpr Int empty_value=Empty;
+
+    atomic_set() { reset(); }
+
+    atomic_set(const atomic_set &) =delete;
+    atomic_set &operator=(const atomic_set &) =delete;
+
+    size_type max_size() const { return N; }
+
+    // Number of elements; under concurrent insertion, a count that held
+    // at some point during the call.
+    size_type size() const {
+        // occupied slots form a prefix: binary search for its end
+        size_type lo=0,hi=N;
+        while (lo<hi) {
+            size_type mid=lo+(hi-lo)/2;
+            if (slot[mid].load(std::memory_order_acquire)!=Empty) lo=mid+1;
+            else hi=mid;
+        }
+        return lo;
+    }
+
+    bool empty() const { return slot[0].load(std::memory_order_acquire)==Empty; }
+    bool full() const { return slot[N-1].load(std::memory_order_acquire)!=Empty; }
+
+    bool contains(Int x) const {
+        for (size_type i=0;i<N;++i) {
+            Int v=slot[i].load(std::memory_order_acquire);
+            if (v==Empty) return false;
+            if (v==x) return true;
+        }
+        return false;
+    }
+
+    size_type count(Int x) const { return contains(x); }
+
+    // insert x if absent and there is room; returns true if x was inserted
+    bool insert_unique(Int x) {
+        if (x==Empty) throw std::invalid_argument("atomic_set: reserved empty value");
+
+        for (size_type i=0;i<N;++i) {
+            Int v=slot[i].load(std::memory_order_acquire);
+            if (v==Empty) {
+                if (slot[i].compare_exchange_strong(v,x,std::memory_order_acq_rel,std::memory_order_acquire)) return true;
+                // v now holds the value stored by the winning thread
+            }
+            if (v==x) return false;
+        }
+        return false;
+    }
+
+    // apply f to each element, in order of insertion
+    template <typename F>
+    void for_each(F f) const {
+        for (size_type i=0;i<N;++i) {
+            Int v=slot[i].load(std::memory_order_acquire);
+            if (v==Empty) return;
+            f(v);
+        }
+    }
+
+    void reset() {
+        for (auto &s: slot) s.store(Empty,std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+private:
+    std::atomic<Int> slot[N];
+};
+
+template <typename Int,std::size_t N,Int Empty>
+constexpr Int atomic_set<Int,N,Empty>::empty_value;
+
+} // namespace tiny
+
+} // namespace hf
+
+#endif // ndef HF_ATOMIC_SET_H_
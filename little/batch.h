@@ -0,0 +1,110 @@
+#ifndef HF_BATCH_H_
+#define HF_BATCH_H_
+
+/** Batched lookups over linear search containers.
+ *
+ * Rather than scanning the container once per query key, queries are
+ * taken in blocks, and each stored element is tested against every
+ * query in the block in a single pass over the container. For
+ * arithmetic keys compared with `std::equal_to`, the inner loop over
+ * the block compiles to vector compares.
+ *
+ * Query keys that are trivially copyable and small are copied into the
+ * block; others are referenced in place, and so the query iterators
+ * must then dereference to lvalues.
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace hf {
+namespace impl {
+    constexpr std::size_t query_block_size=16;
+
+    template <typename Q,bool by_value=std::is_trivially_copyable<Q>::value && sizeof(Q)<=2*sizeof(void *)>
+    struct query_block {
+        // Load up to query_block_size queries, advancing first; unused
+        // slots are filled with copies of the first query so that the
+        // block can always be processed at full width.
+        template <typename I>
+        std::size_t load(I &first,I last) {
+            std::size_t b=0;
+            while (b<query_block_size && first!=last) q[b++]=*first++;
+            for (std::size_t j=b;j<query_block_size;++j) q[j]=q[0];
+            return b;
+        }
+
+        const Q &operator[](std::size_t j) const { return q[j]; }
+
+    private:
+        Q q[query_block_size];
+    };
+
+    template <typename Q>
+    struct query_block<Q,false> {
+        template <typename I>
+        std::size_t load(I &first,I last) {
+            std::size_t b=0;
+            while (b<query_block_size && first!=last) q[b++]=&*first++;
+            for (std::size_t j=b;j<query_block_size;++j) q[j]=q[0];
+            return b;
+        }
+
+        const Q &operator[](std::size_t j) const { return *q[j]; }
+
+    private:
+        const Q *q[query_block_size];
+    };
+
+    template <typename I>
+    using query_block_for=query_block<typename std::iterator_traits<I>::value_type>;
+
+    // Write to out the number of i in [0,n) with eq(key_at(i),q) for
+    // each query q in [first,last).
+    template <typename KeyAt,typename Eq,typename I,typename O>
+    O count_many(std::size_t n,KeyAt key_at,const Eq &eq,I first,I last,O out) {
+        query_block_for<I> qb;
+        while (first!=last) {
+            std::size_t b=qb.load(first,last);
+
+            std::size_t c[query_block_size]={};
+            for (std::size_t i=0;i<n;++i) {
+                const auto &k=key_at(i);
+                for (std::size_t j=0;j<query_block_size;++j) c[j]+=static_cast<bool>(eq(k,qb[j]));
+            }
+
+            for (std::size_t j=0;j<b;++j) *out++=c[j];
+        }
+        return out;
+    }
+
+    // Call emit(i) for each query q in [first,last) with the least i in
+    // [0,n) such that eq(key_at(i),q), or with n if there is none.
+    template <typename KeyAt,typename Eq,typename I,typename Emit>
+    void find_many(std::size_t n,KeyAt key_at,const Eq &eq,I first,I last,Emit emit) {
+        query_block_for<I> qb;
+        while (first!=last) {
+            std::size_t b=qb.load(first,last);
+
+            std::size_t pos[query_block_size];
+            for (std::size_t j=0;j<query_block_size;++j) pos[j]=n;
+
+            // padding slots duplicate query 0, and are found with it
+            std::size_t remaining=query_block_size;
+            for (std::size_t i=0;i<n && remaining;++i) {
+                const auto &k=key_at(i);
+                for (std::size_t j=0;j<query_block_size;++j) {
+                    bool hit=pos[j]==n && eq(k,qb[j]);
+                    pos[j]=hit? i: pos[j];
+                    remaining-=hit;
+                }
+            }
+
+            for (std::size_t j=0;j<b;++j) emit(pos[j]);
+        }
+    }
+} // namespace impl
+} // namespace hf
+
+#endif // ndef HF_BATCH_H_
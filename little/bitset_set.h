@@ -0,0 +1,541 @@
+#ifndef HF_BITSET_SET_H_
+#define HF_BITSET_SET_H_
+
+/** Bitset-backed sets over small integral key domains.
+ *
+ * `tiny::bitset_set<Domain,Key>` holds a set of keys drawn from
+ * [0,Domain), where `Key` is an integral or enumeration type, as one bit
+ * per possible key. Insertion, erasure and lookup are single bit
+ * operations; `size()`, comparison and the set operators `|`, `&`, `-`
+ * and `^` work a 64-bit word at a time, with popcount for sizes.
+ *
+ * `tiny::counted_bitset_set<Domain,Key,CountBits>` is the corresponding
+ * multiset, keeping in addition a `CountBits`-wide count per key (packed
+ * into 64-bit words; `CountBits` is 4 or 8 for nibble or byte counts).
+ *
+ * Both provide the interface of the containers in multiset.h, with
+ * iteration in increasing key order. A key outside [0,Domain) is never
+ * stored: inserting one returns the end iterator, as does a failed
+ * insertion into a full tiny container under `fail_overflow`. A count
+ * saturates at `max_count()`: copies inserted beyond it are dropped.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace hf {
+
+namespace tiny {
+
+namespace impl {
+    inline std::size_t popcount(std::uint64_t w) {
+        return static_cast<std::size_t>(__builtin_popcountll(w));
+    }
+
+    // Fixed-size array of bits, with word-at-a-time operations.
+    template <std::size_t Domain>
+    struct bit_words {
+        static constexpr std::size_t n_words=(Domain+63)/64;
+        std::uint64_t w[n_words]={};
+
+        bool test(std::size_t i) const { return (w[i/64]>>(i%64))&1u; }
+        void set(std::size_t i) { w[i/64]|=std::uint64_t(1)<<(i%64); }
+        void reset(std::size_t i) { w[i/64]&=~(std::uint64_t(1)<<(i%64)); }
+
+        void clear() {
+            for (std::size_t k=0;k<n_words;++k) w[k]=0;
+        }
+
+        bool none() const {
+            std::uint64_t x=0;
+            for (std::size_t k=0;k<n_words;++k) x|=w[k];
+            return !x;
+        }
+
+        std::size_t count() const {
+            std::size_t c=0;
+            for (std::size_t k=0;k<n_words;++k) c+=popcount(w[k]);
+            return c;
+        }
+
+        // Least set index not less than i, or Domain if none.
+        std::size_t next(std::size_t i) const {
+            std::size_t k=i/64;
+            if (k>=n_words) return Domain;
+
+            std::uint64_t m=w[k]&(~std::uint64_t(0)<<(i%64));
+            while (!m) {
+                if (++k==n_words) return Domain;
+                m=w[k];
+            }
+            return k*64+__builtin_ctzll(m);
+        }
+
+        bool operator==(const bit_words &b) const {
+            std::uint64_t x=0;
+            for (std::size_t k=0;k<n_words;++k) x|=w[k]^b.w[k];
+            return !x;
+        }
+    };
+
+    template <std::size_t Domain>
+    constexpr std::size_t bit_words<Domain>::n_words;
+} // namespace impl
+
+template <std::size_t Domain,typename Key=std::size_t>
+struct bitset_set {
+    static_assert(Domain>0,"bitset_set requires a non-empty key domain");
+
+    typedef Key key_type;
+    typedef key_type value_type;
+    typedef std::equal_to<Key> key_equal;
+
+    // elements are not stored as such, and are returned by value
+    typedef value_type const_reference;
+    typedef const_reference reference;
+
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    struct const_iterator {
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Key value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Key *pointer;
+        typedef Key reference;
+
+        const_iterator() =default;
+
+        reference operator*() const { return static_cast<Key>(i); }
+
+        const_iterator &operator++() {
+            i=s->bits.next(i+1);
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator x(*this);
+            ++*this;
+            return x;
+        }
+
+        bool operator==(const const_iterator &other) const { return i==other.i; }
+        bool operator!=(const const_iterator &other) const { return i!=other.i; }
+
+    private:
+        friend struct bitset_set;
+        const_iterator(const bitset_set *s_,std::size_t i_): s(s_),i(i_) {}
+
+        const bitset_set *s=nullptr;
+        std::size_t i=Domain;
+    };
+
+    typedef const_iterator iterator;
+
+    bitset_set() {}
+
+    template <typename I>
+    bitset_set(I b,I e) {
+        insert(b,e);
+    }
+
+    bitset_set(std::initializer_list<Key> ilist) {
+        insert(ilist);
+    }
+
+    bitset_set(const bitset_set &) =default;
+    bitset_set &operator=(const bitset_set &) =default;
+
+    const_iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const { return const_iterator(this,bits.next(0)); }
+
+    const_iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(this,Domain); }
+
+    bool empty() const { return bits.none(); }
+    size_type size() const { return bits.count(); }
+    size_type max_size() const { return Domain; }
+
+    void clear() { bits.clear(); }
+
+    // A key outside [0,Domain) is not inserted: returns {end(),false}.
+    std::pair<iterator,bool> insert(const value_type &key) {
+        std::size_t i=index(key);
+        if (i>=Domain) return {end(),false};
+
+        bool inserted=!bits.test(i);
+        bits.set(i);
+        return {const_iterator(this,i),inserted};
+    }
+
+    template <typename I>
+    void insert(I b,I e) {
+        while (b!=e) insert(*b++);
+    }
+
+    void insert(std::initializer_list<Key> ilist) {
+        insert(ilist.begin(),ilist.end());
+    }
+
+    template <typename... Args>
+    std::pair<iterator,bool> emplace(Args &&... args) {
+        return insert(key_type(std::forward<Args>(args)...));
+    }
+
+    iterator erase(const_iterator pos) {
+        bits.reset(pos.i);
+        return const_iterator(this,bits.next(pos.i));
+    }
+
+    size_type erase(const key_type &key) {
+        if (!contains(key)) return 0;
+        bits.reset(index(key));
+        return 1;
+    }
+
+    template <typename Pred>
+    size_type remove_if(Pred pred) {
+        size_type removed=0;
+        for (std::size_t i=bits.next(0);i<Domain;i=bits.next(i+1)) {
+            if (pred(static_cast<Key>(i))) {
+                bits.reset(i);
+                ++removed;
+            }
+        }
+        return removed;
+    }
+
+    void swap(bitset_set &other) {
+        std::swap(bits,other.bits);
+    }
+
+    bool contains(const key_type &key) const {
+        std::size_t i=index(key);
+        return i<Domain && bits.test(i);
+    }
+
+    size_type count(const key_type &key) const {
+        return contains(key);
+    }
+
+    iterator find(const key_type &key) const {
+        return contains(key)? const_iterator(this,index(key)): end();
+    }
+
+    template <typename I,typename O>
+    O count_many(I first,I last,O out) const {
+        while (first!=last) *out++=count(*first++);
+        return out;
+    }
+
+    template <typename I,typename O>
+    O find_many(I first,I last,O out) const {
+        while (first!=last) *out++=find(*first++);
+        return out;
+    }
+
+    template <typename I,typename O>
+    O contains_many(I first,I last,O out) const {
+        while (first!=last) *out++=contains(*first++);
+        return out;
+    }
+
+    key_equal key_eq() const { return key_equal(); }
+
+    bitset_set &operator|=(const bitset_set &b) {
+        for (std::size_t k=0;k<bits.n_words;++k) bits.w[k]|=b.bits.w[k];
+        return *this;
+    }
+
+    bitset_set &operator&=(const bitset_set &b) {
+        for (std::size_t k=0;k<bits.n_words;++k) bits.w[k]&=b.bits.w[k];
+        return *this;
+    }
+
+    bitset_set &operator-=(const bitset_set &b) {
+        for (std::size_t k=0;k<bits.n_words;++k) bits.w[k]&=~b.bits.w[k];
+        return *this;
+    }
+
+    bitset_set &operator^=(const bitset_set &b) {
+        for (std::size_t k=0;k<bits.n_words;++k) bits.w[k]^=b.bits.w[k];
+        return *this;
+    }
+
+    friend bitset_set operator|(bitset_set a,const bitset_set &b) { return a|=b; }
+    friend bitset_set operator&(bitset_set a,const bitset_set &b) { return a&=b; }
+    friend bitset_set operator-(bitset_set a,const bitset_set &b) { return a-=b; }
+    friend bitset_set operator^(bitset_set a,const bitset_set &b) { return a^=b; }
+
+    // Size of the intersection, without constructing it.
+    size_type intersection_size(const bitset_set &b) const {
+        size_type c=0;
+        for (std::size_t k=0;k<bits.n_words;++k) c+=impl::popcount(bits.w[k]&b.bits.w[k]);
+        return c;
+    }
+
+    friend bool operator==(const bitset_set &a,const bitset_set &b) {
+        return a.bits==b.bits;
+    }
+
+    friend bool operator!=(const bitset_set &a,const bitset_set &b) {
+        return !(a==b);
+    }
+
+private:
+    impl::bit_words<Domain> bits;
+
+    static std::size_t index(const key_type &key) { return static_cast<std::size_t>(key); }
+};
+
+template <std::size_t Domain,typename Key,typename Pred>
+typename bitset_set<Domain,Key>::size_type
+erase_if(bitset_set<Domain,Key> &c,Pred pred) {
+    return c.remove_if(pred);
+}
+
+template <std::size_t Domain,typename Key=std::size_t,unsigned CountBits=8>
+struct counted_bitset_set {
+    static_assert(Domain>0,"counted_bitset_set requires a non-empty key domain");
+    static_assert(CountBits>0 && CountBits<=32 && 64%CountBits==0,"CountBits must divide 64");
+
+    typedef Key key_type;
+    typedef key_type value_type;
+    typedef std::equal_to<Key> key_equal;
+
+    typedef value_type const_reference;
+    typedef const_reference reference;
+
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    struct const_iterator {
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Key value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Key *pointer;
+        typedef Key reference;
+
+        const_iterator() =default;
+
+        reference operator*() const { return static_cast<Key>(i); }
+
+        const_iterator &operator++() {
+            if (++r==s->count_at(i)) {
+                i=s->bits.next(i+1);
+                r=0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator x(*this);
+            ++*this;
+            return x;
+        }
+
+        bool operator==(const const_iterator &other) const { return i==other.i && r==other.r; }
+        bool operator!=(const const_iterator &other) const { return !(*this==other); }
+
+    private:
+        friend struct counted_bitset_set;
+        const_iterator(const counted_bitset_set *s_,std::size_t i_,std::size_t r_=0): s(s_),i(i_),r(r_) {}
+
+        const counted_bitset_set *s=nullptr;
+        std::size_t i=Domain;
+        std::size_t r=0;
+    };
+
+    typedef const_iterator iterator;
+
+    counted_bitset_set() {}
+
+    template <typename I>
+    counted_bitset_set(I b,I e) {
+        insert(b,e);
+    }
+
+    counted_bitset_set(std::initializer_list<Key> ilist) {
+        insert(ilist);
+    }
+
+    counted_bitset_set(const counted_bitset_set &) =default;
+    counted_bitset_set &operator=(const counted_bitset_set &) =default;
+
+    const_iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const { return const_iterator(this,bits.next(0)); }
+
+    const_iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(this,Domain); }
+
+    bool empty() const { return n==0; }
+    size_type size() const { return n; }
+    size_type unique_size() const { return bits.count(); }
+    size_type max_size() const { return Domain*max_count(); }
+    static constexpr size_type max_count() { return (std::uint64_t(1)<<CountBits)-1; }
+
+    void clear() {
+        bits.clear();
+        for (std::size_t k=0;k<n_count_words;++k) counts[k]=0;
+        n=0;
+    }
+
+    iterator insert(const value_type &key) {
+        return insert(key,1);
+    }
+
+    // Insert `count` copies of `key`, up to `max_count()` in all,
+    // returning an iterator to the last. A key outside [0,Domain) is not
+    // inserted: returns end().
+    iterator insert(const value_type &key,size_type count) {
+        std::size_t i=index(key);
+        if (i>=Domain) return end();
+        if (!count) return find(key);
+
+        std::size_t c0=count_at(i);
+        std::size_t c=count<max_count()-c0? c0+count: max_count();
+        set_count(i,c);
+        bits.set(i);
+        n+=c-c0;
+        return const_iterator(this,i,c-1);
+    }
+
+    template <typename I,typename=typename std::enable_if<!std::is_integral<I>::value>::type>
+    void insert(I b,I e) {
+        while (b!=e) insert(*b++);
+    }
+
+    void insert(std::initializer_list<Key> ilist) {
+        insert(ilist.begin(),ilist.end());
+    }
+
+    template <typename... Args>
+    iterator emplace(Args &&... args) {
+        return insert(key_type(std::forward<Args>(args)...));
+    }
+
+    // Remove one element; returns an iterator to the following element.
+    iterator erase(const_iterator pos) {
+        std::size_t c=count_at(pos.i)-1;
+        set_count(pos.i,c);
+        --n;
+        if (pos.r<c) return pos;
+
+        if (!c) bits.reset(pos.i);
+        return const_iterator(this,bits.next(pos.i+1));
+    }
+
+    size_type erase(const key_type &key) {
+        if (!contains(key)) return 0;
+
+        std::size_t i=index(key);
+        size_type c=count_at(i);
+        set_count(i,0);
+        bits.reset(i);
+        n-=c;
+        return c;
+    }
+
+    template <typename Pred>
+    size_type remove_if(Pred pred) {
+        size_type removed=0;
+        for (std::size_t i=bits.next(0);i<Domain;i=bits.next(i+1)) {
+            if (pred(static_cast<Key>(i))) {
+                removed+=count_at(i);
+                set_count(i,0);
+                bits.reset(i);
+            }
+        }
+        n-=removed;
+        return removed;
+    }
+
+    void swap(counted_bitset_set &other) {
+        std::swap(bits,other.bits);
+        std::swap(counts,other.counts);
+        std::swap(n,other.n);
+    }
+
+    bool contains(const key_type &key) const {
+        std::size_t i=index(key);
+        return i<Domain && bits.test(i);
+    }
+
+    size_type count(const key_type &key) const {
+        return contains(key)? count_at(index(key)): 0;
+    }
+
+    iterator find(const key_type &key) const {
+        return contains(key)? const_iterator(this,index(key)): end();
+    }
+
+    template <typename I,typename O>
+    O count_many(I first,I last,O out) const {
+        while (first!=last) *out++=count(*first++);
+        return out;
+    }
+
+    template <typename I,typename O>
+    O find_many(I first,I last,O out) const {
+        while (first!=last) *out++=find(*first++);
+        return out;
+    }
+
+    template <typename I,typename O>
+    O contains_many(I first,I last,O out) const {
+        while (first!=last) *out++=contains(*first++);
+        return out;
+    }
+
+    key_equal key_eq() const { return key_equal(); }
+
+    friend bool operator==(const counted_bitset_set &a,const counted_bitset_set &b) {
+        if (a.n!=b.n) return false;
+
+        std::uint64_t x=0;
+        for (std::size_t k=0;k<n_count_words;++k) x|=a.counts[k]^b.counts[k];
+        return !x;
+    }
+
+    friend bool operator!=(const counted_bitset_set &a,const counted_bitset_set &b) {
+        return !(a==b);
+    }
+
+private:
+    static constexpr std::size_t counts_per_word=64/CountBits;
+    static constexpr std::size_t n_count_words=(Domain+counts_per_word-1)/counts_per_word;
+    static constexpr std::uint64_t count_mask=(std::uint64_t(1)<<CountBits)-1;
+
+    impl::bit_words<Domain> bits;
+    std::uint64_t counts[n_count_words]={};
+    size_type n=0;
+
+    static std::size_t index(const key_type &key) { return static_cast<std::size_t>(key); }
+
+    std::size_t count_at(std::size_t i) const {
+        return (counts[i/counts_per_word]>>(i%counts_per_word*CountBits))&count_mask;
+    }
+
+    void set_count(std::size_t i,std::size_t c) {
+        unsigned shift=i%counts_per_word*CountBits;
+        std::uint64_t &w=counts[i/counts_per_word];
+        w=(w&~(count_mask<<shift))|(std::uint64_t(c)<<shift);
+    }
+};
+
+template <std::size_t Domain,typename Key,unsigned CountBits,typename Pred>
+typename counted_bitset_set<Domain,Key,CountBits>::size_type
+erase_if(counted_bitset_set<Domain,Key,CountBits> &c,Pred pred) {
+    return c.remove_if(pred);
+}
+
+} // namespace tiny
+
+} // namespace hf
+
+#endif // ndef HF_BITSET_SET_H_
@@ -0,0 +1,161 @@
+#ifndef HF_BULK_H_
+#define HF_BULK_H_
+
+/** Bulk insertion into linear search maps.
+ *
+ * Inserting n entries into a linear search map one at a time costs
+ * O(n²) key comparisons. When a map and a range inserted into it hold
+ * enough entries between them, `insert(first,last)`, the range
+ * constructors and `assign_unique` instead group equal keys in
+ * O(n log n) and then fill the store in a single pass. Keys are grouped
+ * by sorting on their hashes if `KeyEqual` is `hash_tagged`, or by
+ * sorting the keys themselves if `KeyEqual` is `std::equal_to` and keys
+ * are less-than comparable (see equality.h); for other key equalities,
+ * entries are always inserted one at a time.
+ *
+ * The thresholds reflect the speed of the element-wise linear search:
+ * tagged lookups scan sixteen entries at a time, and so stay
+ * competitive for longer.
+ *
+ * The result is the same as that of element-wise insertion: entries are
+ * stored in order of first occurrence of their key, and duplicate keys
+ * are resolved by the `DuplicatePolicy` (see policy.h).
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "equality.h"
+#include "hash_tag.h"
+
+namespace hf {
+
+namespace impl {
+    constexpr std::size_t no_pick=static_cast<std::size_t>(-1);
+
+    struct bulk_by_scan {};
+    struct bulk_by_order {};
+    struct bulk_by_hash {};
+
+    // minimum total entries for bulk insertion by each method
+    constexpr std::size_t bulk_threshold(bulk_by_order) { return 128; }
+    constexpr std::size_t bulk_threshold(bulk_by_hash) { return 512; }
+
+    template <typename KeyEqual,typename Key>
+    using bulk_method=typename std::conditional<is_hash_tagged<KeyEqual>::value,bulk_by_hash,
+        typename std::conditional<use_sorted_equality<KeyEqual,Key>::value,bulk_by_order,bulk_by_scan>::type>::type;
+
+    // Number of elements in [b,e) if it can be found without consuming
+    // the range, or no_pick.
+
+    template <typename I>
+    std::size_t range_size_hint(I b,I e,std::forward_iterator_tag) {
+        return static_cast<std::size_t>(std::distance(b,e));
+    }
+
+    template <typename I>
+    std::size_t range_size_hint(I,I,std::input_iterator_tag) { return no_pick; }
+
+    template <typename I>
+    std::size_t range_size_hint(I b,I e) {
+        return range_size_hint(b,e,typename std::iterator_traits<I>::iterator_category());
+    }
+
+    // Indexed access to the entries of a range: forward ranges of
+    // entries are addressed in place, and anything else is first
+    // copied to a buffer, from which entries are then moved by take().
+
+    template <typename I,typename V>
+    struct addressable_range: std::integral_constant<bool,
+        std::is_base_of<std::forward_iterator_tag,typename std::iterator_traits<I>::iterator_category>::value &&
+        std::is_same<typename std::decay<typename std::iterator_traits<I>::reference>::type,V>::value &&
+        std::is_lvalue_reference<typename std::iterator_traits<I>::reference>::value> {};
+
+    template <typename I,typename V,bool in_place=addressable_range<I,V>::value>
+    struct bulk_source {
+        bulk_source(I b,I e): buf(b,e) {}
+
+        std::size_t size() const { return buf.size(); }
+        const V &operator[](std::size_t i) const { return buf[i]; }
+        V &&take(std::size_t i) { return std::move(buf[i]); }
+
+    private:
+        std::vector<V> buf;
+    };
+
+    template <typename I,typename V>
+    struct bulk_source<I,V,true> {
+        bulk_source(I b,I e) {
+            for (;b!=e;++b) ptrs.push_back(&*b);
+        }
+
+        std::size_t size() const { return ptrs.size(); }
+        const V &operator[](std::size_t i) const { return *ptrs[i]; }
+        const V &take(std::size_t i) { return *ptrs[i]; }
+
+    private:
+        std::vector<const V *> ptrs;
+    };
+
+    // Group the keys key_at(0), ..., key_at(n-1) into classes of equal
+    // keys. Returns pick, where pick[i] is the index of the member of
+    // i's class whose entry should be kept if i is the first member of
+    // its class, and no_pick otherwise.
+
+    template <typename KeyAt,typename KeyEqual>
+    std::vector<std::size_t> bulk_pick(std::size_t n,KeyAt key_at,const KeyEqual &,bool first,bulk_by_order) {
+        std::vector<std::size_t> idx(n);
+        std::iota(idx.begin(),idx.end(),std::size_t(0));
+        std::stable_sort(idx.begin(),idx.end(),[&](std::size_t a,std::size_t b) { return key_at(a)<key_at(b); });
+
+        std::vector<std::size_t> pick(n,no_pick);
+        for (std::size_t r=0;r<n;) {
+            std::size_t s=r+1;
+            while (s<n && !(key_at(idx[r])<key_at(idx[s]))) ++s;
+            pick[idx[r]]=first? idx[r]: idx[s-1];
+            r=s;
+        }
+        return pick;
+    }
+
+    template <typename KeyAt,typename KeyEqual>
+    std::vector<std::size_t> bulk_pick(std::size_t n,KeyAt key_at,const KeyEqual &eq,bool first,bulk_by_hash) {
+        auto hash=eq.hash_function();
+        std::vector<std::pair<std::size_t,std::size_t>> hi(n);
+        for (std::size_t i=0;i<n;++i) hi[i]=std::make_pair(static_cast<std::size_t>(hash(key_at(i))),i);
+        std::sort(hi.begin(),hi.end());
+
+        // within a run of equal hashes, ordered by index, match keys
+        // pairwise, marking matched later members with no_pick
+        std::vector<std::size_t> pick(n,no_pick);
+        for (std::size_t r=0;r<n;) {
+            std::size_t s=r+1;
+            while (s<n && hi[s].first==hi[r].first) ++s;
+
+            for (std::size_t j=r;j<s;++j) {
+                std::size_t i=hi[j].second;
+                if (i==no_pick) continue;
+
+                std::size_t last=i;
+                for (std::size_t k=j+1;k<s;++k) {
+                    if (hi[k].second!=no_pick && eq(key_at(i),key_at(hi[k].second))) {
+                        last=hi[k].second;
+                        hi[k].second=no_pick;
+                    }
+                }
+                pick[i]=first? i: last;
+            }
+            r=s;
+        }
+        return pick;
+    }
+} // namespace impl
+
+} // namespace hf
+
+#endif // ndef HF_BULK_H_
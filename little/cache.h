@@ -0,0 +1,267 @@
+#ifndef HF_CACHE_H_
+#define HF_CACHE_H_
+
+/** Fixed-capacity caches built on tiny::map storage.
+ *
+ * `tiny::lru_cache<Key,Value,N>` and `tiny::clock_cache<Key,Value,N>` hold
+ * at most N entries in inline storage, and never allocate. `put(key,value)`
+ * inserts or assigns an entry, evicting another if the cache is full;
+ * `get(key)` returns a pointer to the cached value, or `nullptr` on a miss;
+ * `get_or_insert(key,f)` returns the cached value, computing and caching
+ * `f()` on a miss.
+ *
+ * The LRU cache evicts the least recently used entry, found by a
+ * branchless O(N) scan over per-entry access stamps. The CLOCK (second
+ * chance) cache keeps a reference bit per entry instead, and evicts the
+ * first entry from a rotating hand whose bit is clear, clearing bits as
+ * it passes: eviction is amortised O(1), and a hit just sets a bit.
+ *
+ * Lookups follow tiny::map, including hash tags with a `hash_tagged`
+ * `KeyEqual`. Counts of hits, misses and evictions are kept.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "map.h"
+
+namespace hf {
+
+namespace tiny {
+
+namespace impl {
+    // Eviction state: `touch(i)` records an access to, or insertion at,
+    // slot i; `move(to,from)` follows an entry moved between slots;
+    // `victim()` picks a slot in a full cache to evict.
+
+    template <std::size_t N>
+    struct lru_eviction {
+        void touch(std::size_t i) { stamp[i]=++clock; }
+        void move(std::size_t to,std::size_t from) { stamp[to]=stamp[from]; }
+
+        std::size_t victim() {
+            std::size_t v=0;
+            std::uint64_t oldest=stamp[0];
+            for (std::size_t i=1;i<N;++i) {
+                bool older=stamp[i]<oldest;
+                oldest=older? stamp[i]: oldest;
+                v=older? i: v;
+            }
+            return v;
+        }
+
+    private:
+        std::uint64_t stamp[N]={};
+        std::uint64_t clock=0;
+    };
+
+    template <std::size_t N>
+    struct clock_eviction {
+        void touch(std::size_t i) { referenced[i]=1; }
+        void move(std::size_t to,std::size_t from) { referenced[to]=referenced[from]; }
+
+        std::size_t victim() {
+            while (referenced[hand]) {
+                referenced[hand]=0;
+                advance();
+            }
+            std::size_t v=hand;
+            advance();
+            return v;
+        }
+
+    private:
+        std::uint8_t referenced[N]={};
+        std::size_t hand=0;
+
+        void advance() { hand=hand+1==N? 0: hand+1; }
+    };
+
+    template <typename Key,typename Value,std::size_t N,class KeyEqual,class Eviction>
+    struct cache: private tiny_map_common<Key,Value,N,KeyEqual,unchecked_overflow,static_order> {
+    private:
+        using common=tiny_map_common<Key,Value,N,KeyEqual,unchecked_overflow,static_order>;
+        using common::n;
+        using common::eq;
+        using common::tags;
+        using common::find_index;
+        using common::construct;
+
+    public:
+        using key_type=typename common::key_type;
+        using mapped_type=typename common::mapped_type;
+        using value_type=typename common::value_type;
+        using key_equal=typename common::key_equal;
+        using size_type=typename common::size_type;
+        using difference_type=typename common::difference_type;
+        using reference=typename common::reference;
+        using const_reference=typename common::const_reference;
+        using iterator=typename common::iterator;
+        using const_iterator=typename common::const_iterator;
+
+        using common::begin;
+        using common::cbegin;
+        using common::end;
+        using common::cend;
+        using common::empty;
+        using common::size;
+        using common::max_size;
+        using common::key_eq;
+
+        cache() {}
+        explicit cache(const KeyEqual &eq_): common(eq_) {}
+
+        cache(const cache &other): common(other.eq()) {
+            for (const auto &x: other) construct(x);
+            copy_state(other);
+        }
+
+        cache &operator=(const cache &other) {
+            if (this!=&other) {
+                clear();
+                for (const auto &x: other) construct(x);
+                copy_state(other);
+            }
+            return *this;
+        }
+
+        ~cache() { clear(); }
+
+        void clear() {
+            for (size_type i=0;i<n;++i) slot(i)->~value_type();
+            n=0;
+        }
+
+        // lookup, counting a hit or miss; a hit marks the entry as used
+        mapped_type *get(const key_type &key) {
+            return get_(key);
+        }
+
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        mapped_type *get(const K &key) {
+            return get_(key);
+        }
+
+        // lookup without affecting recency or statistics
+        bool contains(const key_type &key) const {
+            return find_index(key)<n;
+        }
+
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        bool contains(const K &key) const {
+            return find_index(key)<n;
+        }
+
+        template <typename V>
+        mapped_type &put(const key_type &key,V &&value) {
+            return put_(key,std::forward<V>(value));
+        }
+
+        template <typename V>
+        mapped_type &put(key_type &&key,V &&value) {
+            return put_(std::move(key),std::forward<V>(value));
+        }
+
+        template <typename F>
+        mapped_type &get_or_insert(const key_type &key,F compute) {
+            if (mapped_type *v=get_(key)) return *v;
+            return insert_new(key,compute());
+        }
+
+        size_type erase(const key_type &key) {
+            std::size_t i=find_index(key);
+            if (i==n) return 0;
+
+            std::size_t last=n-1;
+            if (i!=last) {
+                *slot(i)=std::move(*slot(last));
+                tags().copy_tag(i,last);
+                eviction.move(i,last);
+            }
+            slot(last)->~value_type();
+            --n;
+            return 1;
+        }
+
+        std::size_t hits() const { return n_hit; }
+        std::size_t misses() const { return n_miss; }
+        std::size_t evictions() const { return n_evict; }
+
+        void reset_stats() { n_hit=n_miss=n_evict=0; }
+
+    private:
+        Eviction eviction;
+        std::size_t n_hit=0,n_miss=0,n_evict=0;
+
+        value_type *slot(std::size_t i) { return common::get(i); }
+
+        // the entries, and with them their hash tags, are copied by the
+        // caller
+        void copy_state(const cache &other) {
+            eviction=other.eviction;
+            n_hit=other.n_hit;
+            n_miss=other.n_miss;
+            n_evict=other.n_evict;
+        }
+
+        template <typename K>
+        mapped_type *get_(const K &key) {
+            std::size_t i=find_index(key);
+            if (i==n) {
+                ++n_miss;
+                return nullptr;
+            }
+
+            ++n_hit;
+            eviction.touch(i);
+            return &slot(i)->second;
+        }
+
+        template <typename K,typename V>
+        mapped_type &put_(K &&key,V &&value) {
+            std::size_t i=find_index(key);
+            if (i<n) {
+                slot(i)->second=std::forward<V>(value);
+                eviction.touch(i);
+                return slot(i)->second;
+            }
+            return insert_new(std::forward<K>(key),std::forward<V>(value));
+        }
+
+        // insert an entry for a key known to be absent
+        template <typename K,typename V>
+        mapped_type &insert_new(K &&key,V &&value) {
+            std::size_t i;
+            if (n<N) {
+                i=n;
+                construct(std::forward<K>(key),std::forward<V>(value));
+            }
+            else {
+                i=eviction.victim();
+                value_type *p=slot(i);
+                p->first=std::forward<K>(key);
+                p->second=std::forward<V>(value);
+                tags().set_tag(i,eq(),p->first);
+                ++n_evict;
+            }
+
+            eviction.touch(i);
+            return slot(i)->second;
+        }
+    };
+} // namespace impl
+
+template <typename Key,typename Value,std::size_t N,class KeyEqual=std::equal_to<Key>>
+using lru_cache=impl::cache<Key,Value,N,KeyEqual,impl::lru_eviction<N>>;
+
+template <typename Key,typename Value,std::size_t N,class KeyEqual=std::equal_to<Key>>
+using clock_cache=impl::cache<Key,Value,N,KeyEqual,impl::clock_eviction<N>>;
+
+} // namespace tiny
+
+} // namespace hf
+
+#endif // ndef HF_CACHE_H_
@@ -0,0 +1,410 @@
+#ifndef HF_CONCURRENT_MAP_H_
+#define HF_CONCURRENT_MAP_H_
+
+/** Fixed-capacity map with lock-free readers.
+ *
+ * `tiny::concurrent_map<Key,Value,N>` holds at most N entries of trivially
+ * copyable keys and values in inline storage, guarded by a sequence lock:
+ * a writer makes the sequence number odd, modifies the entries and makes
+ * it even again, while a reader takes no lock but reads optimistically
+ * and retries if the sequence number changed in the meantime. Readers
+ * therefore never contend with each other, and are delayed by a writer
+ * only for the duration of a single update.
+ *
+ * Readers return copies: `get(key,value)`, `get_or(key,dflt)`, `at(key)`,
+ * `count(key)`, `size()` and `snapshot()`, the last of which returns a
+ * consistent copy of the whole map as a `tiny::map`. Writers are
+ * `insert_or_assign`, `update`, `erase`, `clear` and `assign`, each of
+ * which is applied atomically with respect to readers; writers exclude
+ * each other with a spin lock, and so are intended to be infrequent, as
+ * from a single control thread.
+ *
+ * Entries are stored as arrays of keys and of values packed into words
+ * that are read and written with relaxed atomic operations, so that torn
+ * reads are well defined and detected by the sequence check. A lookup
+ * may however compare a key with a partially updated one before that
+ * check: `KeyEqual` must accept any bit pattern of `Key`.
+ *
+ * Erasure moves the last entry into the erased slot, as with
+ * `tiny::map`.
+ *
+ * If the function passed to `update` throws, the map is unchanged; if
+ * an iterator passed to `assign` throws, the map holds the entries
+ * assigned so far. Either way the lock is released.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "layout.h"
+#include "map.h"
+
+namespace hf {
+
+namespace tiny {
+
+namespace impl {
+    typedef std::uint64_t seq_word;
+
+    constexpr std::size_t words_for(std::size_t bytes) {
+        return (bytes+sizeof(seq_word)-1)/sizeof(seq_word);
+    }
+
+    // Types of which a whole number fit in a word, so that no element
+    // straddles two words.
+    template <typename T>
+    struct word_packed: std::integral_constant<bool,sizeof(seq_word)%sizeof(T)==0> {};
+
+    // The jth T packed in the word x.
+    template <typename T>
+    T word_part(seq_word x,std::size_t j) {
+        typename std::aligned_storage<sizeof(T),alignof(T)>::type buf;
+        std::memcpy(&buf,reinterpret_cast<const char *>(&x)+j*sizeof(T),sizeof(T));
+        return *reinterpret_cast<const T *>(&buf);
+    }
+
+    // Copy bytes [offset,offset+len) of the word array src to dst.
+    inline void load_bytes(void *dst,const std::atomic<seq_word> *src,std::size_t offset,std::size_t len) {
+        seq_word buf[8];
+        char *out=static_cast<char *>(dst);
+
+        std::size_t w=offset/sizeof(seq_word);
+        std::size_t skip=offset%sizeof(seq_word);
+        while (len) {
+            std::size_t nw=std::min<std::size_t>(words_for(skip+len),8);
+            for (std::size_t i=0;i<nw;++i) buf[i]=src[w+i].load(std::memory_order_relaxed);
+
+            std::size_t m=std::min(len,nw*sizeof(seq_word)-skip);
+            std::memcpy(out,reinterpret_cast<const char *>(buf)+skip,m);
+            out+=m;
+            len-=m;
+            w+=nw;
+            skip=0;
+        }
+    }
+
+    // Overwrite bytes [offset,offset+len) of the word array dst; the
+    // caller must hold the write lock.
+    inline void store_bytes(std::atomic<seq_word> *dst,std::size_t offset,const void *src,std::size_t len) {
+        const char *in=static_cast<const char *>(src);
+
+        std::size_t w=offset/sizeof(seq_word);
+        std::size_t skip=offset%sizeof(seq_word);
+        while (len) {
+            std::size_t m=std::min(len,sizeof(seq_word)-skip);
+            seq_word x=m==sizeof(seq_word)? 0: dst[w].load(std::memory_order_relaxed);
+            std::memcpy(reinterpret_cast<char *>(&x)+skip,in,m);
+            dst[w].store(x,std::memory_order_relaxed);
+            in+=m;
+            len-=m;
+            ++w;
+            skip=0;
+        }
+    }
+} // namespace impl
+
+template <typename Key,typename Value,std::size_t N,class KeyEqual=std::equal_to<Key>>
+struct concurrent_map: protected hf::impl::key_equal_holder<KeyEqual> {
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+        "concurrent_map requires trivially copyable keys and values");
+
+    typedef Key key_type;
+    typedef Value mapped_type;
+    typedef std::pair<Key,Value> value_type;
+    typedef KeyEqual key_equal;
+    typedef std::size_t size_type;
+
+    typedef tiny::map<Key,Value,N,KeyEqual> map_type;
+
+    explicit concurrent_map(const KeyEqual &eq_=KeyEqual()): hf::impl::key_equal_holder<KeyEqual>(eq_) {
+        for (auto &w: keys_w) w.store(0,std::memory_order_relaxed);
+        for (auto &w: values_w) w.store(0,std::memory_order_relaxed);
+    }
+
+    template <typename I>
+    concurrent_map(I b,I e,const KeyEqual &eq_=KeyEqual()): concurrent_map(eq_) {
+        assign(b,e);
+    }
+
+    concurrent_map(std::initializer_list<value_type> ilist,const KeyEqual &eq_=KeyEqual()): concurrent_map(eq_) {
+        assign(ilist.begin(),ilist.end());
+    }
+
+    concurrent_map(const concurrent_map &) =delete;
+    concurrent_map &operator=(const concurrent_map &) =delete;
+
+    key_equal key_eq() const { return eq(); }
+    size_type max_size() const { return N; }
+
+    // readers
+
+    size_type size() const {
+        return read_([&]() -> size_type { return size_(); });
+    }
+
+    bool empty() const { return size()==0; }
+
+    size_type count(const key_type &key) const {
+        return read_([&]() -> size_type { return index_of(key)!=N; });
+    }
+
+    // copy the value mapped to key into value and return true, or
+    // return false if key is absent
+    bool get(const key_type &key,mapped_type &value) const {
+        return read_([&]() -> bool {
+            std::size_t i=index_of(key);
+            if (i==N) return false;
+            load_value(i,value);
+            return true;
+        });
+    }
+
+    mapped_type get_or(const key_type &key,const mapped_type &dflt) const {
+        mapped_type value(dflt);
+        get(key,value);
+        return value;
+    }
+
+    mapped_type at(const key_type &key) const {
+        typename std::aligned_storage<sizeof(Value),alignof(Value)>::type buf;
+        mapped_type &value=*reinterpret_cast<mapped_type *>(&buf);
+        if (!get(key,value)) throw std::out_of_range("missing key");
+        return value;
+    }
+
+    // a consistent copy of all entries
+    map_type snapshot() const {
+        struct copy_t {
+            std::size_t n;
+            impl::seq_word keys[key_words];
+            impl::seq_word values[value_words];
+        } c;
+
+        read_([&]() -> bool {
+            c.n=size_();
+            impl::load_bytes(c.keys,keys_w,0,c.n*sizeof(Key));
+            impl::load_bytes(c.values,values_w,0,c.n*sizeof(Value));
+            return true;
+        });
+
+        map_type m(eq());
+        for (std::size_t i=0;i<c.n;++i) {
+            typename std::aligned_storage<sizeof(Key),alignof(Key)>::type k;
+            typename std::aligned_storage<sizeof(Value),alignof(Value)>::type v;
+            std::memcpy(&k,reinterpret_cast<const char *>(c.keys)+i*sizeof(Key),sizeof(Key));
+            std::memcpy(&v,reinterpret_cast<const char *>(c.values)+i*sizeof(Value),sizeof(Value));
+            m.insert(value_type(*reinterpret_cast<const Key *>(&k),*reinterpret_cast<const Value *>(&v)));
+        }
+        return m;
+    }
+
+    // writers
+
+    // map key to value, returning false if key is absent and the map is full
+    bool insert_or_assign(const key_type &key,const mapped_type &value) {
+        return write_([&]() -> bool {
+            std::size_t n=size_();
+            std::size_t i=index_of(key);
+            if (i==N) {
+                if (n==N) return false;
+                i=n;
+                store_key(i,key);
+                set_size(n+1);
+            }
+            store_value(i,value);
+            return true;
+        });
+    }
+
+    // apply fn to the mapped value if present; returns true if applied
+    template <typename F>
+    bool update(const key_type &key,F fn) {
+        return write_([&]() -> bool {
+            std::size_t i=index_of(key);
+            if (i==N) return false;
+
+            typename std::aligned_storage<sizeof(Value),alignof(Value)>::type buf;
+            mapped_type &value=*reinterpret_cast<mapped_type *>(&buf);
+            load_value(i,value);
+            fn(value);
+            store_value(i,value);
+            return true;
+        });
+    }
+
+    size_type erase(const key_type &key) {
+        return write_([&]() -> size_type {
+            std::size_t i=index_of(key);
+            if (i==N) return 0;
+
+            std::size_t last=size_()-1;
+            if (i!=last) {
+                char buf[sizeof(Key)>sizeof(Value)? sizeof(Key): sizeof(Value)];
+                impl::load_bytes(buf,keys_w,last*sizeof(Key),sizeof(Key));
+                impl::store_bytes(keys_w,i*sizeof(Key),buf,sizeof(Key));
+                impl::load_bytes(buf,values_w,last*sizeof(Value),sizeof(Value));
+                impl::store_bytes(values_w,i*sizeof(Value),buf,sizeof(Value));
+            }
+            set_size(last);
+            return 1;
+        });
+    }
+
+    void clear() {
+        write_([&]() -> bool { set_size(0); return true; });
+    }
+
+    // replace the contents with the entries of [b,e), the last value for
+    // a repeated key winning; entries beyond capacity are dropped, and
+    // the return value is false if any were
+    template <typename I>
+    bool assign(I b,I e) {
+        return write_([&]() -> bool {
+            set_size(0);
+            bool all=true;
+            for (;b!=e;++b) {
+                const value_type &x=*b;
+                std::size_t n=size_();
+                std::size_t i=index_of(x.first);
+                if (i==N) {
+                    if (n==N) { all=false; continue; }
+                    i=n;
+                    store_key(i,x.first);
+                    set_size(n+1);
+                }
+                store_value(i,x.second);
+            }
+            return all;
+        });
+    }
+
+    bool assign(const map_type &m) { return assign(m.begin(),m.end()); }
+
+private:
+    using hf::impl::key_equal_holder<KeyEqual>::eq;
+
+    static constexpr std::size_t key_words=impl::words_for(N*sizeof(Key));
+    static constexpr std::size_t value_words=impl::words_for(N*sizeof(Value));
+
+    std::atomic<impl::seq_word> seq{0};
+    std::atomic<impl::seq_word> n_w{0};
+    std::atomic<impl::seq_word> keys_w[key_words];
+    std::atomic<impl::seq_word> values_w[value_words];
+
+    // Run f optimistically until it completes without an intervening
+    // write. f must tolerate torn data, whose results are discarded.
+    template <typename F>
+    auto read_(F f) const -> decltype(std::declval<F &>()()) {
+        for (;;) {
+            impl::seq_word s=seq.load(std::memory_order_acquire);
+            if (s&1) continue;
+
+            auto r=f();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed)==s) return r;
+        }
+    }
+
+    template <typename F>
+    auto write_(F f) -> decltype(std::declval<F &>()()) {
+        impl::seq_word s=seq.load(std::memory_order_relaxed);
+        while ((s&1) || !seq.compare_exchange_weak(s,s+1,std::memory_order_acquire,std::memory_order_relaxed)) {
+            s=seq.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        write_guard guard{seq,s};
+        return f();
+    }
+
+    // Ends a write section, releasing the sequence lock also when the
+    // writer throws.
+    struct write_guard {
+        std::atomic<impl::seq_word> &seq;
+        impl::seq_word s;
+
+        ~write_guard() { seq.store(s+2,std::memory_order_release); }
+    };
+
+    // entry count, clamped so that torn reads stay in bounds
+    std::size_t size_() const {
+        impl::seq_word n=n_w.load(std::memory_order_relaxed);
+        return n<N? static_cast<std::size_t>(n): N;
+    }
+
+    void set_size(std::size_t n) { n_w.store(n,std::memory_order_relaxed); }
+
+    // index of key among the entries, or N if absent
+    std::size_t index_of(const key_type &key) const {
+        return index_of(key,impl::word_packed<Key>());
+    }
+
+    // keys packed whole into words are compared as each word is loaded
+    std::size_t index_of(const key_type &key,std::true_type) const {
+        constexpr std::size_t per_word=sizeof(impl::seq_word)/sizeof(Key);
+
+        std::size_t n=size_();
+        for (std::size_t w=0,i=0;i<n;++w) {
+            impl::seq_word x=keys_w[w].load(std::memory_order_relaxed);
+            for (std::size_t j=0;j<per_word && i<n;++j,++i) {
+                if (eq()(impl::word_part<Key>(x,j),key)) return i;
+            }
+        }
+        return N;
+    }
+
+    std::size_t index_of(const key_type &key,std::false_type) const {
+        std::size_t n=size_();
+        impl::seq_word buf[key_words];
+        impl::load_bytes(buf,keys_w,0,n*sizeof(Key));
+
+        const char *p=reinterpret_cast<const char *>(buf);
+        for (std::size_t i=0;i<n;++i) {
+            typename std::aligned_storage<sizeof(Key),alignof(Key)>::type k;
+            std::memcpy(&k,p+i*sizeof(Key),sizeof(Key));
+            if (eq()(*reinterpret_cast<const Key *>(&k),key)) return i;
+        }
+        return N;
+    }
+
+    void load_value(std::size_t i,mapped_type &value) const {
+        load_value(i,value,impl::word_packed<Value>());
+    }
+
+    void load_value(std::size_t i,mapped_type &value,std::true_type) const {
+        constexpr std::size_t per_word=sizeof(impl::seq_word)/sizeof(Value);
+        impl::seq_word x=values_w[i/per_word].load(std::memory_order_relaxed);
+        value=impl::word_part<Value>(x,i%per_word);
+    }
+
+    void load_value(std::size_t i,mapped_type &value,std::false_type) const {
+        impl::load_bytes(&value,values_w,i*sizeof(Value),sizeof(Value));
+    }
+
+    void store_key(std::size_t i,const key_type &key) {
+        impl::store_bytes(keys_w,i*sizeof(Key),&key,sizeof(Key));
+    }
+
+    void store_value(std::size_t i,const mapped_type &value) {
+        impl::store_bytes(values_w,i*sizeof(Value),&value,sizeof(Value));
+    }
+};
+
+template <typename Key,typename Value,std::size_t N,class KeyEqual>
+constexpr std::size_t concurrent_map<Key,Value,N,KeyEqual>::key_words;
+
+template <typename Key,typename Value,std::size_t N,class KeyEqual>
+constexpr std::size_t concurrent_map<Key,Value,N,KeyEqual>::value_words;
+
+} // namespace tiny
+
+} // namespace hf
+
+#endif // ndef HF_CONCURRENT_MAP_H_
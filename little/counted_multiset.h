@@ -0,0 +1,343 @@
+#ifndef HF_COUNTED_MULTISET_H_
+#define HF_COUNTED_MULTISET_H_
+
+/** Run-length multiset for heavily duplicated keys.
+ *
+ * `small::counted_multiset` stores each distinct key once, together with
+ * its multiplicity. Inserting a key already present increments its count,
+ * `count` is a single linear search over the distinct keys, and storage
+ * is proportional to the number of distinct keys rather than the number
+ * of elements.
+ *
+ * The interface follows `small::multiset` (see multiset.h): iteration
+ * yields each key as many times as it is present, and `size()` is the
+ * total number of elements. In addition, `insert(key,n)` adds `n` copies
+ * of a key, `unique_size()` gives the number of distinct keys, and
+ * `counts_begin()` and `counts_end()` iterate over (key,count) pairs.
+ *
+ * Erasure of a distinct key preserves the order of the remaining keys.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "batch.h"
+
+namespace hf {
+
+namespace small {
+
+template <typename Key,class KeyEqual=std::equal_to<Key>,class Allocator=std::allocator<Key>>
+struct counted_multiset {
+    typedef Key key_type;
+    typedef key_type value_type;
+    typedef KeyEqual key_equal;
+
+    typedef const value_type &const_reference;
+    typedef const_reference reference;
+
+    typedef Allocator allocator_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+private:
+    typedef std::pair<key_type,size_type> entry_type;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<entry_type> entry_allocator;
+    typedef std::vector<entry_type,entry_allocator> store_type;
+
+public:
+    typedef typename store_type::const_iterator counts_iterator;
+
+    struct const_iterator {
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Key value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Key *pointer;
+        typedef const Key &reference;
+
+        const_iterator() =default;
+
+        reference operator*() const { return e->first; }
+        pointer operator->() const { return &e->first; }
+
+        const_iterator &operator++() {
+            if (++r==e->second) {
+                ++e;
+                r=0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator x(*this);
+            ++*this;
+            return x;
+        }
+
+        bool operator==(const const_iterator &other) const { return e==other.e && r==other.r; }
+        bool operator!=(const const_iterator &other) const { return !(*this==other); }
+
+    private:
+        friend struct counted_multiset;
+        const_iterator(counts_iterator e_,size_type r_): e(e_),r(r_) {}
+
+        counts_iterator e;
+        size_type r=0;
+    };
+
+    typedef const_iterator iterator;
+
+    counted_multiset(const counted_multiset &) =default;
+    counted_multiset(counted_multiset &&other)
+        : v(std::move(other.v)),n(other.n),eq(std::move(other.eq))
+    {
+        other.v.clear();
+        other.n=0;
+    }
+
+    counted_multiset(const KeyEqual &eq_=KeyEqual(),
+        const Allocator &alloc_=Allocator()): v(entry_allocator(alloc_)),eq(eq_) {}
+
+    counted_multiset(const Allocator &alloc_): v(entry_allocator(alloc_)) {}
+
+    counted_multiset(const counted_multiset &other,const Allocator &alloc_)
+        : v(other.v,entry_allocator(alloc_)),n(other.n),eq(other.eq) {}
+    counted_multiset(counted_multiset &&other,const Allocator &alloc_)
+        : v(std::move(other.v),entry_allocator(alloc_)),n(other.n),eq(other.eq)
+    {
+        other.v.clear();
+        other.n=0;
+    }
+
+    template <typename I>
+    counted_multiset(I b,I e,const KeyEqual &eq_=KeyEqual(),
+        const Allocator &alloc_=Allocator()): v(entry_allocator(alloc_)),eq(eq_) { insert(b,e); }
+
+    counted_multiset(std::initializer_list<Key> ilist,
+        const KeyEqual &eq_=KeyEqual(),const Allocator &alloc_=Allocator())
+        : v(entry_allocator(alloc_)),eq(eq_) { insert(ilist); }
+
+    counted_multiset &operator=(const counted_multiset &) =default;
+
+    counted_multiset &operator=(counted_multiset &&other) {
+        v=std::move(other.v);
+        n=other.n;
+        eq=std::move(other.eq);
+        other.v.clear();
+        other.n=0;
+        return *this;
+    }
+
+    const_iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const { return const_iterator(v.cbegin(),0); }
+
+    const_iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(v.cend(),0); }
+
+    counts_iterator counts_begin() const { return v.cbegin(); }
+    counts_iterator counts_end() const { return v.cend(); }
+
+    bool empty() const { return n==0; }
+    size_type size() const { return n; }
+    size_type unique_size() const { return v.size(); }
+    size_type max_size() const { return std::numeric_limits<size_type>::max(); }
+
+    void clear() {
+        v.clear();
+        n=0;
+    }
+
+    iterator insert(const value_type &value) {
+        return insert(value,1);
+    }
+
+    iterator insert(value_type &&value) {
+        return insert(std::move(value),1);
+    }
+
+    // Insert `count` copies of `value`, returning an iterator to the last.
+    template <typename V,typename=typename std::enable_if<std::is_convertible<V,key_type>::value>::type>
+    iterator insert(V &&value,size_type count) {
+        auto e=find_entry(value);
+        if (!count) return const_iterator(e,0);
+
+        if (e==v.end()) {
+            v.emplace_back(std::forward<V>(value),count);
+            e=std::prev(v.end());
+        }
+        else e->second+=count;
+
+        n+=count;
+        return const_iterator(e,e->second-1);
+    }
+
+    template <typename I,typename=typename std::enable_if<!std::is_integral<I>::value>::type>
+    void insert(I b,I e) {
+        while (b!=e) insert(*b++);
+    }
+
+    void insert(std::initializer_list<Key> ilist) {
+        insert(ilist.begin(),ilist.end());
+    }
+
+    template <typename... Args>
+    iterator emplace(Args &&... args) {
+        return insert(key_type(std::forward<Args>(args)...),1);
+    }
+
+    // Remove one element; returns an iterator to the following element.
+    iterator erase(const_iterator pos) {
+        auto e=v.begin()+(pos.e-v.cbegin());
+        --n;
+        if (--e->second) {
+            return pos.r<e->second? pos: const_iterator(std::next(pos.e),0);
+        }
+
+        e=v.erase(e);
+        return const_iterator(e,0);
+    }
+
+    size_type erase(const key_type &key) {
+        return erase_key(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent,
+              typename=typename std::enable_if<!std::is_convertible<K,const_iterator>::value>::type>
+    size_type erase(const K &key) {
+        return erase_key(key);
+    }
+
+    template <typename Pred>
+    size_type remove_if(Pred pred) {
+        size_type removed=0;
+        auto b=std::remove_if(v.begin(),v.end(),
+            [&](const entry_type &e) { return pred(e.first)? (removed+=e.second,true): false; });
+        v.erase(b,v.end());
+        n-=removed;
+        return removed;
+    }
+
+    void swap(counted_multiset &other) {
+        std::swap(v,other.v);
+        std::swap(n,other.n);
+        std::swap(eq,other.eq);
+    }
+
+    size_type count(const key_type &key) const {
+        return count_(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    size_type count(const K &key) const {
+        return count_(key);
+    }
+
+    iterator find(const key_type &key) const {
+        return const_iterator(find_entry(key),0);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    iterator find(const K &key) const {
+        return const_iterator(find_entry(key),0);
+    }
+
+    template <typename I,typename O>
+    O count_many(I first,I last,O out) const {
+        std::size_t u=v.size();
+        impl::find_many(u,key_at(),eq,first,last,[&](std::size_t i) { *out++=i==u? 0: v[i].second; });
+        return out;
+    }
+
+    template <typename I,typename O>
+    O find_many(I first,I last,O out) const {
+        impl::find_many(v.size(),key_at(),eq,first,last,[&](std::size_t i) { *out++=const_iterator(v.begin()+i,0); });
+        return out;
+    }
+
+    template <typename I,typename O>
+    O contains_many(I first,I last,O out) const {
+        std::size_t u=v.size();
+        impl::find_many(u,key_at(),eq,first,last,[&](std::size_t i) { *out++=i!=u; });
+        return out;
+    }
+
+    KeyEqual key_eq() const { return eq; }
+    Allocator get_allocator() const { return Allocator(v.get_allocator()); }
+
+    friend bool operator==(const counted_multiset &a,const counted_multiset &b) {
+        if (a.n!=b.n || a.v.size()!=b.v.size()) return false;
+        for (const auto &e: a.v) {
+            if (b.count_(e.first)!=e.second) return false;
+        }
+        return true;
+    }
+
+    friend bool operator!=(const counted_multiset &a,const counted_multiset &b) {
+        return !(a==b);
+    }
+
+private:
+    store_type v;
+    size_type n=0;
+    KeyEqual eq;
+
+    template <typename K>
+    typename store_type::iterator find_entry(const K &key) {
+        auto b=v.begin();
+        auto e=v.end();
+        while (b!=e) if (eq(b->first,key)) break; else ++b;
+        return b;
+    }
+
+    template <typename K>
+    counts_iterator find_entry(const K &key) const {
+        auto b=v.cbegin();
+        auto e=v.cend();
+        while (b!=e) if (eq(b->first,key)) break; else ++b;
+        return b;
+    }
+
+    template <typename K>
+    size_type count_(const K &key) const {
+        auto e=find_entry(key);
+        return e==v.end()? 0: e->second;
+    }
+
+    template <typename K>
+    size_type erase_key(const K &key) {
+        auto e=find_entry(key);
+        if (e==v.end()) return 0;
+
+        size_type c=e->second;
+        v.erase(e);
+        n-=c;
+        return c;
+    }
+
+    struct key_at_index {
+        const entry_type *data;
+        const key_type &operator()(std::size_t i) const { return data[i].first; }
+    };
+
+    key_at_index key_at() const { return key_at_index{v.data()}; }
+};
+
+template <typename Key,class KeyEqual,class Allocator,typename Pred>
+typename counted_multiset<Key,KeyEqual,Allocator>::size_type
+erase_if(counted_multiset<Key,KeyEqual,Allocator> &c,Pred pred) {
+    return c.remove_if(pred);
+}
+
+} // namespace small
+
+} // namespace hf
+
+#endif // ndef HF_COUNTED_MULTISET_H_
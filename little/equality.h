@@ -0,0 +1,136 @@
+#ifndef HF_EQUALITY_H_
+#define HF_EQUALITY_H_
+
+/** Equality and hashing of unordered container contents.
+ *
+ * Comparing two linear search containers for equality by searching one
+ * for each element of the other is O(N²). When the key equality is
+ * `std::equal_to` and keys are less-than comparable, the containers
+ * instead sort pointers to their elements in scratch storage and compare
+ * the sorted sequences, in O(N log N). Below `sorted_equality_threshold`
+ * elements, or if the key type does not admit this, the quadratic
+ * comparison is retained.
+ *
+ * `multiset_hash` and `map_hash` give order-independent hashes of
+ * container contents, consistent with the container equality provided
+ * the element hashes are consistent with `KeyEqual` (and, for maps, with
+ * `operator==` on mapped values).
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace hf {
+
+namespace impl {
+    constexpr std::size_t sorted_equality_threshold=32;
+
+    template <typename T,typename=void>
+    struct is_less_comparable: std::false_type {};
+
+    template <typename T>
+    struct is_less_comparable<T,typename std::conditional<true,void,decltype(std::declval<const T &>()<std::declval<const T &>())>::type>: std::true_type {};
+
+    // Key equality known to coincide with equivalence under operator<.
+    template <typename KeyEqual,typename Key>
+    struct is_default_equal: std::false_type {};
+
+    template <typename Key>
+    struct is_default_equal<std::equal_to<Key>,Key>: std::true_type {};
+
+    template <typename KeyEqual,typename Key>
+    struct use_sorted_equality:
+        std::integral_constant<bool,is_default_equal<KeyEqual,Key>::value && is_less_comparable<Key>::value> {};
+
+    // Compare n elements at a and at b as multisets, by sorting pointers to
+    // the elements into scratch, which must have room for 2n pointers.
+    template <typename T,typename Less,typename Equal>
+    bool sorted_equal(const T *a,const T *b,std::size_t n,const T **scratch,Less less,Equal equal) {
+        const T **pa=scratch;
+        const T **pb=scratch+n;
+        for (std::size_t i=0;i<n;++i) {
+            pa[i]=a+i;
+            pb[i]=b+i;
+        }
+
+        auto ptr_less=[&](const T *x,const T *y) { return less(*x,*y); };
+        std::sort(pa,pa+n,ptr_less);
+        std::sort(pb,pb+n,ptr_less);
+
+        for (std::size_t i=0;i<n;++i) if (!equal(*pa[i],*pb[i])) return false;
+        return true;
+    }
+
+    // Orderings and equalities on multiset elements and map entries.
+
+    struct less_key {
+        template <typename T>
+        bool operator()(const T &a,const T &b) const { return a<b; }
+    };
+
+    struct equal_key {
+        template <typename T>
+        bool operator()(const T &a,const T &b) const { return a==b; }
+    };
+
+    struct less_entry_key {
+        template <typename P>
+        bool operator()(const P &a,const P &b) const { return a.first<b.first; }
+    };
+
+    struct equal_entry {
+        template <typename P>
+        bool operator()(const P &a,const P &b) const { return a.first==b.first && a.second==b.second; }
+    };
+
+    // splitmix64 finaliser
+    inline std::uint64_t mix_hash(std::uint64_t h) {
+        h=(h^(h>>30))*0xbf58476d1ce4e5b9ull;
+        h=(h^(h>>27))*0x94d049bb133111ebull;
+        return h^(h>>31);
+    }
+} // namespace impl
+
+/** Order-independent hash of multiset contents */
+
+template <typename Container,class Hash=std::hash<typename Container::key_type>>
+struct multiset_hash {
+    explicit multiset_hash(const Hash &hash_=Hash()): hash(hash_) {}
+
+    std::size_t operator()(const Container &c) const {
+        std::uint64_t h=0;
+        for (const auto &k: c) h+=impl::mix_hash(hash(k));
+        return static_cast<std::size_t>(impl::mix_hash(h+c.size()));
+    }
+
+private:
+    Hash hash;
+};
+
+/** Order-independent hash of map contents */
+
+template <typename Container,
+          class KeyHash=std::hash<typename Container::key_type>,
+          class ValueHash=std::hash<typename Container::mapped_type>>
+struct map_hash {
+    explicit map_hash(const KeyHash &key_hash_=KeyHash(),const ValueHash &value_hash_=ValueHash())
+        : key_hash(key_hash_),value_hash(value_hash_) {}
+
+    std::size_t operator()(const Container &c) const {
+        std::uint64_t h=0;
+        for (const auto &kv: c) h+=impl::mix_hash(impl::mix_hash(key_hash(kv.first))^value_hash(kv.second));
+        return static_cast<std::size_t>(impl::mix_hash(h+c.size()));
+    }
+
+private:
+    KeyHash key_hash;
+    ValueHash value_hash;
+};
+
+} // namespace hf
+
+#endif // ndef HF_EQUALITY_H_
@@ -0,0 +1,411 @@
+#ifndef HF_FLAT_H_
+#define HF_FLAT_H_
+
+/** Flat binary format for arrays of tiny containers.
+ *
+ * `write_flat(out,first,last)` writes a range of `tiny::multiset` or
+ * `tiny::map` containers of trivially copyable keys (and values) to a
+ * stream as a single flat image, which `tiny::view_array` reads in
+ * place, e.g. from a memory-mapped file (see `mapped_file`), without
+ * deserialisation: element i of a `view_array<multiset_view<Key,N>>` or
+ * `view_array<map_view<Key,Value,N>>` is a read-only view of the ith
+ * container, providing `size`, `count`, `find` and, for maps, `get_ptr`
+ * and `at` directly on the image.
+ *
+ * The image is a 64-byte header followed by one fixed-size record per
+ * container. The header holds a magic number, the format version, a
+ * byte order tag, the container kind, the capacity N, the sizes of key
+ * and value, and the record layout; a view array checks all of these
+ * against its own type, throwing `std::runtime_error` on any mismatch,
+ * in particular for an image written with the other byte order. A
+ * record holds the entry count as a 32-bit integer, followed by N key
+ * slots and, for maps, N value slots, each array aligned for its type.
+ * The image must itself be so aligned in memory, as a mapped file is.
+ * Record counts are not checked when the image is opened, which would
+ * touch every page of it; instead a view clamps its count to N, so that
+ * a corrupt record yields wrong entries but never a read outside it.
+ *
+ * Keys and values are stored as their object representation: an image
+ * is portable only between builds with the same type layouts.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <functional>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HF_HAVE_MMAP
+#endif
+
+#include "map.h"
+#include "multiset.h"
+
+namespace hf {
+
+namespace tiny {
+
+namespace impl {
+    constexpr std::uint16_t flat_version=1;
+    constexpr std::uint16_t flat_byte_order=0x0102;
+
+    enum flat_kind: std::uint8_t { flat_multiset_kind=1, flat_map_kind=2 };
+
+    struct flat_header {
+        char magic[4];
+        std::uint16_t version;
+        std::uint16_t byte_order;
+        std::uint8_t kind;
+        std::uint8_t reserved[3];
+        std::uint32_t capacity;
+        std::uint32_t key_size;
+        std::uint32_t value_size;
+        std::uint32_t record_size;
+        std::uint32_t keys_offset;
+        std::uint32_t values_offset;
+        std::uint64_t n_records;
+        char padding[16];
+    };
+    static_assert(sizeof(flat_header)==64,"unexpected flat_header layout");
+
+    constexpr std::size_t round_up(std::size_t n,std::size_t a) { return (n+a-1)/a*a; }
+    constexpr std::size_t max_of(std::size_t a,std::size_t b) { return a<b? b: a; }
+
+    // Record layout for N keys of type Key and N values of Value, where
+    // value_size is zero for multisets.
+    template <typename Key,std::size_t N,std::size_t value_size,std::size_t value_align>
+    struct flat_layout {
+        static constexpr std::size_t align=max_of(alignof(std::uint32_t),max_of(alignof(Key),value_align));
+        static constexpr std::size_t keys_offset=round_up(sizeof(std::uint32_t),alignof(Key));
+        static constexpr std::size_t values_offset=round_up(keys_offset+N*sizeof(Key),value_align);
+        static constexpr std::size_t record_size=round_up(values_offset+N*value_size,align);
+
+        static_assert(align<=sizeof(flat_header),"key or value alignment exceeds flat header size");
+    };
+
+    template <typename Key,std::size_t N>
+    using flat_multiset_layout=flat_layout<Key,N,0,1>;
+
+    template <typename Key,typename Value,std::size_t N>
+    using flat_map_layout=flat_layout<Key,N,sizeof(Value),alignof(Value)>;
+
+    inline flat_header make_flat_header(flat_kind kind,std::size_t capacity,std::size_t key_size,std::size_t value_size,
+        std::size_t record_size,std::size_t keys_offset,std::size_t values_offset,std::size_t n_records)
+    {
+        flat_header h;
+        std::memset(&h,0,sizeof(h));
+        std::memcpy(h.magic,"HFTC",4);
+        h.version=flat_version;
+        h.byte_order=flat_byte_order;
+        h.kind=kind;
+        h.capacity=static_cast<std::uint32_t>(capacity);
+        h.key_size=static_cast<std::uint32_t>(key_size);
+        h.value_size=static_cast<std::uint32_t>(value_size);
+        h.record_size=static_cast<std::uint32_t>(record_size);
+        h.keys_offset=static_cast<std::uint32_t>(keys_offset);
+        h.values_offset=static_cast<std::uint32_t>(values_offset);
+        h.n_records=n_records;
+        return h;
+    }
+
+    // Check that the image at data of the given size matches the
+    // expected header, returning the number of records.
+    inline std::size_t check_flat_header(const void *data,std::size_t size,const flat_header &expect) {
+        if (size<sizeof(flat_header)) throw std::runtime_error("flat image: truncated header");
+        if (reinterpret_cast<std::uintptr_t>(data)%sizeof(flat_header)) throw std::runtime_error("flat image: misaligned");
+
+        flat_header h;
+        std::memcpy(&h,data,sizeof(h));
+        if (std::memcmp(h.magic,expect.magic,4)) throw std::runtime_error("flat image: bad magic number");
+        if (h.byte_order!=flat_byte_order) throw std::runtime_error("flat image: byte order mismatch");
+        if (h.version!=flat_version) throw std::runtime_error("flat image: unsupported version "+std::to_string(h.version));
+        if (h.kind!=expect.kind) throw std::runtime_error("flat image: container kind mismatch");
+        if (h.capacity!=expect.capacity || h.key_size!=expect.key_size || h.value_size!=expect.value_size ||
+            h.record_size!=expect.record_size || h.keys_offset!=expect.keys_offset || h.values_offset!=expect.values_offset)
+        {
+            throw std::runtime_error("flat image: container layout mismatch");
+        }
+        if ((size-sizeof(flat_header))/h.record_size<h.n_records) throw std::runtime_error("flat image: truncated records");
+        return static_cast<std::size_t>(h.n_records);
+    }
+
+    // Entry count of a record, clamped to the capacity n, so that a
+    // corrupt count cannot take a lookup past the end of the record.
+    inline std::size_t record_count(const char *record,std::size_t n) {
+        std::uint32_t c;
+        std::memcpy(&c,record,sizeof(c));
+        return c<n? c: n;
+    }
+
+    // Flat format description of a tiny container type.
+
+    template <typename C>
+    struct flat_traits;
+
+    template <typename Key,std::size_t N,class KeyEqual,class OverflowPolicy,class AccessPolicy,bool trivial>
+    struct flat_traits<multiset<Key,N,KeyEqual,OverflowPolicy,AccessPolicy,trivial>> {
+        static_assert(std::is_trivially_copyable<Key>::value,"flat format requires trivially copyable keys");
+        typedef flat_multiset_layout<Key,N> layout;
+
+        static flat_header header(std::size_t n_records) {
+            return make_flat_header(flat_multiset_kind,N,sizeof(Key),0,layout::record_size,layout::keys_offset,layout::values_offset,n_records);
+        }
+
+        template <typename C>
+        static void fill(char *record,const C &c) {
+            std::uint32_t n=0;
+            for (const Key &k: c) std::memcpy(record+layout::keys_offset+(n++)*sizeof(Key),&k,sizeof(Key));
+            std::memcpy(record,&n,sizeof(n));
+        }
+    };
+
+    template <typename Key,typename Value,std::size_t N,class KeyEqual,class OverflowPolicy,class AccessPolicy,bool trivial>
+    struct flat_traits<map<Key,Value,N,KeyEqual,OverflowPolicy,AccessPolicy,trivial>> {
+        static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+            "flat format requires trivially copyable keys and values");
+        typedef flat_map_layout<Key,Value,N> layout;
+
+        static flat_header header(std::size_t n_records) {
+            return make_flat_header(flat_map_kind,N,sizeof(Key),sizeof(Value),layout::record_size,layout::keys_offset,layout::values_offset,n_records);
+        }
+
+        template <typename C>
+        static void fill(char *record,const C &c) {
+            std::uint32_t n=0;
+            for (const auto &e: c) {
+                std::memcpy(record+layout::keys_offset+n*sizeof(Key),&e.first,sizeof(Key));
+                std::memcpy(record+layout::values_offset+n*sizeof(Value),&e.second,sizeof(Value));
+                ++n;
+            }
+            std::memcpy(record,&n,sizeof(n));
+        }
+    };
+} // namespace impl
+
+/** Write the tiny multisets or maps in [b,e) as a flat image. */
+
+template <typename I>
+void write_flat(std::ostream &out,I b,I e) {
+    typedef impl::flat_traits<typename std::iterator_traits<I>::value_type> traits;
+    typedef typename traits::layout layout;
+
+    std::size_t n=static_cast<std::size_t>(std::distance(b,e));
+    impl::flat_header h=traits::header(n);
+    out.write(reinterpret_cast<const char *>(&h),sizeof(h));
+
+    std::vector<char> record(layout::record_size);
+    for (;b!=e;++b) {
+        std::fill(record.begin(),record.end(),0);
+        traits::fill(record.data(),*b);
+        out.write(record.data(),record.size());
+    }
+    if (!out) throw std::runtime_error("flat image: write failed");
+}
+
+/** Read-only view of a multiset record in a flat image. */
+
+template <typename Key,std::size_t N,class KeyEqual=std::equal_to<Key>>
+struct multiset_view {
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef std::size_t size_type;
+    typedef const Key *const_iterator;
+    typedef const_iterator iterator;
+
+    typedef impl::flat_multiset_layout<Key,N> layout;
+
+    static impl::flat_header header() {
+        return impl::make_flat_header(impl::flat_multiset_kind,N,sizeof(Key),0,layout::record_size,layout::keys_offset,layout::values_offset,0);
+    }
+
+    explicit multiset_view(const char *record_): record(record_) {}
+
+    size_type size() const { return impl::record_count(record,N); }
+
+    bool empty() const { return size()==0; }
+    size_type max_size() const { return N; }
+
+    const_iterator begin() const { return reinterpret_cast<const Key *>(record+layout::keys_offset); }
+    const_iterator end() const { return begin()+size(); }
+
+    const_iterator find(const key_type &key) const {
+        KeyEqual eq;
+        return std::find_if(begin(),end(),[&](const Key &k) { return eq(k,key); });
+    }
+
+    size_type count(const key_type &key) const {
+        KeyEqual eq;
+        return std::count_if(begin(),end(),[&](const Key &k) { return eq(k,key); });
+    }
+
+private:
+    const char *record;
+};
+
+/** Read-only view of a map record in a flat image.
+ *
+ * Keys and values are stored in separate arrays, so iteration is by
+ * index, with `key(i)` and `value(i)` for i in [0,size()).
+ */
+
+template <typename Key,typename Value,std::size_t N,class KeyEqual=std::equal_to<Key>>
+struct map_view {
+    typedef Key key_type;
+    typedef Value mapped_type;
+    typedef std::size_t size_type;
+
+    typedef impl::flat_map_layout<Key,Value,N> layout;
+
+    static impl::flat_header header() {
+        return impl::make_flat_header(impl::flat_map_kind,N,sizeof(Key),sizeof(Value),layout::record_size,layout::keys_offset,layout::values_offset,0);
+    }
+
+    explicit map_view(const char *record_): record(record_) {}
+
+    size_type size() const { return impl::record_count(record,N); }
+
+    bool empty() const { return size()==0; }
+    size_type max_size() const { return N; }
+
+    const Key &key(size_type i) const { return keys()[i]; }
+    const Value &value(size_type i) const { return values()[i]; }
+
+    size_type count(const key_type &key) const { return index_of(key)<size(); }
+
+    // pointer to the value mapped to key, or nullptr if absent
+    const mapped_type *get_ptr(const key_type &key) const {
+        size_type i=index_of(key);
+        return i<size()? values()+i: nullptr;
+    }
+
+    const mapped_type &at(const key_type &key) const {
+        const mapped_type *v=get_ptr(key);
+        if (!v) throw std::out_of_range("missing key");
+        return *v;
+    }
+
+    // copy into a tiny::map
+    map<Key,Value,N,KeyEqual> to_map() const {
+        map<Key,Value,N,KeyEqual> m;
+        for (size_type i=0;i<size();++i) m.insert(std::make_pair(key(i),value(i)));
+        return m;
+    }
+
+private:
+    const char *record;
+
+    const Key *keys() const { return reinterpret_cast<const Key *>(record+layout::keys_offset); }
+    const Value *values() const { return reinterpret_cast<const Value *>(record+layout::values_offset); }
+
+    size_type index_of(const key_type &key) const {
+        KeyEqual eq;
+        const Key *k=keys();
+        size_type n=size();
+        for (size_type i=0;i<n;++i) if (eq(k[i],key)) return i;
+        return n;
+    }
+};
+
+/** The records of a flat image, viewed in place as `View`s.
+ *
+ * The image must outlive the view array.
+ */
+
+template <typename View>
+struct view_array {
+    typedef View value_type;
+    typedef std::size_t size_type;
+
+    view_array(const void *data,std::size_t size):
+        records(static_cast<const char *>(data)+sizeof(impl::flat_header)),
+        n(impl::check_flat_header(data,size,View::header()))
+    {}
+
+    size_type size() const { return n; }
+    bool empty() const { return n==0; }
+
+    View operator[](size_type i) const { return View(records+i*View::layout::record_size); }
+
+    View at(size_type i) const {
+        if (i>=n) throw std::out_of_range("view_array index out of range");
+        return (*this)[i];
+    }
+
+private:
+    const char *records;
+    size_type n;
+};
+
+} // namespace tiny
+
+#ifdef HF_HAVE_MMAP
+
+/** Read-only memory mapping of a whole file. */
+
+struct mapped_file {
+    explicit mapped_file(const std::string &path) {
+        int fd=::open(path.c_str(),O_RDONLY);
+        if (fd<0) throw std::system_error(errno,std::generic_category(),"open "+path);
+
+        struct stat st;
+        if (::fstat(fd,&st)<0) {
+            int err=errno;
+            ::close(fd);
+            throw std::system_error(err,std::generic_category(),"stat "+path);
+        }
+
+        n=static_cast<std::size_t>(st.st_size);
+        if (n) {
+            p=::mmap(nullptr,n,PROT_READ,MAP_PRIVATE,fd,0);
+            if (p==MAP_FAILED) {
+                int err=errno;
+                ::close(fd);
+                throw std::system_error(err,std::generic_category(),"mmap "+path);
+            }
+        }
+        ::close(fd);
+    }
+
+    mapped_file(mapped_file &&other): p(other.p),n(other.n) {
+        other.p=nullptr;
+        other.n=0;
+    }
+
+    mapped_file &operator=(mapped_file &&other) {
+        std::swap(p,other.p);
+        std::swap(n,other.n);
+        return *this;
+    }
+
+    mapped_file(const mapped_file &) =delete;
+    mapped_file &operator=(const mapped_file &) =delete;
+
+    ~mapped_file() { if (p) ::munmap(p,n); }
+
+    const void *data() const { return p; }
+    std::size_t size() const { return n; }
+
+private:
+    void *p=nullptr;
+    std::size_t n=0;
+};
+
+#endif // def HF_HAVE_MMAP
+
+} // namespace hf
+
+#endif // ndef HF_FLAT_H_
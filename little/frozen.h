@@ -0,0 +1,319 @@
+#ifndef HF_FROZEN_H_
+#define HF_FROZEN_H_
+
+/** Immutable fixed-capacity set and map with perfect hashing.
+ *
+ * `tiny::frozen_set<Key,N>` and `tiny::frozen_map<Key,Value,N>` hold at
+ * most N keys (or entries) in inline storage, fixed at construction from
+ * an initializer list or range. Construction finds a perfect hash for
+ * the keys by hash and displace: keys are hashed into buckets of about
+ * two keys each, and for each bucket in turn, largest first, a seed is
+ * found that sends its keys to unoccupied slots of a table of at least
+ * 2N slots. A lookup then costs one hash, two table reads and a single
+ * key comparison, regardless of N.
+ *
+ * Construction is expected O(N), and is done at run time: C++11 does not
+ * permit the search to be `constexpr`. Tables should therefore be built
+ * once, e.g. as function-local statics, and shared.
+ *
+ * As with the maps, a repeated key takes the last value given for it.
+ * Construction throws `std::length_error` if there are more than N
+ * distinct keys, and `std::invalid_argument` if two distinct keys have
+ * the same hash, as then no perfect hash exists. Iteration visits the
+ * entries in order of first occurrence of their keys.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bulk.h"
+#include "equality.h"
+#include "hash_tag.h"
+#include "layout.h"
+
+namespace hf {
+
+namespace tiny {
+
+namespace impl {
+    constexpr std::size_t pow2_ceil(std::size_t n,std::size_t p=1) {
+        return p>=n? p: pow2_ceil(n,2*p);
+    }
+
+    constexpr unsigned log2_pow2(std::size_t p) {
+        return p<=1? 0: 1+log2_pow2(p/2);
+    }
+
+    template <typename Key>
+    struct identity_key {
+        const Key &operator()(const Key &k) const { return k; }
+    };
+
+    template <typename Key,typename Value>
+    struct first_key {
+        const Key &operator()(const std::pair<Key,Value> &e) const { return e.first; }
+    };
+
+    template <typename Key,typename Entry,std::size_t N,class Hash,class KeyEqual,class KeyOf>
+    struct frozen_common {
+        typedef Key key_type;
+        typedef Entry value_type;
+        typedef Hash hasher;
+        typedef KeyEqual key_equal;
+
+        typedef const value_type &const_reference;
+        typedef const_reference reference;
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        typedef const value_type *const_iterator;
+        typedef const_iterator iterator;
+
+        const_iterator begin() const { return cbegin(); }
+        const_iterator cbegin() const { return get(); }
+        const_iterator end() const { return cend(); }
+        const_iterator cend() const { return get(n); }
+
+        bool empty() const { return n==0; }
+        size_type size() const { return n; }
+        size_type max_size() const { return N; }
+
+        hasher hash_function() const { return hash; }
+        key_equal key_eq() const { return eq; }
+
+        const_iterator find(const key_type &key) const {
+            return get(find_index(key));
+        }
+
+        size_type count(const key_type &key) const {
+            return find_index(key)<n;
+        }
+
+        bool operator==(const frozen_common &b) const {
+            if (n!=b.n) return false;
+            for (const auto &x: *this) {
+                std::size_t i=b.find_index(KeyOf()(x));
+                if (i==b.n || !(x==*b.get(i))) return false;
+            }
+            return true;
+        }
+
+        bool operator!=(const frozen_common &b) const { return !(*this==b); }
+
+    protected:
+        static constexpr std::size_t n_slots=pow2_ceil(2*N);
+        static constexpr std::size_t n_buckets=pow2_ceil(N/2? N/2: 1);
+        static constexpr unsigned slot_shift=64-log2_pow2(n_slots);
+        static constexpr std::uint32_t max_seed=1u<<24;
+
+        typedef hf::impl::uint_for<N> index_type;
+
+        Hash hash;
+        KeyEqual eq;
+        size_type n=0;
+        typename std::aligned_storage<sizeof(value_type),alignof(value_type)>::type data[N];
+        index_type table[n_slots];
+        std::uint32_t seeds[n_buckets];
+
+        frozen_common(const Hash &hash_,const KeyEqual &eq_): hash(hash_),eq(eq_) {}
+
+        frozen_common(const frozen_common &other): hash(other.hash),eq(other.eq) {
+            copy_from(other);
+        }
+
+        frozen_common &operator=(const frozen_common &other) {
+            if (this!=&other) {
+                clear();
+                hash=other.hash;
+                eq=other.eq;
+                copy_from(other);
+            }
+            return *this;
+        }
+
+        ~frozen_common() { clear(); }
+
+        value_type *get(std::ptrdiff_t i=0) { return reinterpret_cast<value_type *>(data+i); }
+        const value_type *get(std::ptrdiff_t i=0) const { return reinterpret_cast<const value_type *>(data+i); }
+
+        std::uint64_t key_hash(const key_type &key) const {
+            return hf::impl::mix_hash(static_cast<std::uint64_t>(hash(key)));
+        }
+
+        static std::size_t bucket_of(std::uint64_t h) { return h&(n_buckets-1); }
+
+        static std::size_t slot_of(std::uint64_t h,std::uint32_t seed) {
+            return static_cast<std::size_t>(((h^seed)*0x9e3779b97f4a7c15ull)>>slot_shift);
+        }
+
+        std::size_t find_index(const key_type &key) const {
+            std::uint64_t h=key_hash(key);
+            std::size_t i=table[slot_of(h,seeds[bucket_of(h)])];
+            return i<n && eq(KeyOf()(*get(i)),key)? i: n;
+        }
+
+        void clear() {
+            for (size_type i=0;i<n;++i) get(i)->~value_type();
+            n=0;
+        }
+
+        void copy_from(const frozen_common &other) {
+            for (const auto &x: other) ::new(get(n++)) value_type(x);
+            std::copy(other.table,other.table+n_slots,table);
+            std::copy(other.seeds,other.seeds+n_buckets,seeds);
+        }
+
+        // Store the distinct keys of [b,e), the last value for each key
+        // winning, and build the hash table.
+        template <typename I>
+        void build(I b,I e) {
+            hf::impl::bulk_source<I,value_type> src(b,e);
+            std::size_t k=src.size();
+            auto key_at=[&](std::size_t i) -> const key_type & { return KeyOf()(src[i]); };
+            std::vector<std::size_t> pick=hf::impl::bulk_pick(k,key_at,hash_tagged<Key,Hash,KeyEqual>(hash,eq),false,hf::impl::bulk_by_hash());
+
+            std::size_t n_distinct=0;
+            for (std::size_t i=0;i<k;++i) n_distinct+=pick[i]!=hf::impl::no_pick;
+            if (n_distinct>N) throw std::length_error("container capacity exceeded");
+
+            for (std::size_t i=0;i<k;++i) {
+                if (pick[i]!=hf::impl::no_pick) ::new(get(n++)) value_type(src.take(pick[i]));
+            }
+            place();
+        }
+
+        void place() {
+            std::fill(table,table+n_slots,static_cast<index_type>(N));
+            std::fill(seeds,seeds+n_buckets,0);
+
+            std::vector<std::uint64_t> h(n);
+            std::vector<std::uint32_t> count(n_buckets);
+            for (std::size_t i=0;i<n;++i) {
+                h[i]=key_hash(KeyOf()(*get(i)));
+                ++count[bucket_of(h[i])];
+            }
+
+            // entries grouped by bucket, largest buckets first
+            std::vector<std::size_t> idx(n);
+            for (std::size_t i=0;i<n;++i) idx[i]=i;
+            std::sort(idx.begin(),idx.end(),[&](std::size_t a,std::size_t b) {
+                std::size_t ba=bucket_of(h[a]),bb=bucket_of(h[b]);
+                return count[ba]!=count[bb]? count[ba]>count[bb]: ba<bb;
+            });
+
+            std::vector<std::size_t> slots(n? count[bucket_of(h[idx[0]])]: 0);
+            for (std::size_t r=0;r<n;) {
+                std::size_t j=bucket_of(h[idx[r]]);
+                std::size_t m=count[j];
+
+                for (std::size_t a=r;a<r+m;++a) {
+                    for (std::size_t c=a+1;c<r+m;++c) {
+                        if (h[idx[a]]==h[idx[c]]) throw std::invalid_argument("keys with equal hash");
+                    }
+                }
+
+                for (std::uint32_t seed=0;;++seed) {
+                    if (seed==max_seed) throw std::runtime_error("no perfect hash found");
+
+                    std::size_t k=0;
+                    for (;k<m;++k) {
+                        std::size_t s=slot_of(h[idx[r+k]],seed);
+                        if (table[s]!=N || std::find(slots.begin(),slots.begin()+k,s)!=slots.begin()+k) break;
+                        slots[k]=s;
+                    }
+                    if (k==m) {
+                        seeds[j]=seed;
+                        for (k=0;k<m;++k) table[slots[k]]=static_cast<index_type>(idx[r+k]);
+                        break;
+                    }
+                }
+                r+=m;
+            }
+        }
+    };
+} // namespace impl
+
+template <typename Key,std::size_t N,class Hash=std::hash<Key>,class KeyEqual=std::equal_to<Key>>
+struct frozen_set: public impl::frozen_common<Key,Key,N,Hash,KeyEqual,impl::identity_key<Key>> {
+private:
+    using common=impl::frozen_common<Key,Key,N,Hash,KeyEqual,impl::identity_key<Key>>;
+
+public:
+    using value_type=typename common::value_type;
+
+    explicit frozen_set(const Hash &hash_=Hash(),const KeyEqual &eq_=KeyEqual()): common(hash_,eq_) {
+        common::place();
+    }
+
+    template <typename I>
+    frozen_set(I b,I e,const Hash &hash_=Hash(),const KeyEqual &eq_=KeyEqual()): common(hash_,eq_) {
+        common::build(b,e);
+    }
+
+    frozen_set(std::initializer_list<value_type> ilist,
+        const Hash &hash_=Hash(),const KeyEqual &eq_=KeyEqual()): common(hash_,eq_)
+    {
+        common::build(ilist.begin(),ilist.end());
+    }
+
+    frozen_set(const frozen_set &) =default;
+    frozen_set &operator=(const frozen_set &) =default;
+};
+
+template <typename Key,typename Value,std::size_t N,class Hash=std::hash<Key>,class KeyEqual=std::equal_to<Key>>
+struct frozen_map: public impl::frozen_common<Key,std::pair<Key,Value>,N,Hash,KeyEqual,impl::first_key<Key,Value>> {
+private:
+    using common=impl::frozen_common<Key,std::pair<Key,Value>,N,Hash,KeyEqual,impl::first_key<Key,Value>>;
+    using common::n;
+    using common::get;
+    using common::find_index;
+
+public:
+    using key_type=typename common::key_type;
+    using mapped_type=Value;
+    using value_type=typename common::value_type;
+
+    explicit frozen_map(const Hash &hash_=Hash(),const KeyEqual &eq_=KeyEqual()): common(hash_,eq_) {
+        common::place();
+    }
+
+    template <typename I>
+    frozen_map(I b,I e,const Hash &hash_=Hash(),const KeyEqual &eq_=KeyEqual()): common(hash_,eq_) {
+        common::build(b,e);
+    }
+
+    frozen_map(std::initializer_list<value_type> ilist,
+        const Hash &hash_=Hash(),const KeyEqual &eq_=KeyEqual()): common(hash_,eq_)
+    {
+        common::build(ilist.begin(),ilist.end());
+    }
+
+    frozen_map(const frozen_map &) =default;
+    frozen_map &operator=(const frozen_map &) =default;
+
+    const mapped_type &at(const key_type &key) const {
+        std::size_t i=find_index(key);
+        if (i<n) return get(i)->second;
+        throw std::out_of_range("missing key");
+    }
+
+    // pointer to the mapped value, or nullptr if absent
+    const mapped_type *get_ptr(const key_type &key) const {
+        std::size_t i=find_index(key);
+        return i<n? &get(i)->second: nullptr;
+    }
+};
+
+} // namespace tiny
+
+} // namespace hf
+
+#endif // ndef HF_FROZEN_H_
@@ -0,0 +1,223 @@
+#ifndef HF_HASH_TAG_H_
+#define HF_HASH_TAG_H_
+
+/** One-byte hash fingerprints for linear search containers.
+ *
+ * Supplying `hash_tagged<Key,Hash,KeyEqual>` as the `KeyEqual` parameter
+ * of `small::map` or `tiny::map` makes the container keep a 7-bit tag
+ * derived from the hash of each key in a separate byte array. Lookups
+ * first compare the tag of the query against all stored tags, sixteen
+ * at a time where SSE2 is available, and only invoke `KeyEqual` on
+ * slots with a matching tag.
+ *
+ * This pays off when key comparison is expensive (e.g. strings); for
+ * arithmetic keys the default plain linear search will be faster.
+ *
+ * `hash_tagged` is transparent, permitting heterogeneous lookup, if
+ * both `Hash` and `KeyEqual` are.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "equality.h"
+#include "layout.h"
+#include "policy.h"
+#include "relocate.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace hf {
+
+namespace impl {
+    template <typename X,typename=void>
+    struct is_transparent: std::false_type {};
+
+    template <typename X>
+    struct is_transparent<X,typename std::conditional<true,void,typename X::is_transparent>::type>: std::true_type {};
+
+    template <bool transparent>
+    struct transparent_base {};
+
+    template <>
+    struct transparent_base<true> { typedef void is_transparent; };
+} // namespace impl
+
+template <typename Key,class Hash=std::hash<Key>,class KeyEqual=std::equal_to<Key>>
+struct hash_tagged: impl::transparent_base<impl::is_transparent<Hash>::value && impl::is_transparent<KeyEqual>::value> {
+    typedef Hash hasher;
+    typedef KeyEqual key_equal;
+
+    explicit hash_tagged(const Hash &hash_=Hash(),const KeyEqual &eq_=KeyEqual())
+        : hash(hash_),eq(eq_) {}
+
+    template <typename A,typename B>
+    bool operator()(const A &a,const B &b) const { return eq(a,b); }
+
+    template <typename K>
+    std::uint8_t tag(const K &key) const {
+        // Fibonacci hashing mixes the top seven bits even for identity hashes.
+        return static_cast<std::uint8_t>((static_cast<std::uint64_t>(hash(key))*0x9e3779b97f4a7c15ull)>>57);
+    }
+
+    hasher hash_function() const { return hash; }
+    key_equal key_eq() const { return eq; }
+
+private:
+    Hash hash;
+    KeyEqual eq;
+};
+
+namespace impl {
+    template <typename E>
+    struct is_hash_tagged: std::false_type {};
+
+    template <typename Key,class Hash,class KeyEqual>
+    struct is_hash_tagged<hash_tagged<Key,Hash,KeyEqual>>: std::true_type {};
+
+    template <typename Key,class Hash,class KeyEqual>
+    struct is_default_equal<hash_tagged<Key,Hash,KeyEqual>,Key>: is_default_equal<KeyEqual,Key> {};
+
+    // Return the first index i in [0,n) with tags[i]==t and match(i) true,
+    // or n if there is none.
+    template <typename Match>
+    std::size_t match_tags(const std::uint8_t *tags,std::size_t n,std::uint8_t t,Match match) {
+        std::size_t i=0;
+#ifdef __SSE2__
+        const __m128i tv=_mm_set1_epi8(static_cast<char>(t));
+        for (;i+16<=n;i+=16) {
+            __m128i block=_mm_loadu_si128(reinterpret_cast<const __m128i *>(tags+i));
+            unsigned m=static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block,tv)));
+            while (m) {
+                std::size_t j=i+__builtin_ctz(m);
+                if (match(j)) return j;
+                m&=m-1;
+            }
+        }
+#endif
+        for (;i<n;++i) if (tags[i]==t && match(i)) return i;
+        return n;
+    }
+
+    // Tag storage for array-backed containers; the primary template is
+    // used for untagged key equality, and just performs a linear search.
+
+    template <std::size_t N,bool tagged>
+    struct tag_array {
+        template <typename E,typename K>
+        void set_tag(std::size_t,const E &,const K &) {}
+        void copy_tag(std::size_t,std::size_t) {}
+        void swap_tags(std::size_t,std::size_t) {}
+        void rotate_front(std::size_t) {}
+        void swap(tag_array &) {}
+        void copy_prefix(const tag_array &,std::size_t) {}
+        void swap_prefix(std::size_t,tag_array &,std::size_t) {}
+
+        template <typename E,typename K,typename Match>
+        std::size_t find(const E &,const K &,std::size_t n,Match match) const {
+            std::size_t i=0;
+            while (i<n && !match(i)) ++i;
+            return i;
+        }
+    };
+
+    template <std::size_t N>
+    struct tag_array<N,true> {
+        template <typename E,typename K>
+        void set_tag(std::size_t i,const E &eq,const K &key) { tags[i]=eq.tag(key); }
+        void copy_tag(std::size_t to,std::size_t from) { tags[to]=tags[from]; }
+        void swap_tags(std::size_t i,std::size_t j) { std::swap(tags[i],tags[j]); }
+        void rotate_front(std::size_t i) { rotate_to_front(tags,i); }
+        void swap(tag_array &other) { std::swap(tags,other.tags); }
+        void copy_prefix(const tag_array &other,std::size_t n) { hf::impl::copy_prefix(tags,other.tags,n); }
+        void swap_prefix(std::size_t n,tag_array &other,std::size_t m) { hf::impl::swap_prefix(tags,n,other.tags,m); }
+
+        template <typename E,typename K,typename Match>
+        std::size_t find(const E &eq,const K &key,std::size_t n,Match match) const {
+            return match_tags(tags,n,eq.tag(key),match);
+        }
+
+    private:
+        std::uint8_t tags[N];
+    };
+
+    // Holds a tag_array as a base class, so that the empty untagged
+    // array takes no space in a tiny container; accessed via `tags()`.
+    template <std::size_t N,bool tagged>
+    struct tag_array_holder: private tag_array<N,tagged> {
+        tag_array<N,tagged> &tags() { return *this; }
+        const tag_array<N,tagged> &tags() const { return *this; }
+    };
+
+    // Tag storage for vector-backed containers, kept in step with the
+    // element vector by the container.
+
+    template <class Allocator,bool tagged>
+    struct tag_vector {
+        tag_vector() =default;
+        explicit tag_vector(const Allocator &) {}
+        tag_vector(const tag_vector &,const Allocator &) {}
+        tag_vector(tag_vector &&,const Allocator &) {}
+
+        template <typename E,typename K>
+        void push_back(const E &,const K &) {}
+        void erase(std::size_t) {}
+        void copy_tag(std::size_t,std::size_t) {}
+        void swap_tags(std::size_t,std::size_t) {}
+        void rotate_front(std::size_t) {}
+        void truncate(std::size_t) {}
+        void reserve(std::size_t) {}
+        void clear() {}
+        void swap(tag_vector &) {}
+        void prefetch(std::size_t) const {}
+
+        template <typename E,typename K,typename Match>
+        std::size_t find(const E &,const K &,std::size_t n,Match match) const {
+            std::size_t i=0;
+            while (i<n && !match(i)) ++i;
+            return i;
+        }
+    };
+
+    template <class Allocator>
+    struct tag_vector<Allocator,true> {
+        tag_vector() =default;
+        explicit tag_vector(const Allocator &alloc): tags(byte_allocator(alloc)) {}
+
+        // allocator-extended copy and move, placing the tags with alloc
+        tag_vector(const tag_vector &other,const Allocator &alloc): tags(other.tags,byte_allocator(alloc)) {}
+        tag_vector(tag_vector &&other,const Allocator &alloc): tags(std::move(other.tags),byte_allocator(alloc)) {}
+
+        template <typename E,typename K>
+        void push_back(const E &eq,const K &key) { tags.push_back(eq.tag(key)); }
+        void erase(std::size_t i) { tags.erase(tags.begin()+i); }
+        void copy_tag(std::size_t to,std::size_t from) { tags[to]=tags[from]; }
+        void swap_tags(std::size_t i,std::size_t j) { std::swap(tags[i],tags[j]); }
+        void rotate_front(std::size_t i) { rotate_to_front(tags.begin(),i); }
+        void truncate(std::size_t n) { tags.resize(n); }
+        void reserve(std::size_t n) { tags.reserve(n); }
+        void clear() { tags.clear(); }
+        void swap(tag_vector &other) { std::swap(tags,other.tags); }
+        void prefetch(std::size_t n) const { prefetch_bytes(tags.data(),n); }
+
+        template <typename E,typename K,typename Match>
+        std::size_t find(const E &eq,const K &key,std::size_t n,Match match) const {
+            return match_tags(tags.data(),n,eq.tag(key),match);
+        }
+
+    private:
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<std::uint8_t> byte_allocator;
+        std::vector<std::uint8_t,byte_allocator> tags;
+    };
+} // namespace impl
+
+} // namespace hf
+
+#endif // ndef HF_HASH_TAG_H_
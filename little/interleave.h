@@ -0,0 +1,86 @@
+#ifndef HF_INTERLEAVE_H_
+#define HF_INTERLEAVE_H_
+
+/** Interleaved lookups across many containers.
+ *
+ * Probing many different containers whose storage is cold takes one
+ * cache miss after another: the container object must be read before
+ * the heap storage it points to, and that before the scan can start.
+ * The interleaved lookups take a range of queries, each a pair of a
+ * pointer to a container and a key, and overlap these misses by group
+ * prefetching. While query i is answered, the storage of query i+G is
+ * requested, its container object having been requested G queries
+ * earlier, along with that of query i+2G. With G large enough to cover
+ * the memory latency, each lookup then finds its data in cache.
+ *
+ * `for_each_interleaved<G>(first,last,fn)` calls `fn(container,key)` for
+ * each query in order; `get_ptr_interleaved<G>(first,last,out)` and
+ * `count_interleaved<G>(first,last,out)` write the result of `get_ptr`
+ * or `count` for each query to out. Any container with these methods
+ * may be used: storage is requested with its `prefetch()` method where
+ * it has one, as `small::map` and `small::multiset` do, and otherwise,
+ * as for the tiny containers with inline storage, by requesting the
+ * whole object. Query iterators need only be forward iterators.
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+#include "layout.h"
+
+namespace hf {
+
+namespace impl {
+    constexpr std::size_t default_prefetch_group=8;
+
+    template <typename C>
+    auto prefetch_storage(const C &c,int) -> decltype(c.prefetch(),void()) { c.prefetch(); }
+
+    template <typename C>
+    void prefetch_storage(const C &c,long) { prefetch_bytes(&c,sizeof(C)); }
+
+    template <typename I>
+    using query_container=typename std::remove_cv<typename std::remove_pointer<
+        typename std::remove_reference<decltype(std::declval<I>()->first)>::type>::type>::type;
+} // namespace impl
+
+template <std::size_t G=impl::default_prefetch_group,typename I,typename F>
+void for_each_interleaved(I first,I last,F fn) {
+    static_assert(G>0,"prefetch group size must be positive");
+
+    // objects requested up to query i+2G, storage up to query i+G
+    I obj=first,store=first;
+    for (std::size_t k=0;k<2*G && obj!=last;++k,++obj) __builtin_prefetch(obj->first);
+    for (std::size_t k=0;k<G && store!=last;++k,++store) impl::prefetch_storage(*store->first,0);
+
+    for (;first!=last;++first) {
+        if (obj!=last) {
+            __builtin_prefetch(obj->first);
+            ++obj;
+        }
+        if (store!=last) {
+            impl::prefetch_storage(*store->first,0);
+            ++store;
+        }
+        fn(*first->first,first->second);
+    }
+}
+
+template <std::size_t G=impl::default_prefetch_group,typename I,typename O>
+O get_ptr_interleaved(I first,I last,O out) {
+    typedef impl::query_container<I> container;
+    for_each_interleaved<G>(first,last,[&](const container &c,const typename container::key_type &key) { *out++=c.get_ptr(key); });
+    return out;
+}
+
+template <std::size_t G=impl::default_prefetch_group,typename I,typename O>
+O count_interleaved(I first,I last,O out) {
+    typedef impl::query_container<I> container;
+    for_each_interleaved<G>(first,last,[&](const container &c,const typename container::key_type &key) { *out++=c.count(key); });
+    return out;
+}
+
+} // namespace hf
+
+#endif // ndef HF_INTERLEAVE_H_
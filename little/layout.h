@@ -0,0 +1,78 @@
+#ifndef HF_LAYOUT_H_
+#define HF_LAYOUT_H_
+
+/** Compact storage for fixed-capacity containers.
+ *
+ * `uint_for<N>` is the narrowest unsigned integer type holding every
+ * value in [0,N]; the tiny containers use it for their element count,
+ * so that e.g. a `tiny::multiset<std::uint8_t,6>` spends one byte on its
+ * size rather than eight plus padding.
+ *
+ * `key_equal_holder<KeyEqual>` keeps a key equality object as a base
+ * class if it is empty and not final, so that by the empty base
+ * optimisation a stateless `std::equal_to` takes no space at all. The
+ * object is accessed through `eq()`.
+ *
+ * `prefetch_bytes(p,n)` requests the cache lines holding [p,p+n) ahead
+ * of a read, up to `max_prefetch_lines` of them; the vector-backed
+ * containers use it to provide `prefetch()` (see interleave.h).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace hf {
+
+namespace impl {
+    template <std::size_t N>
+    using uint_for=typename std::conditional<(N<=0xff),std::uint8_t,
+        typename std::conditional<(N<=0xffff),std::uint16_t,
+        typename std::conditional<(N<=0xffffffffull),std::uint32_t,std::uint64_t>::type>::type>::type;
+
+    template <typename T>
+    struct use_empty_base: std::integral_constant<bool,std::is_empty<T>::value &&
+#if __cplusplus>=201402L
+        !std::is_final<T>::value
+#else
+        !__is_final(T)
+#endif
+    > {};
+
+    template <typename KeyEqual,bool empty_base=use_empty_base<KeyEqual>::value>
+    struct key_equal_holder {
+        key_equal_holder() =default;
+        explicit key_equal_holder(const KeyEqual &eq_): eq_value(eq_) {}
+
+        KeyEqual &eq() { return eq_value; }
+        const KeyEqual &eq() const { return eq_value; }
+
+    private:
+        KeyEqual eq_value;
+    };
+
+    template <typename KeyEqual>
+    struct key_equal_holder<KeyEqual,true>: private KeyEqual {
+        key_equal_holder() =default;
+        explicit key_equal_holder(const KeyEqual &eq_): KeyEqual(eq_) {}
+
+        KeyEqual &eq() { return *this; }
+        const KeyEqual &eq() const { return *this; }
+    };
+
+    constexpr std::size_t cache_line_size=64;
+    constexpr std::size_t max_prefetch_lines=4;
+
+    inline void prefetch_bytes(const void *p,std::size_t n) {
+        if (!n) return;
+        std::uintptr_t a=reinterpret_cast<std::uintptr_t>(p)&~std::uintptr_t(cache_line_size-1);
+        std::uintptr_t e=reinterpret_cast<std::uintptr_t>(p)+n;
+        for (std::size_t i=0;i<max_prefetch_lines && a<e;++i,a+=cache_line_size) {
+            __builtin_prefetch(reinterpret_cast<const void *>(a));
+        }
+    }
+} // namespace impl
+
+} // namespace hf
+
+#endif // ndef HF_LAYOUT_H_
@@ -3,9 +3,19 @@
 
 #include <algorithm>
 #include <iterator>
+#include <stdexcept>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 
+#include "batch.h"
+#include "bulk.h"
+#include "hash_tag.h"
+#include "layout.h"
+#include "mutable_iterator.h"
+#include "policy.h"
+#include "relocate.h"
+
 /** Classes for handling small size maps with a linear search implementation.
  *
  * Implements the C++ UnorderedAssociativeContainer concept with the following exceptions:
@@ -13,15 +23,59 @@
  * 2. No hash_function() method
  * 3. No emplace_hint() method
  * 4. No get_allocator() method for tiny_map.
+ *
+ * Lookups with expensive key comparisons can be accelerated by using
+ * `hash_tagged<Key>` (see hash_tag.h) as the `KeyEqual` parameter.
+ *
+ * If `KeyEqual` defines `is_transparent`, `find`, `count`, `erase`, `at` and
+ * `operator[]` accept any key type comparable with `key_type`, without
+ * constructing a temporary `key_type` for the lookup.
+ *
+ * All maps provide a `remove_if(pred)` method and corresponding
+ * `erase_if(map,pred)` free function; both return the number of
+ * elements removed.
+ *
+ * Batched lookups `count_many`, `find_many` and `contains_many` take a
+ * range of query keys and an output iterator, to which they write one
+ * count, iterator or bool per query. They process several queries for
+ * each entry in a single pass over the map (see batch.h).
+ *
+ * Iterators are const, as entries are stored as `std::pair<Key,Value>`.
+ * For modification in place, `find_mut`, `begin_mut` and `end_mut` return
+ * a `mutable_iterator`, through which only mapped values can be written;
+ * `get_ptr(key)` returns a pointer to the mapped value, or `nullptr` if
+ * absent; `update(key,fn)` applies `fn` to the mapped value if present;
+ * and `upsert(key,init,fn)` applies `fn` to the mapped value if present,
+ * or else inserts `init`. Each is a single scan.
+ *
+ * With an `AccessPolicy` of `move_to_front` or `transpose` (see policy.h),
+ * `find`, `at`, `operator[]` and the mutable lookups above on a non-const
+ * map move the entries they find towards the front, so that frequently
+ * used keys are found sooner.
+ *
+ * Range constructors, `insert(first,last)` and `assign_unique(first,last)`
+ * take an optional `DuplicatePolicy`, `last_wins` or `first_wins` (see
+ * policy.h), to resolve repeated keys. For large ranges, keys are grouped
+ * by sorting rather than by repeated linear search (see bulk.h).
+ *
+ * Equality comparison is O(N log N) if `KeyEqual` is `std::equal_to` and
+ * keys are less-than comparable, and O(N²) otherwise; `map_hash` provides
+ * a corresponding hash (see equality.h).
  */
 
 
 namespace hf {
 
-/** Vector-backed small map */
+/** Vector-backed small map
+ *
+ * `ErasePolicy` determines if erasure preserves the order of the
+ * remaining elements, and `AccessPolicy` if lookups move the entries
+ * they find towards the front; see policy.h.
+ */
 
 namespace small {
-template <typename Key,typename Value,class KeyEqual=std::equal_to<Key>,class Allocator=std::allocator<std::pair<Key,Value>>>
+template <typename Key,typename Value,class KeyEqual=std::equal_to<Key>,class Allocator=std::allocator<std::pair<Key,Value>>,class ErasePolicy=stable_erase,
+          class AccessPolicy=static_order>
 struct map {
     typedef Key key_type;
     typedef Value mapped_type;
@@ -32,6 +86,8 @@ struct map {
     typedef const_reference reference;
 
     typedef Allocator allocator_type;
+    typedef ErasePolicy erase_policy;
+    typedef AccessPolicy access_policy;
 private:
     typedef std::vector<value_type,allocator_type> store_type;
 
@@ -41,27 +97,32 @@ public:
 
     typedef typename store_type::const_iterator const_iterator;
     typedef const_iterator iterator;
+    typedef impl::mutable_entry_iterator<Key,Value> mutable_iterator;
 
     map(const map &) =default;
     map(map &&) =default;
 
     explicit map(const KeyEqual &eq_=KeyEqual(),
-        const Allocator &alloc_=Allocator()): eq(eq_),v(alloc_) {}
+        const Allocator &alloc_=Allocator()): eq(eq_),v(alloc_),tags(alloc_) {}
 
-    explicit map(const Allocator &alloc_): v(alloc_) {}
+    explicit map(const Allocator &alloc_): v(alloc_),tags(alloc_) {}
 
     map(const map &other,const Allocator &alloc_)
-        : v(other.v,alloc_) {}
+        : v(other.v,alloc_),eq(other.eq),tags(other.tags,alloc_) {}
     map(map &&other,const Allocator &alloc_)
-        : v(std::move(other.v),alloc_) {}
+        : v(std::move(other.v),alloc_),eq(other.eq),tags(std::move(other.tags),alloc_) {}
 
     template <typename I>
     map(I b,I e,const KeyEqual &eq_=KeyEqual(),
-        const Allocator &alloc_=Allocator()): eq(eq_),v(alloc_) { insert(b,e); }
+        const Allocator &alloc_=Allocator()): eq(eq_),v(alloc_),tags(alloc_) { insert(b,e); }
+
+    template <typename I,typename DuplicatePolicy,typename=impl::if_duplicate_policy<DuplicatePolicy>>
+    map(I b,I e,DuplicatePolicy policy,const KeyEqual &eq_=KeyEqual(),
+        const Allocator &alloc_=Allocator()): eq(eq_),v(alloc_),tags(alloc_) { insert(b,e,policy); }
 
     map(std::initializer_list<value_type> ilist,
         const KeyEqual &eq_=KeyEqual(),const Allocator &alloc_=Allocator())
-        : eq(eq_),v(alloc_) { insert(ilist); }
+        : eq(eq_),v(alloc_),tags(alloc_) { insert(ilist); }
 
     map &operator=(const map &) =default;
     map &operator=(map &&) =default;
@@ -71,21 +132,32 @@ public:
 
     const_iterator end() const { return cend(); }
     const_iterator cend() const { return v.cend(); }
+
+    mutable_iterator begin_mut() { return mutable_iterator(v.data()); }
+    mutable_iterator end_mut() { return mutable_iterator(v.data()+v.size()); }
     
     bool empty() const { return v.empty(); }
     size_type size() const { return v.size(); }
     size_type max_size() const { return v.max_size(); }
 
-    void clear() { v.clear(); }
+    // request the entries (and hash tags) into cache ahead of a lookup
+    void prefetch() const {
+        impl::prefetch_bytes(v.data(),v.size()*sizeof(value_type));
+        tags.prefetch(v.size());
+    }
+
+    void clear() {
+        v.clear();
+        tags.clear();
+    }
 
     iterator insert(const value_type &value) {
         auto where=find_in_store(value.first);
         if (where==v.end()) {
-            v.push_back(value);
-            return std::prev(v.end());
+            return append(value);
         }
         else {
-            *where=value;
+            where->second=value.second;
             return where;
         }
     }
@@ -93,22 +165,32 @@ public:
     iterator insert(value_type &&value) {
         auto where=find_in_store(value.first);
         if (where==v.end()) {
-            v.push_back(std::move(value));
-            return std::prev(v.end());
+            return append(std::move(value));
         }
         else {
-            *where=std::move(value);
+            where->second=std::move(value.second);
             return where;
         }
     }
 
     template <typename I>
     void insert(I b,I e) {
-        while (b!=e) insert(*b++);
+        insert(b,e,last_wins());
+    }
+
+    template <typename I,typename DuplicatePolicy,typename=impl::if_duplicate_policy<DuplicatePolicy>>
+    void insert(I b,I e,DuplicatePolicy) {
+        bulk_insert(b,e,std::is_same<DuplicatePolicy,first_wins>::value,impl::bulk_method<KeyEqual,Key>());
     }
     
     void insert(std::initializer_list<value_type> ilist) {
-        for (const auto &x: ilist) insert(x);
+        insert(ilist.begin(),ilist.end());
+    }
+
+    template <typename I,typename DuplicatePolicy=last_wins,typename=impl::if_duplicate_policy<DuplicatePolicy>>
+    void assign_unique(I b,I e,DuplicatePolicy policy=DuplicatePolicy()) {
+        clear();
+        insert(b,e,policy);
     }
 
     template <typename... Args>
@@ -117,58 +199,203 @@ public:
         auto where=find(kv.first);
         if (where!=end()) return std::make_pair(where,false);
 
-        v.push_back(std::move(kv));
-        return std::make_pair(std::prev(v.end()),true);
+        return std::make_pair(append(std::move(kv)),true);
+    }
+
+    template <typename... Args>
+    std::pair<iterator,bool> try_emplace(const key_type &key,Args &&... args) {
+        auto where=find(key);
+        if (where!=end()) return std::make_pair(where,false);
+
+        return std::make_pair(append(std::piecewise_construct,std::forward_as_tuple(key),
+            std::forward_as_tuple(std::forward<Args>(args)...)),true);
+    }
+
+    template <typename... Args>
+    std::pair<iterator,bool> try_emplace(key_type &&key,Args &&... args) {
+        auto where=find(key);
+        if (where!=end()) return std::make_pair(where,false);
+
+        return std::make_pair(append(std::piecewise_construct,std::forward_as_tuple(std::move(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...)),true);
+    }
+
+    template <typename M>
+    std::pair<iterator,bool> insert_or_assign(const key_type &key,M &&obj) {
+        auto where=find_in_store(key);
+        if (where!=v.end()) {
+            where->second=std::forward<M>(obj);
+            return std::make_pair(where,false);
+        }
+
+        return std::make_pair(append(key,std::forward<M>(obj)),true);
+    }
+
+    template <typename M>
+    std::pair<iterator,bool> insert_or_assign(key_type &&key,M &&obj) {
+        auto where=find_in_store(key);
+        if (where!=v.end()) {
+            where->second=std::forward<M>(obj);
+            return std::make_pair(where,false);
+        }
+
+        return std::make_pair(append(std::move(key),std::forward<M>(obj)),true);
     }
 
     iterator erase(const_iterator pos) {
-        return v.erase(pos);
+        return erase_at(pos,erase_policy());
     }
 
     size_type erase(const key_type &key) {
-        auto where=find(key);
-        if (where==end()) return 0;
+        return erase_key(key);
+    }
 
-        erase(where);
-        return 1;
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent,
+              typename=typename std::enable_if<!std::is_convertible<K,const_iterator>::value>::type>
+    size_type erase(const K &key) {
+        return erase_key(key);
+    }
+
+    template <typename Pred>
+    size_type remove_if(Pred pred) {
+        return compact(pred,erase_policy());
     }
 
     void swap(map &other) {
         std::swap(v,other.v);
+        tags.swap(other.tags);
     }
 
     size_type count(const key_type &key) const {
         return find(key)!=end();
     }
 
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    size_type count(const K &key) const {
+        return find(key)!=end();
+    }
+
     iterator find(const key_type &key) const {
         return find_in_store(key);
     }
 
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    iterator find(const K &key) const {
+        return find_in_store(key);
+    }
+
+    iterator find(const key_type &key) {
+        return promote_(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    iterator find(const K &key) {
+        return promote_(key);
+    }
+
+    mutable_iterator find_mut(const key_type &key) {
+        return mutable_iterator(v.data()+promote_index(key));
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    mutable_iterator find_mut(const K &key) {
+        return mutable_iterator(v.data()+promote_index(key));
+    }
+
+    mapped_type *get_ptr(const key_type &key) {
+        return get_ptr_(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    mapped_type *get_ptr(const K &key) {
+        return get_ptr_(key);
+    }
+
+    const mapped_type *get_ptr(const key_type &key) const {
+        return get_ptr_(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    const mapped_type *get_ptr(const K &key) const {
+        return get_ptr_(key);
+    }
+
+    template <typename F>
+    bool update(const key_type &key,F fn) {
+        return update_(key,fn);
+    }
+
+    template <typename K,typename F,typename E=KeyEqual,typename=typename E::is_transparent>
+    bool update(const K &key,F fn) {
+        return update_(key,fn);
+    }
+
+    template <typename V,typename F>
+    mapped_type &upsert(const key_type &key,V &&init,F fn) {
+        return upsert_(key,std::forward<V>(init),fn);
+    }
+
+    template <typename V,typename F>
+    mapped_type &upsert(key_type &&key,V &&init,F fn) {
+        return upsert_(std::move(key),std::forward<V>(init),fn);
+    }
+
+    template <typename I,typename O>
+    O count_many(I first,I last,O out) const {
+        std::size_t n=v.size();
+        impl::find_many(n,key_at(),eq,first,last,[&](std::size_t i) { *out++=size_type(i!=n); });
+        return out;
+    }
+
+    template <typename I,typename O>
+    O find_many(I first,I last,O out) const {
+        impl::find_many(v.size(),key_at(),eq,first,last,[&](std::size_t i) { *out++=v.begin()+i; });
+        return out;
+    }
+
+    template <typename I,typename O>
+    O contains_many(I first,I last,O out) const {
+        std::size_t n=v.size();
+        impl::find_many(n,key_at(),eq,first,last,[&](std::size_t i) { *out++=i!=n; });
+        return out;
+    }
+
     mapped_type &operator[](const Key &key) {
-        auto where=find_in_store(key);
+        auto where=promote_(key);
         if (where!=v.end()) return where->second;
-        v.emplace_back(std::piecewise_construct,std::forward_as_tuple(key),std::tuple<>());
-        return std::prev(v.end())->second;
+        return append(std::piecewise_construct,std::forward_as_tuple(key),std::tuple<>())->second;
     }
 
     mapped_type &operator[](Key &&key) {
-        auto where=find_in_store(key);
+        auto where=promote_(key);
         if (where!=v.end()) return where->second;
-        v.emplace_back(std::piecewise_construct,std::forward_as_tuple(std::move(key)),std::tuple<>());
-        return std::prev(v.end())->second;
+        return append(std::piecewise_construct,std::forward_as_tuple(std::move(key)),std::tuple<>())->second;
     }
 
-    mapped_type &at(const Key &key) {
-        auto where=find_in_store(key);
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent,
+              typename=typename std::enable_if<!std::is_same<typename std::decay<K>::type,Key>::value>::type>
+    mapped_type &operator[](K &&key) {
+        auto where=promote_(key);
         if (where!=v.end()) return where->second;
-        throw std::out_of_range("missing key");
+        return append(std::piecewise_construct,std::forward_as_tuple(std::forward<K>(key)),std::tuple<>())->second;
+    }
+
+    mapped_type &at(const Key &key) {
+        return at_(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    mapped_type &at(const K &key) {
+        return at_(key);
     }
 
     const mapped_type &at(const Key &key) const {
-        auto where=find_in_store(key);
-        if (where!=v.end()) return where->second;
-        throw std::out_of_range("missing key");
+        return at_(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    const mapped_type &at(const K &key) const {
+        return at_(key);
     }
 
     KeyEqual key_eq() const { return eq; }
@@ -176,8 +403,90 @@ public:
 
     friend bool operator==(const map &a,const map &b) {
         if (a.size()!=b.size()) return false;
+        return a.equal_(b,impl::use_sorted_equality<KeyEqual,Key>());
+    }
+
+    friend bool operator!=(const map &a,const map &b) {
+        return !(a==b);
+    }
+
+private:
+    store_type v;
+    KeyEqual eq;
+    impl::tag_vector<Allocator,impl::is_hash_tagged<KeyEqual>::value> tags;
+
+    template <typename K>
+    std::size_t find_index(const K &key) const {
+        return tags.find(eq,key,v.size(),[&](std::size_t i) { return eq(v[i].first,key); });
+    }
+
+    template <typename K>
+    typename store_type::const_iterator find_in_store(const K &key) const {
+        return v.begin()+find_index(key);
+    }
+
+    template <typename K>
+    typename store_type::iterator find_in_store(const K &key) {
+        return v.begin()+find_index(key);
+    }
+
+    // find, moving a match towards the front per the access policy
+    template <typename K>
+    std::size_t promote_index(const K &key) {
+        std::size_t i=find_index(key);
+        if (i<v.size()) {
+            i=impl::promote(i,access_policy(),
+                [this](std::size_t a,std::size_t b) { std::swap(v[a],v[b]); tags.swap_tags(a,b); },
+                [this](std::size_t j) { impl::rotate_to_front(v.begin(),j); tags.rotate_front(j); });
+        }
+        return i;
+    }
+
+    template <typename K>
+    typename store_type::iterator promote_(const K &key) {
+        return v.begin()+promote_index(key);
+    }
+
+    template <typename K>
+    mapped_type *get_ptr_(const K &key) {
+        std::size_t i=promote_index(key);
+        return i<v.size()? &v[i].second: nullptr;
+    }
+
+    template <typename K>
+    const mapped_type *get_ptr_(const K &key) const {
+        std::size_t i=find_index(key);
+        return i<v.size()? &v[i].second: nullptr;
+    }
+
+    template <typename K,typename F>
+    bool update_(const K &key,F &fn) {
+        mapped_type *p=get_ptr_(key);
+        if (!p) return false;
+        fn(*p);
+        return true;
+    }
+
+    template <typename K,typename V,typename F>
+    mapped_type &upsert_(K &&key,V &&init,F &fn) {
+        std::size_t i=promote_index(key);
+        if (i<v.size()) {
+            fn(v[i].second);
+            return v[i].second;
+        }
+        return append(std::forward<K>(key),std::forward<V>(init))->second;
+    }
+
+    struct key_at_index {
+        const value_type *data;
+        const key_type &operator()(std::size_t i) const { return data[i].first; }
+    };
+
+    key_at_index key_at() const { return key_at_index{v.data()}; }
+
+    bool equal_(const map &b,std::false_type) const {
         auto bend=b.end();
-        for (const auto &e: a) {
+        for (const auto &e: v) {
             auto bi=b.find(e.first);
             if (bi==bend || e.second!=bi->second) return false;
         }
@@ -185,34 +494,155 @@ public:
         return true;
     }
 
-    friend bool operator!=(const map &a,const map &b) {
-        return !(a==b);
+    bool equal_(const map &b,std::true_type) const {
+        std::size_t n=v.size();
+        if (n<impl::sorted_equality_threshold) return equal_(b,std::false_type());
+
+        std::vector<const value_type *> scratch(2*n);
+        return impl::sorted_equal(v.data(),b.v.data(),n,scratch.data(),impl::less_entry_key(),impl::equal_entry());
     }
 
-private:
-    store_type v;
-    KeyEqual eq;
+    // construct a new entry at the end of the store; caller guarantees
+    // its key is not already present
+    template <typename... Args>
+    typename store_type::iterator append(Args &&... args) {
+        v.emplace_back(std::forward<Args>(args)...);
+        tags.push_back(eq,v.back().first);
+        return std::prev(v.end());
+    }
+
+    // insert an entry only if its key is absent
+    void insert_first(const value_type &value) {
+        if (find_in_store(value.first)==v.end()) append(value);
+    }
+
+    void insert_first(value_type &&value) {
+        if (find_in_store(value.first)==v.end()) append(std::move(value));
+    }
+
+    template <typename I>
+    void bulk_insert(I b,I e,bool first,impl::bulk_by_scan) {
+        for (;b!=e;++b) {
+            if (first) insert_first(*b);
+            else insert(*b);
+        }
+    }
+
+    template <typename I,typename Method>
+    void bulk_insert(I b,I e,bool first,Method method) {
+        std::size_t m=v.size();
+        std::size_t hint=impl::range_size_hint(b,e);
+        if (hint!=impl::no_pick && m+hint<impl::bulk_threshold(method)) {
+            bulk_insert(b,e,first,impl::bulk_by_scan());
+            return;
+        }
 
-    typename store_type::const_iterator find_in_store(const key_type &key) const {
-        auto b=v.begin();
-        auto e=v.end();
-        while (b!=e) if (eq(b->first,key)) break; else ++b;
-        return b;
+        impl::bulk_source<I,value_type> src(b,e);
+        std::size_t n=src.size();
+        auto key_at=[&](std::size_t i) -> const key_type & { return i<m? v[i].first: src[i-m].first; };
+        std::vector<std::size_t> pick=impl::bulk_pick(m+n,key_at,eq,first,method);
+
+        std::size_t n_new=0;
+        for (std::size_t i=m;i<m+n;++i) n_new+=pick[i]!=impl::no_pick;
+
+        for (std::size_t i=0;i<m;++i) {
+            if (pick[i]!=i) v[i].second=src.take(pick[i]-m).second;
+        }
+
+        v.reserve(m+n_new);
+        tags.reserve(m+n_new);
+        for (std::size_t i=m;i<m+n;++i) {
+            if (pick[i]!=impl::no_pick) append(src.take(pick[i]-m));
+        }
+    }
+
+    template <typename K>
+    size_type erase_key(const K &key) {
+        auto where=find_in_store(key);
+        if (where==v.end()) return 0;
+
+        erase(where);
+        return 1;
+    }
+
+    iterator erase_at(const_iterator pos,stable_erase) {
+        tags.erase(pos-v.cbegin());
+        return v.erase(pos);
     }
 
-    typename store_type::iterator find_in_store(const key_type &key) {
-        auto b=v.begin();
-        auto e=v.end();
-        while (b!=e) if (eq(b->first,key)) break; else ++b;
-        return b;
+    iterator erase_at(const_iterator pos,unordered_erase) {
+        std::size_t i=pos-v.cbegin(),last=v.size()-1;
+        if (i!=last) {
+            v[i]=std::move(v[last]);
+            tags.copy_tag(i,last);
+        }
+        v.pop_back();
+        tags.truncate(last);
+        return pos;
+    }
+
+    template <typename Pred>
+    size_type compact(Pred pred,stable_erase) {
+        std::size_t n=v.size(),j=0;
+        for (std::size_t i=0;i<n;++i) {
+            if (pred(static_cast<const value_type &>(v[i]))) continue;
+            if (i!=j) {
+                v[j]=std::move(v[i]);
+                tags.copy_tag(j,i);
+            }
+            ++j;
+        }
+        v.erase(v.begin()+j,v.end());
+        tags.truncate(j);
+        return n-j;
+    }
+
+    template <typename Pred>
+    size_type compact(Pred pred,unordered_erase) {
+        std::size_t orig_n=v.size(),n=orig_n;
+        for (std::size_t i=0;i<n;) {
+            if (pred(static_cast<const value_type &>(v[i]))) {
+                if (i!=--n) {
+                    v[i]=std::move(v[n]);
+                    tags.copy_tag(i,n);
+                }
+            }
+            else ++i;
+        }
+        v.erase(v.begin()+n,v.end());
+        tags.truncate(n);
+        return orig_n-n;
+    }
+
+    template <typename K>
+    mapped_type &at_(const K &key) {
+        auto where=promote_(key);
+        if (where!=v.end()) return where->second;
+        throw std::out_of_range("missing key");
+    }
+
+    template <typename K>
+    const mapped_type &at_(const K &key) const {
+        auto where=find_in_store(key);
+        if (where!=v.end()) return where->second;
+        throw std::out_of_range("missing key");
     }
 };
 
+template <typename Key,typename Value,class KeyEqual,class Allocator,class ErasePolicy,class AccessPolicy,typename Pred>
+typename map<Key,Value,KeyEqual,Allocator,ErasePolicy,AccessPolicy>::size_type
+erase_if(map<Key,Value,KeyEqual,Allocator,ErasePolicy,AccessPolicy> &m,Pred pred) {
+    return m.remove_if(pred);
+}
+
 } // namespace small
 
 /** Array-backed small map with fixed max capacity.
  *
- * Note that capcity is not checked when inserting elements.
+ * Behaviour on inserting into a full map is determined by
+ * `OverflowPolicy`; by default, capacity is not checked. As for
+ * `small::map`, `AccessPolicy` determines if lookups reorder entries.
+ * See policy.h.
  */
 
 namespace tiny {
@@ -221,12 +651,15 @@ namespace impl {
     // common functionality across tiny_map classes with trivial
     // and non-trivial value types.
 
-    template <typename Key,typename Value,std::size_t N,class KeyEqual>
-    struct tiny_map_common {
+    template <typename Key,typename Value,std::size_t N,class KeyEqual,class OverflowPolicy,class AccessPolicy>
+    struct tiny_map_common: protected hf::impl::key_equal_holder<KeyEqual>,
+                            protected hf::impl::tag_array_holder<N,hf::impl::is_hash_tagged<KeyEqual>::value> {
         typedef Key key_type;
         typedef std::pair<Key,Value> value_type;
         typedef Value mapped_type;
         typedef KeyEqual key_equal;
+        typedef OverflowPolicy overflow_policy;
+        typedef AccessPolicy access_policy;
 
         typedef const value_type &const_reference;
         typedef const_reference reference;
@@ -236,11 +669,12 @@ namespace impl {
 
         typedef const value_type *const_iterator;
         typedef const_iterator iterator;
+        typedef hf::impl::mutable_entry_iterator<Key,Value> mutable_iterator;
 
         tiny_map_common() =default;
-        tiny_map_common(const KeyEqual &eq_): eq(eq_) {}
+        tiny_map_common(const KeyEqual &eq_): hf::impl::key_equal_holder<KeyEqual>(eq_) {}
 
-        key_equal key_eq() const { return eq; }
+        key_equal key_eq() const { return eq(); }
 
         const_iterator begin() const { return cbegin(); }
         const_iterator cbegin() const { return get(); }
@@ -248,6 +682,9 @@ namespace impl {
         const_iterator end() const { return cend(); }
         const_iterator cend() const { return get()+n; }
 
+        mutable_iterator begin_mut() { return mutable_iterator(get()); }
+        mutable_iterator end_mut() { return mutable_iterator(get(n)); }
+
         bool empty() const { return n==0; }
         size_type size() const { return n; }
         size_type max_size() const { return N; }
@@ -256,28 +693,157 @@ namespace impl {
             return find(key)!=end();
         }
 
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        size_type count(const K &key) const {
+            return find(key)!=end();
+        }
+
         iterator find(const key_type &key) const {
             return find_(key);
         }
 
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        iterator find(const K &key) const {
+            return find_(key);
+        }
+
+        iterator find(const key_type &key) {
+            return promote_(key);
+        }
+
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        iterator find(const K &key) {
+            return promote_(key);
+        }
+
+        mutable_iterator find_mut(const key_type &key) {
+            return mutable_iterator(promote_(key));
+        }
+
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        mutable_iterator find_mut(const K &key) {
+            return mutable_iterator(promote_(key));
+        }
+
+        mapped_type *get_ptr(const key_type &key) {
+            return get_ptr_(key);
+        }
+
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        mapped_type *get_ptr(const K &key) {
+            return get_ptr_(key);
+        }
+
+        const mapped_type *get_ptr(const key_type &key) const {
+            return get_ptr_(key);
+        }
+
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        const mapped_type *get_ptr(const K &key) const {
+            return get_ptr_(key);
+        }
+
+        template <typename F>
+        bool update(const key_type &key,F fn) {
+            return update_(key,fn);
+        }
+
+        template <typename K,typename F,typename E=KeyEqual,typename=typename E::is_transparent>
+        bool update(const K &key,F fn) {
+            return update_(key,fn);
+        }
+
+        template <typename V,typename F>
+        mapped_type &upsert(const key_type &key,V &&init,F fn) {
+            return upsert_(key,std::forward<V>(init),fn);
+        }
+
+        template <typename V,typename F>
+        mapped_type &upsert(key_type &&key,V &&init,F fn) {
+            return upsert_(std::move(key),std::forward<V>(init),fn);
+        }
+
+        template <typename I,typename O>
+        O count_many(I first,I last,O out) const {
+            std::size_t n_=n;
+            hf::impl::find_many(n_,key_at(),eq(),first,last,[&](std::size_t i) { *out++=size_type(i!=n_); });
+            return out;
+        }
+
+        template <typename I,typename O>
+        O find_many(I first,I last,O out) const {
+            hf::impl::find_many(n,key_at(),eq(),first,last,[&](std::size_t i) { *out++=begin()+i; });
+            return out;
+        }
+
+        template <typename I,typename O>
+        O contains_many(I first,I last,O out) const {
+            std::size_t n_=n;
+            hf::impl::find_many(n_,key_at(),eq(),first,last,[&](std::size_t i) { *out++=i!=n_; });
+            return out;
+        }
+
         template <typename... Args>
         std::pair<iterator,bool> emplace(Args &&... args) {
             value_type kv(std::forward<Args>(args)...);
             auto where=find(kv.first);
             if (where!=end()) return std::make_pair(where,false);
 
-            ::new(get(n)) value_type(std::move(kv));
-            return std::make_pair(begin()+n++,true);
+            where=append(std::move(kv));
+            return std::make_pair(where,where!=end());
+        }
+
+        template <typename... Args>
+        std::pair<iterator,bool> try_emplace(const key_type &key,Args &&... args) {
+            auto where=find(key);
+            if (where!=end()) return std::make_pair(where,false);
+
+            where=append(std::piecewise_construct,std::forward_as_tuple(key),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+            return std::make_pair(where,where!=end());
+        }
+
+        template <typename... Args>
+        std::pair<iterator,bool> try_emplace(key_type &&key,Args &&... args) {
+            auto where=find(key);
+            if (where!=end()) return std::make_pair(where,false);
+
+            where=append(std::piecewise_construct,std::forward_as_tuple(std::move(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+            return std::make_pair(where,where!=end());
+        }
+
+        template <typename M>
+        std::pair<iterator,bool> insert_or_assign(const key_type &key,M &&obj) {
+            auto where=find_(key);
+            if (where!=end()) {
+                where->second=std::forward<M>(obj);
+                return std::make_pair(where,false);
+            }
+
+            where=append(key,std::forward<M>(obj));
+            return std::make_pair(where,where!=end());
+        }
+
+        template <typename M>
+        std::pair<iterator,bool> insert_or_assign(key_type &&key,M &&obj) {
+            auto where=find_(key);
+            if (where!=end()) {
+                where->second=std::forward<M>(obj);
+                return std::make_pair(where,false);
+            }
+
+            where=append(std::move(key),std::forward<M>(obj));
+            return std::make_pair(where,where!=end());
         }
 
         iterator insert(const value_type &value) {
             auto where=find_(value.first);
             if (where==end()) {
-                ::new(get(n)) value_type(value);
-                return begin()+n++;
+                return append(value);
             }
             else {
-                *where=value;
+                where->second=value.second;
                 return where;
             }
         }
@@ -285,53 +851,110 @@ namespace impl {
         iterator insert(value_type &&value) {
             auto where=find_(value.first);
             if (where==end()) {
-                ::new(get(n)) value_type(std::move(value));
-                return begin()+n++;
+                return append(std::move(value));
             }
             else {
-                *where=value;
+                where->second=std::move(value.second);
                 return where;
             }
         }
 
         template <typename I>
         void insert(I b,I e) {
-            while (b!=e) insert(*b++);
+            insert(b,e,last_wins());
+        }
+
+        template <typename I,typename DuplicatePolicy,typename=hf::impl::if_duplicate_policy<DuplicatePolicy>>
+        void insert(I b,I e,DuplicatePolicy) {
+            bulk_insert(b,e,std::is_same<DuplicatePolicy,first_wins>::value,hf::impl::bulk_method<KeyEqual,Key>());
         }
 
         void insert(std::initializer_list<value_type> ilist) {
             insert(ilist.begin(),ilist.end());
         }
 
+        std::pair<iterator,bool> try_insert(const value_type &value) {
+            auto where=find(value.first);
+            if (where!=end() || n==N) return std::make_pair(where,false);
+            return std::make_pair(construct(value),true);
+        }
+
+        std::pair<iterator,bool> try_insert(value_type &&value) {
+            auto where=find(value.first);
+            if (where!=end() || n==N) return std::make_pair(where,false);
+            return std::make_pair(construct(std::move(value)),true);
+        }
+
         mapped_type &operator[](const Key &key) {
-            auto where=find_(key);
+            auto where=promote_(key);
             if (where!=end()) return where->second;
-            ::new(get(n)) value_type(std::piecewise_construct,std::forward_as_tuple(key),std::tuple<>());
-            return get(n++)->second;
+            return append_ref(std::piecewise_construct,std::forward_as_tuple(key),std::tuple<>())->second;
         }
 
         mapped_type &operator[](Key &&key) {
-            auto where=find_(key);
+            auto where=promote_(key);
             if (where!=end()) return where->second;
-            ::new(get(n)) value_type(std::piecewise_construct,std::forward_as_tuple(std::move(key)),std::tuple<>());
-            return get(n++)->second;
+            return append_ref(std::piecewise_construct,std::forward_as_tuple(std::move(key)),std::tuple<>())->second;
         }
 
-        mapped_type &at(const Key &key) {
-            auto where=find_(key);
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent,
+                  typename=typename std::enable_if<!std::is_same<typename std::decay<K>::type,Key>::value>::type>
+        mapped_type &operator[](K &&key) {
+            auto where=promote_(key);
             if (where!=end()) return where->second;
-            throw std::out_of_range("missing key");
+            return append_ref(std::piecewise_construct,std::forward_as_tuple(std::forward<K>(key)),std::tuple<>())->second;
+        }
+
+        mapped_type &at(const Key &key) {
+            return at_(key);
+        }
+
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        mapped_type &at(const K &key) {
+            return at_(key);
         }
 
         const mapped_type &at(const Key &key) const {
-            auto where=find_(key);
-            if (where!=end()) return where->second;
-            throw std::out_of_range("missing key");
+            return at_(key);
+        }
+
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        const mapped_type &at(const K &key) const {
+            return at_(key);
         }
 
         bool operator==(const tiny_map_common &b) const {
             if (size()!=b.size()) return false;
+            return equal_(b,hf::impl::use_sorted_equality<KeyEqual,Key>());
+        }
+
+        bool operator!=(const tiny_map_common &b) const {
+            return !(*this==b);
+        }
+
+    protected:
+        using hf::impl::key_equal_holder<KeyEqual>::eq;
+        using hf::impl::tag_array_holder<N,hf::impl::is_hash_tagged<KeyEqual>::value>::tags;
 
+        typename std::aligned_storage<sizeof(value_type),alignof(value_type)>::type data[N];
+        hf::impl::uint_for<N> n=0;
+
+        value_type *get(std::ptrdiff_t i=0) { return reinterpret_cast<value_type *>(data+i); }
+        const value_type *get(std::ptrdiff_t i=0) const { return reinterpret_cast<const value_type *>(data+i); }
+
+        template <typename K>
+        std::size_t find_index(const K &key) const {
+            return tags().find(eq(),key,n,[&](std::size_t i) { return eq()(get(i)->first,key); });
+        }
+
+        struct key_at_index {
+            const value_type *data;
+            const key_type &operator()(std::size_t i) const { return data[i].first; }
+        };
+
+        key_at_index key_at() const { return key_at_index{get()}; }
+
+        bool equal_(const tiny_map_common &b,std::false_type) const {
             auto bend=b.end();
             for (const auto &e: *this) {
                 auto bi=b.find(e.first);
@@ -341,52 +964,206 @@ namespace impl {
             return true;
         }
 
-        bool operator!=(const tiny_map_common &b) const {
-            return !(*this==b);
+        bool equal_(const tiny_map_common &b,std::true_type) const {
+            if (n<hf::impl::sorted_equality_threshold) return equal_(b,std::false_type());
+
+            const value_type *scratch[2*N];
+            return hf::impl::sorted_equal(get(),b.get(),n,scratch,hf::impl::less_entry_key(),hf::impl::equal_entry());
         }
 
-    protected:
-        typename std::aligned_storage<sizeof(value_type),alignof(value_type)>::type data[N];
-        size_t n=0;
-        KeyEqual eq;
+        // construct a new entry in the next free slot, subject to the
+        // overflow policy; caller guarantees its key is not already
+        // present. Returns end() if the policy rejects the insertion.
+        template <typename... Args>
+        value_type *append(Args &&... args) {
+            if (!hf::impl::make_room(n,N,overflow_policy(),[this]() { evict(access_policy()); })) return get(n);
+            return construct(std::forward<Args>(args)...);
+        }
 
-        value_type *get(std::ptrdiff_t i=0) { return reinterpret_cast<value_type *>(data+i); }
-        const value_type *get(std::ptrdiff_t i=0) const { return reinterpret_cast<const value_type *>(data+i); }
+        // insert an entry only if its key is absent
+        void insert_first(const value_type &value) {
+            if (find_(value.first)==end()) append(value);
+        }
 
-        const value_type *find_(const Key &key) const {
-            for (std::ptrdiff_t i=0;i<n;++i) if (eq(get(i)->first,key)) return get(i);
-            return get(n);
+        void insert_first(value_type &&value) {
+            if (find_(value.first)==end()) append(std::move(value));
         }
 
-        value_type *find_(const Key &key) {
-            for (std::ptrdiff_t i=0;i<n;++i) if (eq(get(i)->first,key)) return get(i);
-            return get(n);
+        template <typename I>
+        void bulk_insert(I b,I e,bool first,hf::impl::bulk_by_scan) {
+            for (;b!=e;++b) {
+                if (first) insert_first(*b);
+                else insert(*b);
+            }
+        }
+
+        // entries are inserted one at a time, subject to the overflow
+        // policy, if the result would not fit
+        template <typename I,typename Method>
+        void bulk_insert(I b,I e,bool first,Method method) {
+            std::size_t m=n;
+            std::size_t hint=hf::impl::range_size_hint(b,e);
+            if (hint!=hf::impl::no_pick && m+hint<hf::impl::bulk_threshold(method)) {
+                bulk_insert(b,e,first,hf::impl::bulk_by_scan());
+                return;
+            }
+
+            hf::impl::bulk_source<I,value_type> src(b,e);
+            std::size_t k=src.size();
+            auto key_at=[&](std::size_t i) -> const key_type & { return i<m? get(i)->first: src[i-m].first; };
+            std::vector<std::size_t> pick=hf::impl::bulk_pick(m+k,key_at,eq(),first,method);
+
+            std::size_t n_new=0;
+            for (std::size_t i=m;i<m+k;++i) n_new+=pick[i]!=hf::impl::no_pick;
+
+            if (m+n_new>N) {
+                for (std::size_t j=0;j<k;++j) {
+                    if (first) insert_first(src.take(j));
+                    else insert(src.take(j));
+                }
+                return;
+            }
+
+            for (std::size_t i=0;i<m;++i) {
+                if (pick[i]!=i) get(i)->second=src.take(pick[i]-m).second;
+            }
+            for (std::size_t i=m;i<m+k;++i) {
+                if (pick[i]!=hf::impl::no_pick) construct(src.take(pick[i]-m));
+            }
+        }
+
+        // as append, for callers returning a reference to the new entry
+        template <typename... Args>
+        value_type *append_ref(Args &&... args) {
+            value_type *where=append(std::forward<Args>(args)...);
+            if (std::is_same<overflow_policy,fail_overflow>::value && where==get(n)) {
+                throw std::length_error("container capacity exceeded");
+            }
+            return where;
+        }
+
+        template <typename... Args>
+        value_type *construct(Args &&... args) {
+            ::new(get(n)) value_type(std::forward<Args>(args)...);
+            tags().set_tag(n,eq(),get(n)->first);
+            return get(n++);
+        }
+
+        // remove the first entry, preserving the order of the rest
+        void evict(static_order) {
+            value_type *x=get();
+            for (size_type i=1;i<n;++i) {
+                x[i-1]=std::move(x[i]);
+                tags().copy_tag(i-1,i);
+            }
+            x[n-1].~value_type();
+            --n;
+        }
+
+        // with a reordering access policy, the last entry is the coldest
+        template <typename P>
+        void evict(P) {
+            get(n-1)->~value_type();
+            --n;
+        }
+
+        template <typename K>
+        const value_type *find_(const K &key) const {
+            return get(find_index(key));
+        }
+
+        template <typename K>
+        value_type *find_(const K &key) {
+            return get(find_index(key));
+        }
+
+        // find, moving a match towards the front per the access policy
+        template <typename K>
+        value_type *promote_(const K &key) {
+            std::size_t i=find_index(key);
+            if (i<n) {
+                value_type *x=get();
+                i=hf::impl::promote(i,access_policy(),
+                    [this,x](std::size_t a,std::size_t b) { std::swap(x[a],x[b]); tags().swap_tags(a,b); },
+                    [this,x](std::size_t j) { hf::impl::rotate_to_front(x,j); tags().rotate_front(j); });
+            }
+            return get(i);
+        }
+
+        template <typename K>
+        mapped_type *get_ptr_(const K &key) {
+            value_type *where=promote_(key);
+            return where!=end()? &where->second: nullptr;
+        }
+
+        template <typename K>
+        const mapped_type *get_ptr_(const K &key) const {
+            const value_type *where=find_(key);
+            return where!=end()? &where->second: nullptr;
+        }
+
+        template <typename K,typename F>
+        bool update_(const K &key,F &fn) {
+            mapped_type *p=get_ptr_(key);
+            if (!p) return false;
+            fn(*p);
+            return true;
+        }
+
+        template <typename K,typename V,typename F>
+        mapped_type &upsert_(K &&key,V &&init,F &fn) {
+            value_type *where=promote_(key);
+            if (where!=end()) {
+                fn(where->second);
+                return where->second;
+            }
+            return append_ref(std::forward<K>(key),std::forward<V>(init))->second;
+        }
+
+        template <typename K>
+        mapped_type &at_(const K &key) {
+            auto where=promote_(key);
+            if (where!=end()) return where->second;
+            throw std::out_of_range("missing key");
+        }
+
+        template <typename K>
+        const mapped_type &at_(const K &key) const {
+            auto where=find_(key);
+            if (where!=end()) return where->second;
+            throw std::out_of_range("missing key");
         }
     };
 
 } // namesapce impl
 
-// tiny_map with trivial value type
-template <typename Key,typename Value,std::size_t N,class KeyEqual=std::equal_to<Key>,bool trivial=std::is_trivially_copyable<Key>::value>
-struct map: public impl::tiny_map_common<Key,Value,N,KeyEqual> {
+// tiny_map with trivially copyable key and mapped types
+template <typename Key,typename Value,std::size_t N,class KeyEqual=std::equal_to<Key>,class OverflowPolicy=unchecked_overflow,
+          class AccessPolicy=static_order,
+          bool trivial=std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value>
+struct map: public impl::tiny_map_common<Key,Value,N,KeyEqual,OverflowPolicy,AccessPolicy> {
 private:
-    using common=impl::tiny_map_common<Key,Value,N,KeyEqual>;
+    using common=impl::tiny_map_common<Key,Value,N,KeyEqual,OverflowPolicy,AccessPolicy>;
     using common::get;
     using common::find_;
     using common::data;
     using common::n;
     using common::eq;
+    using common::tags;
 
 public:
     using key_type=typename common::key_type;
     using value_type=typename common::value_type;
     using key_equal=typename common::key_equal;
+    using overflow_policy=typename common::overflow_policy;
+    using access_policy=typename common::access_policy;
     using reference=typename common::reference;
     using const_reference=typename common::const_reference;
     using size_type=typename common::size_type;
     using difference_type=typename common::difference_type;
     using iterator=typename common::iterator;
     using const_iterator=typename common::const_iterator;
+    using mutable_iterator=typename common::mutable_iterator;
 
     using common::begin;
     using common::end;
@@ -401,30 +1178,76 @@ public:
         insert(b,e);
     }
 
+    template <typename I,typename DuplicatePolicy,typename=hf::impl::if_duplicate_policy<DuplicatePolicy>>
+    map(I b,I e,DuplicatePolicy policy,const KeyEqual &eq_=KeyEqual()): common(eq_) {
+        insert(b,e,policy);
+    }
+
     map(std::initializer_list<value_type> ilist,
         const KeyEqual &eq_=KeyEqual()) : common(eq_)
     {
         insert(ilist);
     }
 
-    map(const map &) =default;
-    map(map &&) =default;
-    map &operator=(const map &) =default;
-    map &operator=(map &&) =default;
+    // copies and swaps touch only the live entries
+    map(const map &other): common(other.eq()) {
+        copy_from(other);
+    }
+
+    map &operator=(const map &other) {
+        if (this!=&other) {
+            eq()=other.eq();
+            copy_from(other);
+        }
+        return *this;
+    }
 
     void clear() { n=0; }
 
+    template <typename I,typename DuplicatePolicy=last_wins,typename=hf::impl::if_duplicate_policy<DuplicatePolicy>>
+    void assign_unique(I b,I e,DuplicatePolicy policy=DuplicatePolicy()) {
+        clear();
+        insert(b,e,policy);
+    }
+
     iterator erase(const_iterator pos) {
         value_type *x=get(pos-begin());
         value_type *last=get(n-1);
 
-        // trivial copy-ctor and dtor on Key
+        // trivial copy-ctor and dtor on Key and Value
         *x=*last;
+        tags().copy_tag(x-get(),n-1);
         --n;
         return pos;
     }
 
     size_type erase(const key_type &key) {
+        return erase_key(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent,
+              typename=typename std::enable_if<!std::is_convertible<K,const_iterator>::value>::type>
+    size_type erase(const K &key) {
+        return erase_key(key);
+    }
+
+    void swap(map &other) {
+        hf::impl::swap_prefix(data,n,other.data,other.n);
+        tags().swap_prefix(n,other.tags(),other.n);
+        std::swap(n,other.n);
+    }
+
+    template <typename Pred>
+    size_type remove_if(Pred pred) {
+        size_t orig_n=n;
+        auto b=begin();
+        while (b!=end()) if (pred(*b)) b=erase(b); else ++b;
+        return orig_n-n;
+    }
+
+private:
+    template <typename K>
+    size_type erase_key(const K &key) {
         auto where=find_(key);
         if (where==end()) return 0;
 
@@ -432,33 +1255,38 @@ public:
         return 1;
     }
 
-    void swap(map &other) {
-        std::swap(data,other.data);
-        std::swap(n,other.n);
+    void copy_from(const map &other) {
+        hf::impl::copy_prefix(data,other.data,other.n);
+        tags().copy_prefix(other.tags(),other.n);
+        n=other.n;
     }
 };
 
-// map with non-trivial value type
-template <typename Key,typename Value,std::size_t N,class KeyEqual>
-struct map<Key,Value,N,KeyEqual,false>: public impl::tiny_map_common<Key,Value,N,KeyEqual>  {
+// map with non-trivial key or mapped type
+template <typename Key,typename Value,std::size_t N,class KeyEqual,class OverflowPolicy,class AccessPolicy>
+struct map<Key,Value,N,KeyEqual,OverflowPolicy,AccessPolicy,false>: public impl::tiny_map_common<Key,Value,N,KeyEqual,OverflowPolicy,AccessPolicy>  {
 private:
-    using common=impl::tiny_map_common<Key,Value,N,KeyEqual>;
+    using common=impl::tiny_map_common<Key,Value,N,KeyEqual,OverflowPolicy,AccessPolicy>;
     using common::get;
     using common::find_;
     using common::data;
     using common::n;
     using common::eq;
+    using common::tags;
 
 public:
     using key_type=typename common::key_type;
     using value_type=typename common::value_type;
     using key_equal=typename common::key_equal;
+    using overflow_policy=typename common::overflow_policy;
+    using access_policy=typename common::access_policy;
     using reference=typename common::reference;
     using const_reference=typename common::const_reference;
     using size_type=typename common::size_type;
     using difference_type=typename common::difference_type;
     using iterator=typename common::iterator;
     using const_iterator=typename common::const_iterator;
+    using mutable_iterator=typename common::mutable_iterator;
 
     using common::begin;
     using common::end;
@@ -473,24 +1301,31 @@ public:
         insert(b,e);
     }
 
+    template <typename I,typename DuplicatePolicy,typename=hf::impl::if_duplicate_policy<DuplicatePolicy>>
+    map(I b,I e,DuplicatePolicy policy,const KeyEqual &eq_=KeyEqual()): common(eq_) {
+        insert(b,e,policy);
+    }
+
     map(std::initializer_list<value_type> ilist,
         const KeyEqual &eq_=KeyEqual()) : common(eq_)
     {
         insert(ilist);
     }
 
-    map(const map &other): common(other.eq) {
+    map(const map &other): common(other.eq()) {
         for (const auto &x: other) ::new(get(n++)) value_type(x);
+        tags()=other.tags();
     }
 
-    map(map &&other) {
-        for (auto &x: other) ::new(get(n++)) value_type(std::move(x));
+    map(map &&other): common(other.eq()) {
+        take(other,relocatable());
     }
 
     map &operator=(const map &other) {
         if (this!=&other) {
             clear();
             for (const auto &x: other) ::new(get(n++)) value_type(x);
+            tags()=other.tags();
         }
         return *this;
     }
@@ -498,7 +1333,7 @@ public:
     map &operator=(map &&other) {
         if (this!=&other) {
             clear();
-            for (auto &x: other) ::new(get(n++)) value_type(std::move(x));
+            take(other,relocatable());
         }
         return *this;
     }
@@ -510,17 +1345,50 @@ public:
         n=0;
     }
 
-    iterator erase(const_iterator pos) {
-        value_type *x=get(pos-begin());
-        value_type *last=get(n-1);
+    template <typename I,typename DuplicatePolicy=last_wins,typename=hf::impl::if_duplicate_policy<DuplicatePolicy>>
+    void assign_unique(I b,I e,DuplicatePolicy policy=DuplicatePolicy()) {
+        clear();
+        insert(b,e,policy);
+    }
 
-        std::swap(*x,*last);
-        last->~value_type();
-        --n;
+    iterator erase(const_iterator pos) {
+        erase_at(get(pos-begin()),relocatable());
         return pos;
     }
 
     size_type erase(const key_type &key) {
+        return erase_key(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent,
+              typename=typename std::enable_if<!std::is_convertible<K,const_iterator>::value>::type>
+    size_type erase(const K &key) {
+        return erase_key(key);
+    }
+
+    void swap(map &other) {
+        std::size_t nmin=std::min(n,other.n);
+        for (std::size_t i=0;i<nmin;++i) std::swap(*get(i),*(other.get(i)));
+        if (n>nmin) hf::impl::relocate(other.get(nmin),get(nmin),n-nmin);
+        else hf::impl::relocate(get(nmin),other.get(nmin),other.n-nmin);
+        tags().swap(other.tags());
+        std::swap(n,other.n);
+    }
+
+    template <typename Pred>
+    size_type remove_if(Pred pred) {
+        size_t orig_n=n;
+        auto b=begin();
+        while (b!=end()) if (pred(*b)) b=erase(b); else ++b;
+        return orig_n-n;
+    }
+
+private:
+    // entries with trivially relocatable types are moved with memcpy
+    typedef hf::is_trivially_relocatable<value_type> relocatable;
+
+    template <typename K>
+    size_type erase_key(const K &key) {
         auto where=find_(key);
         if (where==end()) return 0;
 
@@ -528,22 +1396,43 @@ public:
         return 1;
     }
 
-    void swap(map &other) {
-        std::ptrdiff_t i=0;
-        std::ptrdiff_t nmin=std::min(n,other.n);
-        for (std::ptrdiff_t i=0;i<nmin;++i) std::swap(*get(i),*(other.get(i)));
-        for (std::ptrdiff_t i=nmin;i<n;++i) {
-            ::new(other.get(i)) value_type(std::move(*get(i)));
-            get(i)->~value_type();
-        }
-        for (std::ptrdiff_t i=nmin;i<other.n;++i) {
-            ::new(get(i)) value_type(std::move(*other.get(i)));
-            other.get(i)->~value_type();
-        }
-        std::swap(n,other.n);
+    // move the entries of other into this empty map; relocation leaves
+    // other empty
+    void take(map &other,std::true_type) {
+        hf::impl::relocate(get(),other.get(),other.n);
+        n=other.n;
+        other.n=0;
+        tags()=other.tags();
+    }
+
+    void take(map &other,std::false_type) {
+        for (size_type i=0;i<other.n;++i) ::new(get(n++)) value_type(std::move(*other.get(i)));
+        tags()=other.tags();
+    }
+
+    // remove x, filling its slot with the last entry
+    void erase_at(value_type *x,std::true_type) {
+        value_type *last=get(n-1);
+        x->~value_type();
+        if (x!=last) hf::impl::relocate(x,last,1);
+        tags().copy_tag(x-get(),n-1);
+        --n;
+    }
+
+    void erase_at(value_type *x,std::false_type) {
+        value_type *last=get(n-1);
+        std::swap(*x,*last);
+        last->~value_type();
+        tags().copy_tag(x-get(),n-1);
+        --n;
     }
 };
 
+template <typename Key,typename Value,std::size_t N,class KeyEqual,class OverflowPolicy,class AccessPolicy,bool trivial,typename Pred>
+std::size_t erase_if(map<Key,Value,N,KeyEqual,OverflowPolicy,AccessPolicy,trivial> &m,Pred pred) {
+    return m.remove_if(pred);
+}
+
 } // namespace tiny
 } // namespace hf
 
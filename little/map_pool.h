@@ -0,0 +1,288 @@
+#ifndef HF_MAP_POOL_H_
+#define HF_MAP_POOL_H_
+
+/** Columnar storage for many tiny maps.
+ *
+ * `tiny::map_pool<Key,Value,N>` holds any number of small maps, each of
+ * at most N entries, addressed by a `handle` (an index). Rather than
+ * an array of separate `tiny::map` objects, the pool keeps three slabs:
+ * the keys of all maps, the values of all maps, and the entry counts,
+ * with the keys (and values) of each map in a contiguous run of N. A
+ * lookup then scans only a map's keys, with no padding between keys
+ * and values, and the count of entries takes the narrowest type that
+ * holds N (see layout.h).
+ *
+ * `pool[h]` returns a `map_ref` through which a map is used as a
+ * `tiny::map`: `size`, `count`, `get_ptr`, `at`, `operator[]`, `insert`
+ * (which assigns if the key is present), `try_insert`, `erase`, `clear`
+ * and `for_each`. Erasure moves the last entry into the erased slot,
+ * and insertion into a full map follows `OverflowPolicy` (see policy.h).
+ *
+ * `add()` appends an empty map and returns its handle, and `resize`
+ * sets the number of maps. `clear_all()` empties every map and
+ * `for_each(fn)` visits every entry of every map, each in one pass over
+ * the slabs. Handles stay valid as maps are added; references to keys
+ * and values are invalidated when the pool grows.
+ *
+ * Slots beyond a map's size hold unspecified values, so `Key` and
+ * `Value` must be default constructible and copy assignable.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "layout.h"
+#include "policy.h"
+
+namespace hf {
+
+namespace tiny {
+
+template <typename Key,typename Value,std::size_t N,class KeyEqual=std::equal_to<Key>,class OverflowPolicy=unchecked_overflow>
+struct map_pool: protected hf::impl::key_equal_holder<KeyEqual> {
+    typedef Key key_type;
+    typedef Value mapped_type;
+    typedef KeyEqual key_equal;
+    typedef OverflowPolicy overflow_policy;
+    typedef std::size_t size_type;
+    typedef std::size_t handle;
+
+    static constexpr size_type map_capacity=N;
+
+    struct map_ref;
+    struct const_map_ref;
+
+    explicit map_pool(size_type n_maps=0,const KeyEqual &eq_=KeyEqual()): hf::impl::key_equal_holder<KeyEqual>(eq_) {
+        resize(n_maps);
+    }
+
+    key_equal key_eq() const { return eq(); }
+
+    // number of maps
+    size_type size() const { return counts.size(); }
+    bool empty() const { return counts.empty(); }
+
+    map_ref operator[](handle h) { return map_ref(this,h); }
+    const_map_ref operator[](handle h) const { return const_map_ref(this,h); }
+
+    handle add() {
+        handle h=size();
+        resize(h+1);
+        return h;
+    }
+
+    void resize(size_type n_maps) {
+        keys.resize(n_maps*N);
+        values.resize(n_maps*N);
+        counts.resize(n_maps,0);
+    }
+
+    void reserve(size_type n_maps) {
+        keys.reserve(n_maps*N);
+        values.reserve(n_maps*N);
+        counts.reserve(n_maps);
+    }
+
+    // bytes of storage held for the maps
+    size_type memory_usage() const {
+        return keys.capacity()*sizeof(Key)+values.capacity()*sizeof(Value)+counts.capacity()*sizeof(count_type);
+    }
+
+    // empty every map
+    void clear_all() { std::fill(counts.begin(),counts.end(),count_type(0)); }
+
+    // call fn(h,key,value) for each entry of each map h
+    template <typename F>
+    void for_each(F fn) {
+        for (handle h=0;h<size();++h) {
+            for (size_type i=h*N,e=i+counts[h];i<e;++i) fn(h,const_cast<const Key &>(keys[i]),values[i]);
+        }
+    }
+
+    template <typename F>
+    void for_each(F fn) const {
+        for (handle h=0;h<size();++h) {
+            for (size_type i=h*N,e=i+counts[h];i<e;++i) fn(h,keys[i],values[i]);
+        }
+    }
+
+    // A single map of the pool; cheap to copy, and valid while the pool
+    // is not destroyed.
+
+    struct const_map_ref {
+        const_map_ref(const map_pool *p_,handle h_): p(p_),h(h_) {}
+
+        size_type size() const { return p->counts[h]; }
+        bool empty() const { return size()==0; }
+        size_type max_size() const { return N; }
+
+        size_type count(const key_type &key) const { return p->index_of(h,key)!=npos; }
+
+        // pointer to the value mapped to key, or nullptr if absent
+        const mapped_type *get_ptr(const key_type &key) const {
+            return p->find_value(h,key);
+        }
+
+        const mapped_type &at(const key_type &key) const {
+            const mapped_type *v=get_ptr(key);
+            if (!v) throw std::out_of_range("missing key");
+            return *v;
+        }
+
+        // call fn(key,value) for each entry
+        template <typename F>
+        void for_each(F fn) const {
+            for (size_type i=h*N,e=i+size();i<e;++i) fn(p->keys[i],p->values[i]);
+        }
+
+    private:
+        const map_pool *p;
+        handle h;
+    };
+
+    struct map_ref {
+        map_ref(map_pool *p_,handle h_): p(p_),h(h_) {}
+
+        operator const_map_ref() const { return const_map_ref(p,h); }
+
+        size_type size() const { return p->counts[h]; }
+        bool empty() const { return size()==0; }
+        size_type max_size() const { return N; }
+
+        size_type count(const key_type &key) const { return p->index_of(h,key)!=npos; }
+
+        mapped_type *get_ptr(const key_type &key) const {
+            return p->find_value(h,key);
+        }
+
+        mapped_type &at(const key_type &key) const {
+            mapped_type *v=get_ptr(key);
+            if (!v) throw std::out_of_range("missing key");
+            return *v;
+        }
+
+        mapped_type &operator[](const key_type &key) const {
+            size_type i=p->index_of(h,key);
+            if (i==npos) {
+                i=p->append(h,key,mapped_type());
+                if (i==npos) throw std::length_error("container capacity exceeded");
+            }
+            return p->values[i];
+        }
+
+        // Map key to value, assigning if key is present. Returns true if
+        // an entry was added; false if key was present, or if the map
+        // was full and the overflow policy is fail_overflow.
+        bool insert(const key_type &key,const mapped_type &value) const {
+            size_type i=p->index_of(h,key);
+            if (i!=npos) {
+                p->values[i]=value;
+                return false;
+            }
+            return p->append(h,key,value)!=npos;
+        }
+
+        // Add an entry only if key is absent and the map is not full;
+        // returns true if added.
+        bool try_insert(const key_type &key,const mapped_type &value) const {
+            if (size()==N || p->index_of(h,key)!=npos) return false;
+            return p->append(h,key,value)!=npos;
+        }
+
+        size_type erase(const key_type &key) const {
+            size_type i=p->index_of(h,key);
+            if (i==npos) return 0;
+
+            size_type last=h*N+p->counts[h]-1;
+            if (i!=last) {
+                p->keys[i]=p->keys[last];
+                p->values[i]=p->values[last];
+            }
+            --p->counts[h];
+            return 1;
+        }
+
+        void clear() const { p->counts[h]=0; }
+
+        template <typename F>
+        void for_each(F fn) const {
+            for (size_type i=h*N,e=i+size();i<e;++i) fn(const_cast<const Key &>(p->keys[i]),p->values[i]);
+        }
+
+    private:
+        map_pool *p;
+        handle h;
+    };
+
+private:
+    using hf::impl::key_equal_holder<KeyEqual>::eq;
+
+    typedef hf::impl::uint_for<N> count_type;
+    static constexpr size_type npos=static_cast<size_type>(-1);
+
+    std::vector<Key> keys;
+    std::vector<Value> values;
+    std::vector<count_type> counts;
+
+    // slab index of key in map h, or npos
+    //
+    // All N slots are scanned, so that the scan need not wait on the
+    // entry count, which lies in a third slab: the first match is live
+    // only if it lies within the count, as live keys are distinct and
+    // precede all stale ones.
+    size_type index_of(handle h,const key_type &key) const {
+        const Key *k=keys.data()+h*N;
+        for (size_type i=0;i<N;++i) {
+            if (eq()(k[i],key)) return i<counts[h]? h*N+i: npos;
+        }
+        return npos;
+    }
+
+    // Pointer to the value mapped to key in map h, or nullptr. The values
+    // of the map lie in a different slab from its keys: fetch them while
+    // the keys are scanned.
+    mapped_type *find_value(handle h,const key_type &key) {
+        return const_cast<mapped_type *>(static_cast<const map_pool *>(this)->find_value(h,key));
+    }
+
+    const mapped_type *find_value(handle h,const key_type &key) const {
+        const Value *v=values.data()+h*N;
+        __builtin_prefetch(v);
+        size_type i=index_of(h,key);
+        return i==npos? nullptr: values.data()+i;
+    }
+
+    // add an entry to map h as the overflow policy permits, returning
+    // its slab index, or npos if not added
+    size_type append(handle h,const key_type &key,const mapped_type &value) {
+        size_type b=h*N;
+        auto evict=[&]() {
+            // remove the oldest entry, preserving the order of the rest
+            std::move(keys.begin()+b+1,keys.begin()+b+N,keys.begin()+b);
+            std::move(values.begin()+b+1,values.begin()+b+N,values.begin()+b);
+            --counts[h];
+        };
+        if (!hf::impl::make_room(counts[h],N,overflow_policy(),evict)) return npos;
+
+        size_type i=b+counts[h]++;
+        keys[i]=key;
+        values[i]=value;
+        return i;
+    }
+};
+
+template <typename Key,typename Value,std::size_t N,class KeyEqual,class OverflowPolicy>
+constexpr std::size_t map_pool<Key,Value,N,KeyEqual,OverflowPolicy>::map_capacity;
+
+template <typename Key,typename Value,std::size_t N,class KeyEqual,class OverflowPolicy>
+constexpr std::size_t map_pool<Key,Value,N,KeyEqual,OverflowPolicy>::npos;
+
+} // namespace tiny
+
+} // namespace hf
+
+#endif // ndef HF_MAP_POOL_H_
@@ -6,6 +6,12 @@
 #include <type_traits>
 #include <vector>
 
+#include "batch.h"
+#include "equality.h"
+#include "layout.h"
+#include "policy.h"
+#include "relocate.h"
+
 /** Classes for handling small size multisets with a linear search implementation.
  *
  * Unlike a sorted container backed implementation, this has fast inserts (O(1))
@@ -16,15 +22,42 @@
  * 2. No hash_function() method
  * 3. No emplace_hint() method
  * 4. No get_allocator() method for tiny_multiset.
+ *
+ * If `KeyEqual` defines `is_transparent`, `find`, `count` and `erase` accept
+ * any key type comparable with `key_type`, without constructing a temporary
+ * `key_type` for the lookup.
+ *
+ * All containers provide a `remove_if(pred)` method and corresponding
+ * `erase_if(container,pred)` free function; both return the number of
+ * elements removed.
+ *
+ * Batched lookups `count_many`, `find_many` and `contains_many` take a
+ * range of query keys and an output iterator, to which they write one
+ * count, iterator or bool per query. They process several queries for
+ * each element in a single pass over the container (see batch.h).
+ *
+ * With an `AccessPolicy` of `move_to_front` or `transpose` (see policy.h),
+ * `find` on a non-const container moves the element it finds towards the
+ * front, so that frequently used keys are found sooner.
+ *
+ * Equality comparison is O(N log N) if `KeyEqual` is `std::equal_to` and
+ * keys are less-than comparable, and O(N²) otherwise; `multiset_hash`
+ * provides a corresponding hash (see equality.h).
  */
 
 namespace hf {
 
 namespace small {
 
-/** Vector-backed small multiset */
+/** Vector-backed small multiset
+ *
+ * `ErasePolicy` determines if erasure preserves the order of the
+ * remaining elements, and `AccessPolicy` if `find` moves the elements
+ * it finds towards the front; see policy.h.
+ */
 
-template <typename Key,class KeyEqual=std::equal_to<Key>,class Allocator=std::allocator<Key>>
+template <typename Key,class KeyEqual=std::equal_to<Key>,class Allocator=std::allocator<Key>,class ErasePolicy=stable_erase,
+          class AccessPolicy=static_order>
 struct multiset {
     typedef Key key_type;
     typedef key_type value_type;
@@ -34,6 +67,8 @@ struct multiset {
     typedef const_reference reference;
 
     typedef Allocator allocator_type;
+    typedef ErasePolicy erase_policy;
+    typedef AccessPolicy access_policy;
 private:
     typedef std::vector<key_type,allocator_type> store_type;
 
@@ -78,6 +113,9 @@ public:
     size_type size() const { return v.size(); }
     size_type max_size() const { return v.max_size(); }
 
+    // request the elements into cache ahead of a lookup
+    void prefetch() const { impl::prefetch_bytes(v.data(),v.size()*sizeof(value_type)); }
+
     void clear() { v.clear(); }
 
     iterator insert(const value_type &value) {
@@ -106,14 +144,22 @@ public:
     }
 
     iterator erase(const_iterator pos) {
-        return v.erase(pos);
+        return erase_at(pos,erase_policy());
     }
 
     size_type erase(const key_type &key) {
-        size_t n=0;
-        auto b=v.begin();
-        while (b!=v.end()) if (eq(*b,key)) b=v.erase(b),++n; else ++b;
-        return n;
+        return erase_key(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent,
+              typename=typename std::enable_if<!std::is_convertible<K,const_iterator>::value>::type>
+    size_type erase(const K &key) {
+        return erase_key(key);
+    }
+
+    template <typename Pred>
+    size_type remove_if(Pred pred) {
+        return compact(pred,erase_policy());
     }
 
     void swap(multiset &other) {
@@ -121,23 +167,56 @@ public:
     }
 
     size_type count(const key_type &key) const {
-        size_type c=0;
-        for (const auto &k: v) c+=static_cast<bool>(eq(k,key));
-        return c;
+        return count_(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    size_type count(const K &key) const {
+        return count_(key);
     }
 
     iterator find(const key_type &key) const {
-        auto b=v.begin();
-        auto e=v.end();
-        while (b!=e) if (eq(*b,key)) break; else ++b;
-        return b;
+        return find_(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    iterator find(const K &key) const {
+        return find_(key);
+    }
+
+    iterator find(const key_type &key) {
+        return promote_(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+    iterator find(const K &key) {
+        return promote_(key);
+    }
+
+    template <typename I,typename O>
+    O count_many(I first,I last,O out) const {
+        return impl::count_many(v.size(),key_at(),eq,first,last,out);
+    }
+
+    template <typename I,typename O>
+    O find_many(I first,I last,O out) const {
+        impl::find_many(v.size(),key_at(),eq,first,last,[&](std::size_t i) { *out++=v.begin()+i; });
+        return out;
+    }
+
+    template <typename I,typename O>
+    O contains_many(I first,I last,O out) const {
+        std::size_t n=v.size();
+        impl::find_many(n,key_at(),eq,first,last,[&](std::size_t i) { *out++=i!=n; });
+        return out;
     }
 
     KeyEqual key_eq() const { return eq; }
     Allocator get_allocator() const { return v.get_allocator(); }
 
     friend bool operator==(const multiset &a,const multiset &b) {
-        return std::is_permutation(a.begin(),a.end(),b.begin(),a.eq);
+        if (a.size()!=b.size()) return false;
+        return a.equal_(b,impl::use_sorted_equality<KeyEqual,Key>());
     }
 
     friend bool operator!=(const multiset &a,const multiset &b) {
@@ -147,26 +226,120 @@ public:
 private:
     store_type v;
     KeyEqual eq;
+
+    template <typename K>
+    size_type erase_key(const K &key) {
+        return compact([&](const value_type &x) { return eq(x,key); },erase_policy());
+    }
+
+    iterator erase_at(const_iterator pos,stable_erase) {
+        return v.erase(pos);
+    }
+
+    iterator erase_at(const_iterator pos,unordered_erase) {
+        auto x=v.begin()+(pos-v.cbegin());
+        if (x!=std::prev(v.end())) *x=std::move(v.back());
+        v.pop_back();
+        return pos;
+    }
+
+    template <typename Pred>
+    size_type compact(Pred pred,stable_erase) {
+        auto b=std::remove_if(v.begin(),v.end(),pred);
+        size_type n=v.end()-b;
+        v.erase(b,v.end());
+        return n;
+    }
+
+    template <typename Pred>
+    size_type compact(Pred pred,unordered_erase) {
+        size_type orig_n=v.size(),n=orig_n;
+        for (size_type i=0;i<n;) {
+            if (pred(v[i])) {
+                if (i!=--n) v[i]=std::move(v[n]);
+            }
+            else ++i;
+        }
+        v.erase(v.begin()+n,v.end());
+        return orig_n-n;
+    }
+
+    template <typename K>
+    size_type count_(const K &key) const {
+        size_type c=0;
+        for (const auto &k: v) c+=static_cast<bool>(eq(k,key));
+        return c;
+    }
+
+    template <typename K>
+    const_iterator find_(const K &key) const {
+        auto b=v.begin();
+        auto e=v.end();
+        while (b!=e) if (eq(*b,key)) break; else ++b;
+        return b;
+    }
+
+    // find, moving a match towards the front per the access policy
+    template <typename K>
+    const_iterator promote_(const K &key) {
+        size_type i=find_(key)-v.cbegin();
+        if (i==v.size()) return v.cend();
+
+        i=impl::promote(i,access_policy(),
+            [this](size_type a,size_type b) { std::swap(v[a],v[b]); },
+            [this](size_type j) { impl::rotate_to_front(v.begin(),j); });
+        return v.cbegin()+i;
+    }
+
+    struct key_at_index {
+        const key_type *data;
+        const key_type &operator()(std::size_t i) const { return data[i]; }
+    };
+
+    key_at_index key_at() const { return key_at_index{v.data()}; }
+
+    bool equal_(const multiset &b,std::false_type) const {
+        return std::is_permutation(v.begin(),v.end(),b.v.begin(),eq);
+    }
+
+    bool equal_(const multiset &b,std::true_type) const {
+        std::size_t n=v.size();
+        if (n<impl::sorted_equality_threshold) return equal_(b,std::false_type());
+
+        std::vector<const key_type *> scratch(2*n);
+        return impl::sorted_equal(v.data(),b.v.data(),n,scratch.data(),impl::less_key(),impl::equal_key());
+    }
 };
 
+template <typename Key,class KeyEqual,class Allocator,class ErasePolicy,class AccessPolicy,typename Pred>
+typename multiset<Key,KeyEqual,Allocator,ErasePolicy,AccessPolicy>::size_type
+erase_if(multiset<Key,KeyEqual,Allocator,ErasePolicy,AccessPolicy> &c,Pred pred) {
+    return c.remove_if(pred);
+}
+
 } // namespace small
 
 namespace tiny {
 
 /** Array-backed small multiset with fixed max capacity.
  *
- * Note that capcity is not checked when inserting elements.
+ * Behaviour on inserting into a full multiset is determined by
+ * `OverflowPolicy`; by default, capacity is not checked. As for
+ * `small::multiset`, `AccessPolicy` determines if `find` reorders
+ * elements. See policy.h.
  */
 
 namespace impl {
     // common functionality across tiny_multiset classes with trivial
     // and non-trivial value types.
 
-    template <typename Key,std::size_t N,class KeyEqual>
-    struct tiny_multiset_common {
+    template <typename Key,std::size_t N,class KeyEqual,class OverflowPolicy,class AccessPolicy>
+    struct tiny_multiset_common: protected hf::impl::key_equal_holder<KeyEqual> {
         typedef Key key_type;
         typedef key_type value_type;
         typedef KeyEqual key_equal;
+        typedef OverflowPolicy overflow_policy;
+        typedef AccessPolicy access_policy;
 
         typedef const value_type &const_reference;
         typedef const_reference reference;
@@ -178,9 +351,9 @@ namespace impl {
         typedef const_iterator iterator;
 
         tiny_multiset_common() =default;
-        tiny_multiset_common(const KeyEqual &eq_): eq(eq_) {}
+        tiny_multiset_common(const KeyEqual &eq_): hf::impl::key_equal_holder<KeyEqual>(eq_) {}
 
-        key_equal key_eq() const { return eq; }
+        key_equal key_eq() const { return eq(); }
 
         const_iterator begin() const { return cbegin(); }
         const_iterator cbegin() const { return get(); }
@@ -193,22 +366,64 @@ namespace impl {
         size_type max_size() const { return N; }
 
         size_type count(const key_type &key) const {
-            size_type c=0;
-            for (const auto &k: *this) c+=static_cast<bool>(eq(k,key));
-            return c;
+            return count_(key);
+        }
+
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        size_type count(const K &key) const {
+            return count_(key);
         }
 
         iterator find(const key_type &key) const {
-            auto b=begin();
-            auto e=end();
-            while (b!=e) if (eq(*b,key)) break; else ++b;
-            return b;
+            return find_(key);
+        }
+
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        iterator find(const K &key) const {
+            return find_(key);
+        }
+
+        iterator find(const key_type &key) {
+            return promote_(key);
+        }
+
+        template <typename K,typename E=KeyEqual,typename=typename E::is_transparent>
+        iterator find(const K &key) {
+            return promote_(key);
+        }
+
+        template <typename I,typename O>
+        O count_many(I first,I last,O out) const {
+            return hf::impl::count_many(n,key_at(),eq(),first,last,out);
+        }
+
+        template <typename I,typename O>
+        O find_many(I first,I last,O out) const {
+            hf::impl::find_many(n,key_at(),eq(),first,last,[&](std::size_t i) { *out++=begin()+i; });
+            return out;
+        }
+
+        template <typename I,typename O>
+        O contains_many(I first,I last,O out) const {
+            std::size_t n_=n;
+            hf::impl::find_many(n_,key_at(),eq(),first,last,[&](std::size_t i) { *out++=i!=n_; });
+            return out;
         }
 
         template <typename... Args>
         iterator emplace(Args &&... args) {
-            ::new(get(n)) value_type(std::forward<Args>(args)...);
-            return begin()+(n++);
+            if (!hf::impl::make_room(n,N,overflow_policy(),[this]() { evict(access_policy()); })) return end();
+            return construct(std::forward<Args>(args)...);
+        }
+
+        std::pair<iterator,bool> try_insert(const value_type &value) {
+            if (n==N) return std::make_pair(end(),false);
+            return std::make_pair(construct(value),true);
+        }
+
+        std::pair<iterator,bool> try_insert(value_type &&value) {
+            if (n==N) return std::make_pair(end(),false);
+            return std::make_pair(construct(std::move(value)),true);
         }
 
         iterator insert(const value_type &value) {
@@ -229,7 +444,8 @@ namespace impl {
         }
 
         bool operator==(const tiny_multiset_common &b) const {
-            return std::is_permutation(begin(),end(),b.begin(),eq);
+            if (n!=b.n) return false;
+            return equal_(b,hf::impl::use_sorted_equality<KeyEqual,Key>());
         }
 
         bool operator!=(const tiny_multiset_common &b) const {
@@ -237,21 +453,90 @@ namespace impl {
         }
 
     protected:
+        using hf::impl::key_equal_holder<KeyEqual>::eq;
+
         typename std::aligned_storage<sizeof(Key),alignof(Key)>::type data[N];
-        size_t n=0;
-        KeyEqual eq;
+        hf::impl::uint_for<N> n=0;
 
         value_type *get(std::ptrdiff_t i=0) { return reinterpret_cast<value_type *>(data+i); }
         const value_type *get(std::ptrdiff_t i=0) const { return reinterpret_cast<const value_type *>(data+i); }
+
+        template <typename... Args>
+        iterator construct(Args &&... args) {
+            ::new(get(n)) value_type(std::forward<Args>(args)...);
+            return begin()+(n++);
+        }
+
+        // remove the first element, preserving the order of the rest
+        void evict(static_order) {
+            value_type *x=get();
+            for (size_type i=1;i<n;++i) x[i-1]=std::move(x[i]);
+            x[n-1].~value_type();
+            --n;
+        }
+
+        // with a reordering access policy, the last element is the coldest
+        template <typename P>
+        void evict(P) {
+            get(n-1)->~value_type();
+            --n;
+        }
+
+        template <typename K>
+        size_type count_(const K &key) const {
+            size_type c=0;
+            for (const auto &k: *this) c+=static_cast<bool>(eq()(k,key));
+            return c;
+        }
+
+        template <typename K>
+        const_iterator find_(const K &key) const {
+            auto b=begin();
+            auto e=end();
+            while (b!=e) if (eq()(*b,key)) break; else ++b;
+            return b;
+        }
+
+        // find, moving a match towards the front per the access policy
+        template <typename K>
+        const_iterator promote_(const K &key) {
+            size_type i=find_(key)-begin();
+            if (i==n) return end();
+
+            value_type *x=get();
+            i=hf::impl::promote(i,access_policy(),
+                [x](size_type a,size_type b) { std::swap(x[a],x[b]); },
+                [x](size_type j) { hf::impl::rotate_to_front(x,j); });
+            return begin()+i;
+        }
+
+        struct key_at_index {
+            const key_type *data;
+            const key_type &operator()(std::size_t i) const { return data[i]; }
+        };
+
+        key_at_index key_at() const { return key_at_index{get()}; }
+
+        bool equal_(const tiny_multiset_common &b,std::false_type) const {
+            return std::is_permutation(begin(),end(),b.begin(),eq());
+        }
+
+        bool equal_(const tiny_multiset_common &b,std::true_type) const {
+            if (n<hf::impl::sorted_equality_threshold) return equal_(b,std::false_type());
+
+            const value_type *scratch[2*N];
+            return hf::impl::sorted_equal(get(),b.get(),n,scratch,hf::impl::less_key(),hf::impl::equal_key());
+        }
     };
 
 } // namesapce impl
 
 // tiny multiset with trivial value type
-template <typename Key,std::size_t N,class KeyEqual=std::equal_to<Key>,bool trivial=std::is_trivially_copyable<Key>::value>
-struct multiset: public impl::tiny_multiset_common<Key,N,KeyEqual> {
+template <typename Key,std::size_t N,class KeyEqual=std::equal_to<Key>,class OverflowPolicy=unchecked_overflow,
+          class AccessPolicy=static_order,bool trivial=std::is_trivially_copyable<Key>::value>
+struct multiset: public impl::tiny_multiset_common<Key,N,KeyEqual,OverflowPolicy,AccessPolicy> {
 private:
-    using common=impl::tiny_multiset_common<Key,N,KeyEqual>;
+    using common=impl::tiny_multiset_common<Key,N,KeyEqual,OverflowPolicy,AccessPolicy>;
     using common::get;
     using common::data;
     using common::n;
@@ -261,6 +546,8 @@ public:
     using key_type=typename common::key_type;
     using value_type=typename common::value_type;
     using key_equal=typename common::key_equal;
+    using overflow_policy=typename common::overflow_policy;
+    using access_policy=typename common::access_policy;
     using reference=typename common::reference;
     using const_reference=typename common::const_reference;
     using size_type=typename common::size_type;
@@ -287,11 +574,19 @@ public:
         insert(ilist);
     }
 
-    multiset(const multiset &) =default;
-    multiset(multiset &&) =default;
-    multiset &operator=(const multiset &) =default;
-    multiset &operator=(multiset &&) =default;
-    
+    // copies and swaps touch only the live elements
+    multiset(const multiset &other): common(other.eq()) {
+        copy_from(other);
+    }
+
+    multiset &operator=(const multiset &other) {
+        if (this!=&other) {
+            eq()=other.eq();
+            copy_from(other);
+        }
+        return *this;
+    }
+
     void clear() { n=0; }
 
     iterator erase(const_iterator pos) {
@@ -306,24 +601,46 @@ public:
     }
 
     size_type erase(const key_type &key) {
-        size_t orig_n=n;
-        auto b=begin();
-        while (b!=end()) if (eq(*b,key)) b=erase(b); else ++b;
-        return orig_n-n;
+        return erase_key(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent,
+              typename=typename std::enable_if<!std::is_convertible<K,const_iterator>::value>::type>
+    size_type erase(const K &key) {
+        return erase_key(key);
     }
     
     void swap(multiset &other) {
-        std::swap(data,other.data);
+        hf::impl::swap_prefix(data,n,other.data,other.n);
         std::swap(n,other.n);
     }
+
+    template <typename Pred>
+    size_type remove_if(Pred pred) {
+        size_t orig_n=n;
+        auto b=begin();
+        while (b!=end()) if (pred(*b)) b=erase(b); else ++b;
+        return orig_n-n;
+    }
+
+private:
+    template <typename K>
+    size_type erase_key(const K &key) {
+        return remove_if([&](const value_type &x) { return eq()(x,key); });
+    }
+
+    void copy_from(const multiset &other) {
+        hf::impl::copy_prefix(data,other.data,other.n);
+        n=other.n;
+    }
 };
 
 
 // multiset with non-trivial value type
-template <typename Key,std::size_t N,class KeyEqual>
-struct multiset<Key,N,KeyEqual,false>: public impl::tiny_multiset_common<Key,N,KeyEqual>  {
+template <typename Key,std::size_t N,class KeyEqual,class OverflowPolicy,class AccessPolicy>
+struct multiset<Key,N,KeyEqual,OverflowPolicy,AccessPolicy,false>: public impl::tiny_multiset_common<Key,N,KeyEqual,OverflowPolicy,AccessPolicy>  {
 private:
-    using common=impl::tiny_multiset_common<Key,N,KeyEqual>;
+    using common=impl::tiny_multiset_common<Key,N,KeyEqual,OverflowPolicy,AccessPolicy>;
     using common::get;
     using common::data;
     using common::n;
@@ -333,6 +650,8 @@ public:
     using key_type=typename common::key_type;
     using value_type=typename common::value_type;
     using key_equal=typename common::key_equal;
+    using overflow_policy=typename common::overflow_policy;
+    using access_policy=typename common::access_policy;
     using reference=typename common::reference;
     using const_reference=typename common::const_reference;
     using size_type=typename common::size_type;
@@ -359,12 +678,12 @@ public:
         insert(ilist);
     }
 
-    multiset(const multiset &other): common(other.eq) {
+    multiset(const multiset &other): common(other.eq()) {
         for (const auto &x: other) emplace(x);
     }
 
-    multiset(multiset &&other) {
-        for (auto &x: other) emplace(std::move(x));
+    multiset(multiset &&other): common(other.eq()) {
+        take(other,relocatable());
     }
 
     multiset &operator=(const multiset &other) {
@@ -378,7 +697,7 @@ public:
     multiset &operator=(multiset &&other) {
         if (this!=&other) {
             clear();
-            for (auto &x: other) insert(std::move(x));
+            take(other,relocatable());
         }
         return *this;
     }
@@ -392,38 +711,99 @@ public:
     }
 
     iterator erase(const_iterator pos) {
-        value_type *x=get(pos-begin());
-        value_type *last=get(n-1);
-
-        std::swap(*x,*last);
-        last->~value_type();
-        --n;
+        erase_at(get(pos-begin()),relocatable());
         return pos;
     }
 
     size_type erase(const key_type &key) {
+        return erase_key(key);
+    }
+
+    template <typename K,typename E=KeyEqual,typename=typename E::is_transparent,
+              typename=typename std::enable_if<!std::is_convertible<K,const_iterator>::value>::type>
+    size_type erase(const K &key) {
+        return erase_key(key);
+    }
+
+    void swap(multiset &other) {
+        std::size_t nmin=std::min(n,other.n);
+        for (std::size_t i=0;i<nmin;++i) std::swap(*get(i),*(other.get(i)));
+        if (n>nmin) hf::impl::relocate(other.get(nmin),get(nmin),n-nmin);
+        else hf::impl::relocate(get(nmin),other.get(nmin),other.n-nmin);
+        std::swap(n,other.n);
+    }
+
+    template <typename Pred>
+    size_type remove_if(Pred pred) {
         size_t orig_n=n;
         auto b=begin();
-        while (b!=end()) if (eq(*b,key)) b=erase(b); else ++b;
+        while (b!=end()) if (pred(*b)) b=erase(b); else ++b;
         return orig_n-n;
     }
 
-    void swap(multiset &other) {
-        std::ptrdiff_t i=0;
-        std::ptrdiff_t nmin=std::min(n,other.n);
-        for (std::ptrdiff_t i=0;i<nmin;++i) std::swap(*get(i),*(other.get(i)));
-        for (std::ptrdiff_t i=nmin;i<n;++i) {
-            ::new(other.get(i)) value_type(std::move(*get(i)));
-            get(i)->~value_type();
-        }
-        for (std::ptrdiff_t i=nmin;i<other.n;++i) {
-            ::new(get(i)) value_type(std::move(*other.get(i)));
-            other.get(i)->~value_type();
-        }
-        std::swap(n,other.n);
+private:
+    // elements with trivially relocatable types are moved with memcpy
+    typedef hf::is_trivially_relocatable<value_type> relocatable;
+
+    template <typename K>
+    size_type erase_key(const K &key) {
+        return remove_if([&](const value_type &x) { return eq()(x,key); });
+    }
+
+    // move the elements of other into this empty multiset; relocation
+    // leaves other empty
+    void take(multiset &other,std::true_type) {
+        hf::impl::relocate(get(),other.get(),other.n);
+        n=other.n;
+        other.n=0;
+    }
+
+    void take(multiset &other,std::false_type) {
+        for (size_type i=0;i<other.n;++i) emplace(std::move(*other.get(i)));
+    }
+
+    // remove x, filling its slot with the last element
+    void erase_at(value_type *x,std::true_type) {
+        value_type *last=get(n-1);
+        x->~value_type();
+        if (x!=last) hf::impl::relocate(x,last,1);
+        --n;
+    }
+
+    void erase_at(value_type *x,std::false_type) {
+        value_type *last=get(n-1);
+        std::swap(*x,*last);
+        last->~value_type();
+        --n;
     }
 };
 
+template <typename Key,std::size_t N,class KeyEqual,class OverflowPolicy,class AccessPolicy,bool trivial,typename Pred>
+std::size_t erase_if(multiset<Key,N,KeyEqual,OverflowPolicy,AccessPolicy,trivial> &c,Pred pred) {
+    return c.remove_if(pred);
+}
+
+namespace impl {
+    // largest capacity not exceeding N for which the multiset fits in
+    // Bytes, or zero if there is none
+    template <typename Key,std::size_t Bytes,class KeyEqual,class OverflowPolicy,class AccessPolicy,std::size_t N=Bytes/sizeof(Key)>
+    struct fit_capacity: std::conditional<(sizeof(multiset<Key,N,KeyEqual,OverflowPolicy,AccessPolicy>)<=Bytes),
+        std::integral_constant<std::size_t,N>,
+        fit_capacity<Key,Bytes,KeyEqual,OverflowPolicy,AccessPolicy,N-1>>::type {};
+
+    template <typename Key,std::size_t Bytes,class KeyEqual,class OverflowPolicy,class AccessPolicy>
+    struct fit_capacity<Key,Bytes,KeyEqual,OverflowPolicy,AccessPolicy,0>: std::integral_constant<std::size_t,0> {};
+} // namespace impl
+
+/** Tiny multiset with the largest capacity that fits in `Bytes` bytes,
+ * e.g. `multiset_fit<std::uint8_t,64>` for a multiset occupying at most
+ * one cache line.
+ */
+template <typename Key,std::size_t Bytes,class KeyEqual=std::equal_to<Key>,class OverflowPolicy=unchecked_overflow,
+          class AccessPolicy=static_order>
+using multiset_fit=multiset<Key,impl::fit_capacity<Key,Bytes,KeyEqual,OverflowPolicy,AccessPolicy>::value,
+    KeyEqual,OverflowPolicy,AccessPolicy>;
+
 } // namespace tiny
 } // namespace hf
 
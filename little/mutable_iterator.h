@@ -0,0 +1,79 @@
+#ifndef HF_MUTABLE_ITERATOR_H_
+#define HF_MUTABLE_ITERATOR_H_
+
+/** Iterator over map entries with writable mapped values.
+ *
+ * The maps store entries as `std::pair<Key,Value>`, so a reference to a
+ * stored entry would permit modification of its key. Instead,
+ * `mutable_entry_iterator` dereferences to a proxy holding a const
+ * reference `first` to the key and a mutable reference `second` to the
+ * mapped value; `it->second` may be assigned through, `it->first` not.
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace hf {
+
+namespace impl {
+    template <typename Key,typename Value>
+    struct mutable_entry_ref {
+        const Key &first;
+        Value &second;
+
+        operator std::pair<Key,Value>() const { return std::pair<Key,Value>(first,second); }
+    };
+
+    template <typename Key,typename Value>
+    struct mutable_entry_iterator {
+        typedef std::pair<Key,Value> entry_type;
+
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef entry_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef mutable_entry_ref<Key,Value> reference;
+
+        struct pointer {
+            reference r;
+            const reference *operator->() const { return &r; }
+        };
+
+        mutable_entry_iterator(): p(nullptr) {}
+        explicit mutable_entry_iterator(entry_type *p_): p(p_) {}
+
+        reference operator*() const { return reference{p->first,p->second}; }
+        pointer operator->() const { return pointer{**this}; }
+        reference operator[](difference_type i) const { return *(*this+i); }
+
+        mutable_entry_iterator &operator++() { ++p; return *this; }
+        mutable_entry_iterator operator++(int) { return mutable_entry_iterator(p++); }
+        mutable_entry_iterator &operator--() { --p; return *this; }
+        mutable_entry_iterator operator--(int) { return mutable_entry_iterator(p--); }
+
+        mutable_entry_iterator &operator+=(difference_type i) { p+=i; return *this; }
+        mutable_entry_iterator &operator-=(difference_type i) { p-=i; return *this; }
+
+        friend mutable_entry_iterator operator+(mutable_entry_iterator a,difference_type i) { return a+=i; }
+        friend mutable_entry_iterator operator+(difference_type i,mutable_entry_iterator a) { return a+=i; }
+        friend mutable_entry_iterator operator-(mutable_entry_iterator a,difference_type i) { return a-=i; }
+        friend difference_type operator-(mutable_entry_iterator a,mutable_entry_iterator b) { return a.p-b.p; }
+
+        friend bool operator==(mutable_entry_iterator a,mutable_entry_iterator b) { return a.p==b.p; }
+        friend bool operator!=(mutable_entry_iterator a,mutable_entry_iterator b) { return a.p!=b.p; }
+        friend bool operator<(mutable_entry_iterator a,mutable_entry_iterator b) { return a.p<b.p; }
+        friend bool operator>(mutable_entry_iterator a,mutable_entry_iterator b) { return a.p>b.p; }
+        friend bool operator<=(mutable_entry_iterator a,mutable_entry_iterator b) { return a.p<=b.p; }
+        friend bool operator>=(mutable_entry_iterator a,mutable_entry_iterator b) { return a.p>=b.p; }
+
+        // the underlying entry, for read-only use
+        const entry_type *base() const { return p; }
+
+    private:
+        entry_type *p;
+    };
+} // namespace impl
+
+} // namespace hf
+
+#endif // ndef HF_MUTABLE_ITERATOR_H_
@@ -0,0 +1,175 @@
+#ifndef HF_POLICY_H_
+#define HF_POLICY_H_
+
+/** Policy tags for configuring container behaviour. */
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace hf {
+
+/** Element removal policies for vector-backed containers.
+ *
+ * With `stable_erase` (the default), removing elements preserves the
+ * relative order of the remaining elements, as with `std::vector`.
+ * With `unordered_erase`, gaps are filled with elements from the back of
+ * the store, as the `tiny` containers always do: single erasures are then
+ * O(1) rather than O(N).
+ *
+ * Either way, erasing by key or predicate is a single O(N) pass.
+ */
+
+struct stable_erase {};
+struct unordered_erase {};
+
+/** Capacity overflow policies for fixed-capacity (tiny) containers.
+ *
+ * These determine what happens when an element is added to a full
+ * container:
+ *
+ * `unchecked_overflow` (the default): no check is made; the behaviour
+ *     is undefined.
+ * `assert_overflow`: capacity is checked with `assert`.
+ * `throw_overflow`: a `std::length_error` is thrown.
+ * `fail_overflow`: the insertion is not performed, and returns the end
+ *     iterator (with `false`, where a pair is returned); operations
+ *     that return a reference to the new element throw instead.
+ * `evict_oldest`: the element at the front of the store is removed to
+ *     make room. This is the oldest element if there have been no
+ *     erasures, which fill gaps with the last element. With a
+ *     reordering access policy, the element at the back is removed
+ *     instead (see below).
+ *
+ * Regardless of policy, `try_insert` returns `{end(),false}` rather
+ * than insert into a full container.
+ */
+
+struct unchecked_overflow {};
+struct assert_overflow {};
+struct throw_overflow {};
+struct fail_overflow {};
+struct evict_oldest {};
+
+/** Access order policies for linear-search containers.
+ *
+ * With `static_order` (the default), lookups never change the order of
+ * elements. With `move_to_front`, a successful `find` on a non-const
+ * container (and for maps, a hit in `at` or `operator[]`) moves the
+ * element found to the front of the store; with `transpose`, the
+ * element is instead swapped with its predecessor. Either way, keys
+ * that are looked up often drift to the front, and with a skewed
+ * access distribution the expected scan length tracks that
+ * distribution rather than the insertion order.
+ *
+ * Move-to-front adapts quickly to a change in access pattern, at a cost
+ * of i moves for a hit at position i; transpose costs a single swap,
+ * and converges more slowly to a more stable order. For keys that are
+ * cheap to compare, the moves can cost more than the scan they save,
+ * and transpose is usually the better choice.
+ *
+ * Reordering invalidates iterators, and lookups on a const container
+ * never reorder. Under `evict_oldest`, these policies evict the element
+ * at the back of the store rather than the front: the least recently
+ * found rather than the oldest, which would be the one most often
+ * found. An element just inserted is then the first to go unless it is
+ * looked up before the next insertion.
+ */
+
+struct static_order {};
+struct move_to_front {};
+struct transpose {};
+
+/** Duplicate key policies for bulk insertion into maps.
+ *
+ * When a range passed to `insert(first,last,policy)`, a range
+ * constructor or `assign_unique` holds more than one entry with the same
+ * key, or an entry whose key is already present, `last_wins` (the
+ * default, and the behaviour of element-wise `insert`) keeps the mapped
+ * value that comes last, and `first_wins` the one that comes first: an
+ * existing entry is then left unchanged, as with `emplace`.
+ */
+
+struct last_wins {};
+struct first_wins {};
+
+namespace impl {
+    template <typename P>
+    struct is_duplicate_policy: std::false_type {};
+
+    template <>
+    struct is_duplicate_policy<last_wins>: std::true_type {};
+
+    template <>
+    struct is_duplicate_policy<first_wins>: std::true_type {};
+
+    template <typename P>
+    using if_duplicate_policy=typename std::enable_if<is_duplicate_policy<P>::value>::type;
+} // namespace impl
+
+namespace impl {
+    // Return true if an element may be added to a container holding n
+    // of at most cap elements, first calling evict() if the policy so
+    // requires.
+
+    template <typename Evict>
+    bool make_room(std::size_t,std::size_t,unchecked_overflow,Evict) { return true; }
+
+    template <typename Evict>
+    bool make_room(std::size_t n,std::size_t cap,assert_overflow,Evict) {
+        assert(n<cap);
+        return true;
+    }
+
+    template <typename Evict>
+    bool make_room(std::size_t n,std::size_t cap,throw_overflow,Evict) {
+        if (n>=cap) throw std::length_error("container capacity exceeded");
+        return true;
+    }
+
+    template <typename Evict>
+    bool make_room(std::size_t n,std::size_t cap,fail_overflow,Evict) { return n<cap; }
+
+    template <typename Evict>
+    bool make_room(std::size_t n,std::size_t cap,evict_oldest,Evict evict) {
+        if (n>=cap) evict();
+        return true;
+    }
+
+    // Move first[i] to first[0], shifting first[0..i-1] up by one.
+
+    template <typename I>
+    void rotate_to_front(I first,std::size_t i) {
+        auto x=std::move(first[i]);
+        std::move_backward(first,first+i,first+i+1);
+        *first=std::move(x);
+    }
+
+    // Move the element at index i towards the front as the access order
+    // policy requires: swap(j,k) exchanges elements j and k, and
+    // to_front(j) moves element j to the front, shifting the elements
+    // before it back by one. Returns the new index of the element.
+
+    template <typename Swap,typename ToFront>
+    std::size_t promote(std::size_t i,static_order,Swap,ToFront) { return i; }
+
+    template <typename Swap,typename ToFront>
+    std::size_t promote(std::size_t i,move_to_front,Swap,ToFront to_front) {
+        if (i>0) to_front(i);
+        return 0;
+    }
+
+    template <typename Swap,typename ToFront>
+    std::size_t promote(std::size_t i,transpose,Swap swap,ToFront) {
+        if (i==0) return 0;
+        swap(i-1,i);
+        return i-1;
+    }
+} // namespace impl
+
+} // namespace hf
+
+#endif // ndef HF_POLICY_H_
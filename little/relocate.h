@@ -0,0 +1,111 @@
+#ifndef HF_RELOCATE_H_
+#define HF_RELOCATE_H_
+
+/** Trivial relocation of container elements.
+ *
+ * An object is relocated when it is move-constructed into new storage
+ * and the original destroyed. For many types with non-trivial move
+ * constructors and destructors, such as `std::unique_ptr`, the net
+ * effect of relocation is just a copy of the object's bytes; such types
+ * can be moved between slots of the fixed-capacity containers with
+ * `memcpy`, in bulk, with no constructor or destructor calls.
+ *
+ * `is_trivially_relocatable<T>` is true for trivially copyable types,
+ * for `std::unique_ptr` with the default deleter, `std::shared_ptr`,
+ * `std::weak_ptr`, and for pairs of trivially relocatable types. It
+ * may be specialised for user types, as:
+ *
+ *     template <>
+ *     struct hf::is_trivially_relocatable<my_type>: std::true_type {};
+ *
+ * A type must not be so marked if it holds a pointer into itself, or
+ * registers its address elsewhere. In particular, `std::string` is not
+ * trivially relocatable in libstdc++, where short strings are stored
+ * inline and addressed through an internal pointer.
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace hf {
+
+template <typename T>
+struct is_trivially_relocatable: std::is_trivially_copyable<T> {};
+
+template <typename T>
+struct is_trivially_relocatable<std::unique_ptr<T,std::default_delete<T>>>: std::true_type {};
+
+template <typename T>
+struct is_trivially_relocatable<std::shared_ptr<T>>: std::true_type {};
+
+template <typename T>
+struct is_trivially_relocatable<std::weak_ptr<T>>: std::true_type {};
+
+template <typename A,typename B>
+struct is_trivially_relocatable<std::pair<A,B>>:
+    std::integral_constant<bool,is_trivially_relocatable<A>::value && is_trivially_relocatable<B>::value> {};
+
+namespace impl {
+    // Relocate n objects from `from` to non-overlapping storage at `to`;
+    // the objects at `from` are left destroyed.
+
+    template <typename T>
+    void relocate(T *to,T *from,std::size_t n,std::true_type) {
+        if (n) std::memcpy(static_cast<void *>(to),static_cast<const void *>(from),n*sizeof(T));
+    }
+
+    template <typename T>
+    void relocate(T *to,T *from,std::size_t n,std::false_type) {
+        for (std::size_t i=0;i<n;++i) {
+            ::new(to+i) T(std::move(from[i]));
+            from[i].~T();
+        }
+    }
+
+    template <typename T>
+    void relocate(T *to,T *from,std::size_t n) {
+        relocate(to,from,n,is_trivially_relocatable<T>());
+    }
+
+    // Copy the first n slots, or exchange the first na and nb slots, of
+    // fixed-size arrays of trivially copyable storage. Whole arrays are
+    // handled with fixed-size operations, which the compiler can unroll.
+
+    template <typename S,std::size_t N>
+    void copy_prefix(S (&to)[N],const S (&from)[N],std::size_t n) {
+        if (n==N) std::memcpy(to,from,sizeof(to));
+        else if (n) std::memcpy(to,from,n*sizeof(S));
+    }
+
+    inline void swap_bytes(unsigned char *p,unsigned char *q,std::size_t n) {
+        for (std::size_t i=0;i<n;++i) {
+            unsigned char t=p[i];
+            p[i]=q[i];
+            q[i]=t;
+        }
+    }
+
+    template <typename S,std::size_t N>
+    void swap_prefix(S (&a)[N],std::size_t na,S (&b)[N],std::size_t nb) {
+        unsigned char *p=reinterpret_cast<unsigned char *>(a);
+        unsigned char *q=reinterpret_cast<unsigned char *>(b);
+        std::size_t m=na<nb? na: nb;
+        if (m==N) {
+            swap_bytes(p,q,sizeof(a));
+            return;
+        }
+
+        swap_bytes(p,q,m*sizeof(S));
+        if (na>m) std::memcpy(b+m,a+m,(na-m)*sizeof(S));
+        else if (nb>m) std::memcpy(a+m,b+m,(nb-m)*sizeof(S));
+    }
+
+} // namespace impl
+
+} // namespace hf
+
+#endif // ndef HF_RELOCATE_H_
@@ -0,0 +1,168 @@
+#ifndef HF_SET_ALGEBRA_H_
+#define HF_SET_ALGEBRA_H_
+
+/** Multiset algebra for the linear search containers of multiset.h.
+ *
+ * `set_intersection(a,b)`, `set_union(a,b)` and `set_difference(a,b)`
+ * return a new container of the type of `a` and `b`; as with the
+ * standard algorithms on sorted ranges, each element of `a` is matched
+ * with at most one equal element of `b`, so that the multiplicity of a
+ * key in the result is respectively the minimum, the maximum, or the
+ * (non-negative) difference of its multiplicities in `a` and `b`.
+ * `intersection_size(a,b)` gives the size of the intersection without
+ * constructing it. Capacity is not checked for tiny::multiset results.
+ *
+ * For small inputs, elements are matched by counting equal elements
+ * across all pairs, a loop the compiler vectorises for arithmetic keys
+ * compared with `std::equal_to`. For inputs of size `n` and `m` with few
+ * repeated keys, the cost of this is proportional to `n·(m+min(n,m))`;
+ * when this exceeds `set_algebra_sort_threshold` and keys admit sorted
+ * comparison (see equality.h), both inputs are instead sorted by pointer
+ * and merged.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "equality.h"
+#include "multiset.h"
+
+namespace hf {
+
+namespace impl {
+    constexpr std::size_t set_algebra_sort_threshold=6144;
+
+    template <typename C>
+    struct linear_multiset_traits: std::false_type {};
+
+    template <typename Key,class KeyEqual,class Allocator,class ErasePolicy,class AccessPolicy>
+    struct linear_multiset_traits<small::multiset<Key,KeyEqual,Allocator,ErasePolicy,AccessPolicy>>: std::true_type {
+        typedef small::multiset<Key,KeyEqual,Allocator,ErasePolicy,AccessPolicy> container;
+        static container empty_like(const container &c) { return container(c.key_eq(),c.get_allocator()); }
+    };
+
+    template <typename Key,std::size_t N,class KeyEqual,class OverflowPolicy,class AccessPolicy,bool trivial>
+    struct linear_multiset_traits<tiny::multiset<Key,N,KeyEqual,OverflowPolicy,AccessPolicy,trivial>>: std::true_type {
+        typedef tiny::multiset<Key,N,KeyEqual,OverflowPolicy,AccessPolicy,trivial> container;
+        static container empty_like(const container &c) { return container(c.key_eq()); }
+    };
+
+    template <typename C>
+    const typename C::value_type *data_of(const C &c) {
+        return c.empty()? nullptr: &*c.begin();
+    }
+
+    // Number of j in [0,n) with eq(p[j],key).
+    template <typename T,typename Eq>
+    std::size_t count_equal(const T *p,std::size_t n,const Eq &eq,const T &key) {
+        std::size_t c=0;
+        for (std::size_t j=0;j<n;++j) c+=static_cast<bool>(eq(p[j],key));
+        return c;
+    }
+
+    // Call emit(a[i]) for each a[i] that is (if matched) or is not (if
+    // !matched) paired with an element of b, pairing the k-th occurrence
+    // of a key in a with the k-th occurrence in b.
+    template <typename T,typename Eq,typename Emit>
+    void select_pairwise(const T *a,std::size_t n,const T *b,std::size_t m,const Eq &eq,bool matched,Emit emit) {
+        for (std::size_t i=0;i<n;++i) {
+            std::size_t c=count_equal(b,m,eq,a[i]);
+            bool in_b=c && count_equal(a,i,eq,a[i])<c;
+            if (in_b==matched) emit(a[i]);
+        }
+    }
+
+    template <typename T,typename Emit>
+    void select_sorted(const T *a,std::size_t n,const T *b,std::size_t m,bool matched,Emit emit) {
+        std::vector<const T *> pa(n),pb(m);
+        for (std::size_t i=0;i<n;++i) pa[i]=a+i;
+        for (std::size_t j=0;j<m;++j) pb[j]=b+j;
+
+        auto ptr_less=[](const T *x,const T *y) { return *x<*y; };
+        std::sort(pa.begin(),pa.end(),ptr_less);
+        std::sort(pb.begin(),pb.end(),ptr_less);
+
+        std::size_t j=0;
+        for (std::size_t i=0;i<n;++i) {
+            const T &x=*pa[i];
+            while (j<m && *pb[j]<x) ++j;
+
+            bool in_b=j<m && !(x<*pb[j]);
+            j+=in_b;
+            if (in_b==matched) emit(x);
+        }
+    }
+
+    template <typename C,typename Emit>
+    void select(const C &a,const C &b,bool matched,Emit emit,std::false_type) {
+        select_pairwise(data_of(a),a.size(),data_of(b),b.size(),a.key_eq(),matched,emit);
+    }
+
+    template <typename C,typename Emit>
+    void select(const C &a,const C &b,bool matched,Emit emit,std::true_type) {
+        std::size_t n=a.size(),m=b.size();
+        if (n*(m+std::min(n,m))<=set_algebra_sort_threshold) select(a,b,matched,emit,std::false_type());
+        else select_sorted(data_of(a),n,data_of(b),m,matched,emit);
+    }
+
+    template <typename C,typename Emit>
+    void select(const C &a,const C &b,bool matched,Emit emit) {
+        select(a,b,matched,emit,use_sorted_equality<typename C::key_equal,typename C::key_type>());
+    }
+
+    template <typename C>
+    using if_linear_multiset=typename std::enable_if<linear_multiset_traits<C>::value,C>::type;
+} // namespace impl
+
+template <typename C>
+impl::if_linear_multiset<C> set_intersection(const C &a,const C &b) {
+    C r=impl::linear_multiset_traits<C>::empty_like(a);
+    impl::select(a,b,true,[&](const typename C::value_type &x) { r.insert(x); });
+    return r;
+}
+
+template <typename C>
+impl::if_linear_multiset<C> set_difference(const C &a,const C &b) {
+    C r=impl::linear_multiset_traits<C>::empty_like(a);
+    impl::select(a,b,false,[&](const typename C::value_type &x) { r.insert(x); });
+    return r;
+}
+
+template <typename C>
+impl::if_linear_multiset<C> set_union(const C &a,const C &b) {
+    C r(a);
+    impl::select(b,a,false,[&](const typename C::value_type &x) { r.insert(x); });
+    return r;
+}
+
+template <typename C>
+typename std::enable_if<impl::linear_multiset_traits<C>::value,std::size_t>::type
+intersection_size(const C &a,const C &b) {
+    std::size_t c=0;
+    auto count=[&](const typename C::value_type &) { ++c; };
+    if (a.size()<=b.size()) impl::select(a,b,true,count);
+    else impl::select(b,a,true,count);
+    return c;
+}
+
+// Make the above visible to argument-dependent lookup.
+
+namespace small {
+    using hf::set_intersection;
+    using hf::set_difference;
+    using hf::set_union;
+    using hf::intersection_size;
+}
+
+namespace tiny {
+    using hf::set_intersection;
+    using hf::set_difference;
+    using hf::set_union;
+    using hf::intersection_size;
+}
+
+} // namespace hf
+
+#endif // ndef HF_SET_ALGEBRA_H_
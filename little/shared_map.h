@@ -0,0 +1,118 @@
+#ifndef HF_SHARED_MAP_H_
+#define HF_SHARED_MAP_H_
+
+/** Copy-on-write small map for read-mostly data shared across threads.
+ *
+ * `small::shared_map<Key,Value>` holds an immutable `small::map` behind a
+ * `std::shared_ptr` that is read and replaced atomically. `snapshot()`
+ * hands a reader the current version, which stays valid and unchanged
+ * for as long as the reader holds it, however the map is updated in the
+ * meantime; a reader making several lookups should take one snapshot
+ * and use it throughout. `get`, `get_or`, `count` and `size` are
+ * shorthands for a single lookup in a fresh snapshot.
+ *
+ * Writers copy the current version, modify the copy and publish it as
+ * the new version. `update(fn)` applies any number of changes made by
+ * `fn` to the copy as a single batch, so that readers see all or none of
+ * them; `insert_or_assign`, `erase` and `assign` are single changes.
+ * Writers are serialised by a mutex, and each costs a copy of the map:
+ * the map suits data read on every request and updated rarely. A
+ * superseded version is destroyed when its last reader releases it.
+ *
+ * Snapshots are loaded and stored with the C++11 atomic `shared_ptr`
+ * operations, which in common implementations take a brief lock
+ * selected by the pointer address, but never one held across a lookup
+ * or update.
+ */
+
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "map.h"
+#include "policy.h"
+
+namespace hf {
+
+namespace small {
+
+template <typename Key,typename Value,class KeyEqual=std::equal_to<Key>,class Allocator=std::allocator<std::pair<Key,Value>>,
+          class ErasePolicy=stable_erase>
+struct shared_map {
+    typedef small::map<Key,Value,KeyEqual,Allocator,ErasePolicy> map_type;
+    typedef std::shared_ptr<const map_type> snapshot_type;
+
+    typedef Key key_type;
+    typedef Value mapped_type;
+    typedef typename map_type::value_type value_type;
+    typedef typename map_type::size_type size_type;
+
+    explicit shared_map(map_type m=map_type()): current(std::make_shared<const map_type>(std::move(m))) {}
+
+    shared_map(std::initializer_list<value_type> ilist): shared_map(map_type(ilist)) {}
+
+    shared_map(const shared_map &) =delete;
+    shared_map &operator=(const shared_map &) =delete;
+
+    // readers
+
+    snapshot_type snapshot() const { return std::atomic_load(&current); }
+
+    size_type size() const { return snapshot()->size(); }
+    bool empty() const { return snapshot()->empty(); }
+    size_type count(const key_type &key) const { return snapshot()->count(key); }
+
+    // copy the value mapped to key into value and return true, or
+    // return false if key is absent
+    bool get(const key_type &key,mapped_type &value) const {
+        snapshot_type s=snapshot();
+        auto i=s->find(key);
+        if (i==s->end()) return false;
+        value=i->second;
+        return true;
+    }
+
+    mapped_type get_or(const key_type &key,const mapped_type &dflt) const {
+        snapshot_type s=snapshot();
+        auto i=s->find(key);
+        return i==s->end()? dflt: i->second;
+    }
+
+    // writers
+
+    // apply fn to a copy of the current version and publish the result
+    template <typename F>
+    void update(F fn) {
+        std::lock_guard<std::mutex> lock(writer);
+        std::shared_ptr<map_type> next=std::make_shared<map_type>(*current);
+        fn(*next);
+        std::atomic_store(&current,snapshot_type(std::move(next)));
+    }
+
+    void insert_or_assign(const key_type &key,const mapped_type &value) {
+        update([&](map_type &m) { m.insert_or_assign(key,value); });
+    }
+
+    size_type erase(const key_type &key) {
+        size_type n=0;
+        update([&](map_type &m) { n=m.erase(key); });
+        return n;
+    }
+
+    void assign(map_type m) {
+        std::lock_guard<std::mutex> lock(writer);
+        std::atomic_store(&current,snapshot_type(std::make_shared<const map_type>(std::move(m))));
+    }
+
+private:
+    snapshot_type current;
+    std::mutex writer;
+};
+
+} // namespace small
+
+} // namespace hf
+
+#endif // ndef HF_SHARED_MAP_H_
@@ -0,0 +1,137 @@
+#include "little/compat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "little/arena.h"
+#include "little/hash_tag.h"
+#include "little/map.h"
+
+using namespace hf;
+
+TEST(arena,reuse) {
+    arena a;
+
+    void *p=a.allocate(24);
+    void *q=a.allocate(24);
+    ASSERT_NE(p,q);
+    ASSERT_EQ(0u,reinterpret_cast<std::uintptr_t>(p)%alignof(std::max_align_t));
+
+    // freed blocks are reused for requests in the same size class
+    a.deallocate(p,24);
+    ASSERT_EQ(p,a.allocate(32));
+
+    std::size_t reserved=a.bytes_reserved();
+    for (int i=0;i<1000;++i) {
+        void *r=a.allocate(100);
+        a.deallocate(r,100);
+    }
+    ASSERT_EQ(reserved,a.bytes_reserved());
+}
+
+TEST(arena,large_and_aligned) {
+    arena a(1024);
+
+    char *big=static_cast<char *>(a.allocate(100000));
+    big[0]=big[99999]=1;
+
+    void *p=a.allocate(64,256);
+    ASSERT_EQ(0u,reinterpret_cast<std::uintptr_t>(p)%256);
+    a.deallocate(p,64,256);
+
+    a.release();
+    ASSERT_EQ(0u,a.bytes_reserved());
+
+    // arena remains usable after release
+    ASSERT_NE(nullptr,a.allocate(8));
+}
+
+TEST(arena,containers) {
+    arena a;
+    std::size_t reserved=0;
+
+    for (int round=0;round<3;++round) {
+        {
+            small::arena_multiset<int> s{arena_allocator<int>(a)};
+            small::arena_map<std::string,int,hash_tagged<std::string>> m{arena_allocator<std::pair<std::string,int>>(a)};
+
+            for (int i=0;i<50;++i) {
+                s.insert(i%10);
+                m[std::to_string(i)]=i;
+            }
+            ASSERT_EQ(5,s.count(3));
+            ASSERT_EQ(50,m.size());
+            ASSERT_EQ(42,m.at("42"));
+            ASSERT_EQ(1,m.erase("42"));
+            ASSERT_EQ(0,m.count("42"));
+            ASSERT_EQ(&a,s.get_allocator().get_arena());
+        }
+
+        // containers of the same shape reuse the blocks freed by the last
+        if (round==0) reserved=a.bytes_reserved();
+        else ASSERT_EQ(reserved,a.bytes_reserved());
+    }
+
+    std::vector<int,arena_allocator<int>> v{arena_allocator<int>(a)};
+    for (int i=0;i<100;++i) v.push_back(i);
+    ASSERT_EQ(99,v.back());
+}
+
+#ifdef HF_HAVE_PMR
+TEST(arena,pmr) {
+    arena_resource r;
+
+    small::pmr::map<int,int> m(&r);
+    small::pmr::multiset<int> s(&r);
+    for (int i=0;i<20;++i) {
+        m[i]=2*i;
+        s.insert(i%4);
+    }
+    ASSERT_EQ(38,m.at(19));
+    ASSERT_EQ(5,s.count(2));
+    ASSERT_LT(0u,r.get_arena().bytes_reserved());
+}
+
+namespace {
+// counts the blocks outstanding from the default resource
+struct counting_resource: std::pmr::memory_resource {
+    int live=0;
+
+    void *do_allocate(std::size_t n,std::size_t a) override {
+        ++live;
+        return std::pmr::new_delete_resource()->allocate(n,a);
+    }
+    void do_deallocate(void *p,std::size_t n,std::size_t a) override {
+        --live;
+        std::pmr::new_delete_resource()->deallocate(p,n,a);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this==&other; }
+};
+}
+
+TEST(arena,pmr_allocator_extended) {
+    // hash tags follow the entries onto the target resource
+    typedef small::pmr::map<int,int,hash_tagged<int>> tagged_map;
+    counting_resource a,b;
+    {
+        tagged_map m(&a);
+        for (int i=0;i<20;++i) m[i]=i;
+        ASSERT_EQ(2,a.live);
+
+        tagged_map copy(m,&b);
+        ASSERT_EQ(2,b.live);
+        ASSERT_EQ(2,a.live);
+        ASSERT_EQ(m,copy);
+
+        tagged_map moved(std::move(m),&b);
+        ASSERT_EQ(4,b.live);
+        ASSERT_EQ(copy,moved);
+        ASSERT_EQ(7,moved.at(7));
+    }
+    ASSERT_EQ(0,a.live);
+    ASSERT_EQ(0,b.live);
+}
+#endif
@@ -0,0 +1,118 @@
+#include "little/compat.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "little/atomic_set.h"
+
+using namespace hf;
+
+TEST(atomic_set,insert_unique) {
+    tiny::atomic_set<int,4> s;
+
+    ASSERT_TRUE(s.empty());
+    ASSERT_EQ(0,s.size());
+    ASSERT_EQ(4,s.max_size());
+
+    ASSERT_TRUE(s.insert_unique(3));
+    ASSERT_FALSE(s.insert_unique(3));
+    ASSERT_TRUE(s.insert_unique(-1));
+    ASSERT_TRUE(s.insert_unique(7));
+    ASSERT_EQ(3,s.size());
+    ASSERT_FALSE(s.full());
+
+    ASSERT_TRUE(s.contains(-1));
+    ASSERT_EQ(1,s.count(7));
+    ASSERT_FALSE(s.contains(4));
+
+    ASSERT_TRUE(s.insert_unique(4));
+    ASSERT_TRUE(s.full());
+
+    // full: fails without inserting
+    ASSERT_FALSE(s.insert_unique(5));
+    ASSERT_FALSE(s.contains(5));
+    ASSERT_EQ(4,s.size());
+
+    std::vector<int> elements;
+    s.for_each([&](int x) { elements.push_back(x); });
+    ASSERT_EQ((std::vector<int>{3,-1,7,4}),elements);
+
+    ASSERT_THROW(s.insert_unique(s.empty_value),std::invalid_argument);
+
+    s.reset();
+    ASSERT_TRUE(s.empty());
+    ASSERT_FALSE(s.contains(3));
+    ASSERT_TRUE(s.insert_unique(5));
+    ASSERT_EQ(1,s.size());
+}
+
+TEST(atomic_set,custom_empty) {
+    tiny::atomic_set<std::uint32_t,3,0> s;
+
+    ASSERT_THROW(s.insert_unique(0),std::invalid_argument);
+    ASSERT_TRUE(s.insert_unique(0xffffffffu));
+    ASSERT_TRUE(s.contains(0xffffffffu));
+    ASSERT_FALSE(s.contains(0));
+}
+
+TEST(atomic_set,concurrent_insert) {
+    // Each thread inserts the same keys in a different order; every key
+    // must be inserted by exactly one thread, and only once.
+
+    constexpr int n_threads=8;
+    constexpr int n_keys=48;
+    constexpr int n_rounds=200;
+
+    tiny::atomic_set<std::int64_t,64> s;
+    std::vector<std::atomic<int>> wins(n_keys);
+
+    for (int round=0;round<n_rounds;++round) {
+        s.reset();
+        for (auto &w: wins) w.store(0);
+
+        std::vector<std::thread> threads;
+        for (int t=0;t<n_threads;++t) {
+            threads.emplace_back([&,t]() {
+                for (int i=0;i<n_keys;++i) {
+                    int k=(i*7+t*5+round)%n_keys;
+                    if (s.insert_unique(k)) ++wins[k];
+                }
+            });
+        }
+        for (auto &t: threads) t.join();
+
+        ASSERT_EQ(n_keys,s.size());
+        for (int k=0;k<n_keys;++k) ASSERT_EQ(1,wins[k].load());
+
+        std::vector<std::int64_t> elements;
+        s.for_each([&](std::int64_t x) { elements.push_back(x); });
+        std::sort(elements.begin(),elements.end());
+        ASSERT_EQ(n_keys,(int)elements.size());
+        for (int k=0;k<n_keys;++k) ASSERT_EQ(k,elements[k]);
+    }
+}
+
+TEST(atomic_set,concurrent_overflow) {
+    // More distinct keys than capacity: exactly N insertions succeed.
+
+    constexpr int n_threads=4;
+    tiny::atomic_set<int,16> s;
+    std::atomic<int> n_inserted(0);
+
+    std::vector<std::thread> threads;
+    for (int t=0;t<n_threads;++t) {
+        threads.emplace_back([&,t]() {
+            for (int i=0;i<32;++i) n_inserted+=s.insert_unique(t*32+i);
+        });
+    }
+    for (auto &t: threads) t.join();
+
+    ASSERT_EQ(16,n_inserted.load());
+    ASSERT_EQ(16,s.size());
+    ASSERT_TRUE(s.full());
+}
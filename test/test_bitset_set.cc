@@ -0,0 +1,219 @@
+#include "little/compat.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "little/bitset_set.h"
+
+using namespace hf;
+
+enum class colour: std::uint8_t { red, green, blue, cyan, magenta, yellow };
+
+template <typename C>
+std::vector<int> contents(const C &c) {
+    std::vector<int> x;
+    for (auto k: c) x.push_back(static_cast<int>(k));
+    return x;
+}
+
+template <typename T>
+class xbitset_set: public ::testing::Test {};
+
+using bitset_set_types=::testing::Types<tiny::bitset_set<64,int>,tiny::bitset_set<200,std::uint8_t>,tiny::bitset_set<1000>>;
+TYPED_TEST_CASE(xbitset_set,bitset_set_types);
+
+TYPED_TEST(xbitset_set,insert) {
+    using set=TypeParam;
+
+    set s;
+    ASSERT_TRUE(s.empty());
+    ASSERT_EQ(s.begin(),s.end());
+
+    auto r=s.insert(5);
+    ASSERT_TRUE(r.second);
+    ASSERT_EQ(5,*r.first);
+
+    r=s.insert(5);
+    ASSERT_FALSE(r.second);
+    ASSERT_EQ(5,*r.first);
+
+    s.insert({63,0,17,5,1});
+    ASSERT_EQ(5,s.size());
+    ASSERT_EQ((std::vector<int>{0,1,5,17,63}),contents(s));
+
+    ASSERT_TRUE(s.contains(17));
+    ASSERT_FALSE(s.contains(18));
+    ASSERT_EQ(1,s.count(63));
+    ASSERT_EQ(0,s.count(62));
+    ASSERT_EQ(17,*s.find(17));
+    ASSERT_EQ(s.end(),s.find(16));
+
+    s.clear();
+    ASSERT_TRUE(s.empty());
+}
+
+TYPED_TEST(xbitset_set,erase) {
+    using set=TypeParam;
+
+    set s({1,2,3,40,41,50});
+    ASSERT_EQ(1,s.erase(3));
+    ASSERT_EQ(0,s.erase(3));
+
+    auto i=s.erase(s.find(40));
+    ASSERT_EQ(41,*i);
+
+    ASSERT_EQ(2,erase_if(s,[](int k) { return k%2; }));
+    ASSERT_EQ((std::vector<int>{2,50}),contents(s));
+
+    for (auto j=s.begin();j!=s.end();) j=s.erase(j);
+    ASSERT_TRUE(s.empty());
+}
+
+TYPED_TEST(xbitset_set,set_ops) {
+    using set=TypeParam;
+
+    set a({1,2,3,4,60});
+    set b({3,4,5,6,60,61});
+
+    ASSERT_EQ((std::vector<int>{1,2,3,4,5,6,60,61}),contents(a|b));
+    ASSERT_EQ((std::vector<int>{3,4,60}),contents(a&b));
+    ASSERT_EQ((std::vector<int>{1,2}),contents(a-b));
+    ASSERT_EQ((std::vector<int>{1,2,5,6,61}),contents(a^b));
+    ASSERT_EQ(3,a.intersection_size(b));
+
+    ASSERT_EQ(a,set({60,4,3,2,1}));
+    ASSERT_NE(a,b);
+
+    set c(b);
+    c.swap(a);
+    ASSERT_EQ(b,a);
+    ASSERT_EQ((std::vector<int>{1,2,3,4,60}),contents(c));
+}
+
+TYPED_TEST(xbitset_set,batch_lookup) {
+    using set=TypeParam;
+
+    set s({1,2,3});
+    std::vector<int> queries={3,7,1};
+
+    std::vector<std::size_t> counts;
+    s.count_many(queries.begin(),queries.end(),std::back_inserter(counts));
+    ASSERT_EQ((std::vector<std::size_t>{1,0,1}),counts);
+
+    std::vector<bool> found;
+    s.contains_many(queries.begin(),queries.end(),std::back_inserter(found));
+    ASSERT_EQ((std::vector<bool>{true,false,true}),found);
+}
+
+TEST(bitset_set,enum_keys) {
+    tiny::bitset_set<6,colour> s({colour::blue,colour::red});
+    ASSERT_TRUE(s.contains(colour::red));
+    ASSERT_FALSE(s.contains(colour::green));
+    ASSERT_EQ(colour::red,*s.begin());
+    ASSERT_EQ(2,s.size());
+}
+
+template <typename T>
+class xcounted_bitset_set: public ::testing::Test {};
+
+using counted_bitset_set_types=::testing::Types<tiny::counted_bitset_set<64,int>,tiny::counted_bitset_set<200,std::uint8_t,4>,tiny::counted_bitset_set<1000,std::size_t,16>>;
+TYPED_TEST_CASE(xcounted_bitset_set,counted_bitset_set_types);
+
+TYPED_TEST(xcounted_bitset_set,insert_count) {
+    using mset=TypeParam;
+
+    mset m({1,2,3,2,3,4,3,4,5});
+    ASSERT_EQ(9,m.size());
+    ASSERT_EQ(5,m.unique_size());
+    ASSERT_EQ((std::vector<int>{1,2,2,3,3,3,4,4,5}),contents(m));
+
+    ASSERT_EQ(3,m.count(3));
+    ASSERT_EQ(0,m.count(6));
+
+    auto i=m.insert(63,10);
+    ASSERT_EQ(63,*i);
+    ASSERT_EQ(10,m.count(63));
+    ASSERT_EQ(19,m.size());
+    ASSERT_EQ(19,std::distance(m.begin(),m.end()));
+
+    ASSERT_EQ(m,mset({5,4,3,3,2,1,4,3,2,63,63,63,63,63,63,63,63,63,63}));
+}
+
+TYPED_TEST(xcounted_bitset_set,erase) {
+    using mset=TypeParam;
+
+    mset m({1,2,3,2,3,4,3,4,5});
+
+    ASSERT_EQ(3,m.erase(3));
+    ASSERT_EQ(0,m.erase(3));
+    ASSERT_EQ(6,m.size());
+
+    auto i=m.erase(m.find(2));
+    ASSERT_EQ(2,*i);
+    i=m.erase(i);
+    ASSERT_EQ(4,*i);
+    ASSERT_EQ(0,m.count(2));
+
+    ASSERT_EQ(1,erase_if(m,[](int k) { return k==5; }));
+    ASSERT_EQ((std::vector<int>{1,4,4}),contents(m));
+
+    for (auto j=m.begin();j!=m.end();) j=m.erase(j);
+    ASSERT_TRUE(m.empty());
+    ASSERT_EQ(0,m.unique_size());
+}
+
+TEST(counted_bitset_set,count_width) {
+    ASSERT_EQ(15,(tiny::counted_bitset_set<64,int,4>::max_count()));
+    ASSERT_EQ(255,(tiny::counted_bitset_set<64,int,8>::max_count()));
+
+    tiny::counted_bitset_set<64,int,4> m;
+    for (int k=0;k<64;++k) m.insert(k,k%16);
+    for (int k=0;k<64;++k) ASSERT_EQ(k%16,m.count(k));
+    ASSERT_EQ(4*120,m.size());
+}
+
+TEST(counted_bitset_set,count_saturates) {
+    tiny::counted_bitset_set<16,unsigned,4> m;
+    m.insert(1u,2);
+    m.insert(0u,16);
+
+    // an overflowing count saturates without touching its neighbour
+    ASSERT_EQ(15,m.count(0));
+    ASSERT_EQ(2,m.count(1));
+    ASSERT_EQ(17,m.size());
+
+    m.insert(1u);
+    m.insert(1u,20);
+    ASSERT_EQ(15,m.count(1));
+    ASSERT_EQ(15,m.count(0));
+    ASSERT_EQ(30,m.size());
+    ASSERT_EQ(30,std::distance(m.begin(),m.end()));
+
+    m.erase(0u);
+    ASSERT_EQ(0,m.count(0));
+    ASSERT_EQ(15,m.count(1));
+    ASSERT_EQ(15,m.size());
+}
+
+TEST(bitset_set,out_of_domain) {
+    // keys outside the domain are not stored, nor written past the words
+    tiny::bitset_set<10,int> s{1,2};
+    auto r=s.insert(10);
+    ASSERT_FALSE(r.second);
+    ASSERT_EQ(s.end(),r.first);
+    ASSERT_FALSE(s.insert(-1).second);
+    ASSERT_FALSE(s.insert(1000).second);
+    ASSERT_EQ(2,s.size());
+    ASSERT_EQ(0,s.count(10));
+
+    tiny::counted_bitset_set<16,unsigned,4> c;
+    c.insert(15u,3);
+    ASSERT_EQ(c.end(),c.insert(16u,2));
+    ASSERT_EQ(c.end(),c.insert(1000u));
+    ASSERT_EQ(3,c.size());
+    ASSERT_EQ(3,c.count(15));
+    ASSERT_EQ(0,c.count(16));
+}
@@ -0,0 +1,181 @@
+#include "little/compat.h"
+
+#include <string>
+#include <gtest/gtest.h>
+
+#include "little/cache.h"
+
+using namespace hf;
+
+// use this to check for correct ctor, dtor behaviour
+
+int g_dtor_count=0;
+int g_ctor_count=0;
+
+void reset_counts() {
+    g_dtor_count=g_ctor_count=0;
+}
+
+struct int_nontrivial {
+    int_nontrivial(int n_): n(n_) { ++g_ctor_count; }
+    int_nontrivial(const int_nontrivial &x): n(x.n) { ++g_ctor_count; }
+    int_nontrivial(int_nontrivial &&x): n(x.n) { ++g_ctor_count; }
+
+    int_nontrivial &operator=(const int_nontrivial &x) { n=x.n; return *this; }
+    int_nontrivial &operator=(int_nontrivial &&x) { n=x.n; return *this; }
+
+    ~int_nontrivial() { ++g_dtor_count; }
+
+    operator int() const { return n; }
+    int n;
+};
+
+template <typename T>
+class xcache: public ::testing::Test {};
+
+using cache_types=::testing::Types<tiny::lru_cache<int,int,4>,tiny::clock_cache<int,int,4>,
+                                   tiny::lru_cache<int_nontrivial,int_nontrivial,4>,tiny::clock_cache<int_nontrivial,int_nontrivial,4>,
+                                   tiny::lru_cache<int,int,4,hash_tagged<int>>>;
+TYPED_TEST_CASE(xcache,cache_types);
+
+TYPED_TEST(xcache,get_put) {
+    using cache=TypeParam;
+
+    reset_counts();
+    {
+        cache c;
+        ASSERT_TRUE(c.empty());
+        ASSERT_EQ(4,c.max_size());
+        ASSERT_EQ(nullptr,c.get(1));
+
+        c.put(1,10);
+        c.put(2,20);
+        c.put(1,11);
+        ASSERT_EQ(2,c.size());
+        ASSERT_EQ(11,*c.get(1));
+        ASSERT_EQ(20,*c.get(2));
+        *c.get(2)=21;
+        ASSERT_EQ(21,*c.get(2));
+
+        ASSERT_EQ(4,c.hits());
+        ASSERT_EQ(1,c.misses());
+
+        for (int k=3;k<20;++k) c.put(k,10*k);
+        ASSERT_EQ(4,c.size());
+        ASSERT_EQ(15,c.evictions());
+        for (int k=16;k<20;++k) ASSERT_TRUE(c.contains(k));
+
+        ASSERT_EQ(1,c.erase(17));
+        ASSERT_EQ(0,c.erase(17));
+        ASSERT_EQ(3,c.size());
+        ASSERT_EQ(180,*c.get(18));
+        ASSERT_EQ(190,*c.get(19));
+        ASSERT_EQ(160,*c.get(16));
+
+        cache d(c);
+        ASSERT_EQ(3,d.size());
+        ASSERT_EQ(190,*d.get(19));
+
+        c.reset_stats();
+        ASSERT_EQ(0,c.hits());
+        ASSERT_EQ(0,c.misses());
+    }
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+}
+
+TYPED_TEST(xcache,get_or_insert) {
+    using cache=TypeParam;
+
+    cache c;
+    int n_compute=0;
+    auto square=[&](int k) { return [&n_compute,k]() { ++n_compute; return k*k; }; };
+
+    for (int r=0;r<3;++r) {
+        for (int k=0;k<4;++k) ASSERT_EQ(k*k,c.get_or_insert(k,square(k)));
+    }
+    ASSERT_EQ(4,n_compute);
+    ASSERT_EQ(8,c.hits());
+    ASSERT_EQ(4,c.misses());
+}
+
+TEST(lru_cache,evicts_least_recent) {
+    tiny::lru_cache<int,int,3> c;
+    c.put(1,1);
+    c.put(2,2);
+    c.put(3,3);
+
+    c.get(1);
+    c.put(4,4); // evicts 2
+    ASSERT_TRUE(c.contains(1));
+    ASSERT_FALSE(c.contains(2));
+
+    c.get(3);
+    c.put(5,5); // evicts 1
+    ASSERT_FALSE(c.contains(1));
+    ASSERT_TRUE(c.contains(3));
+    ASSERT_TRUE(c.contains(4));
+    ASSERT_TRUE(c.contains(5));
+}
+
+TEST(clock_cache,second_chance) {
+    tiny::clock_cache<int,int,3> c;
+    c.put(1,1);
+    c.put(2,2);
+    c.put(3,3);
+
+    // all referenced: hand clears every bit, then evicts slot 0 (key 1)
+    c.put(4,4);
+    ASSERT_FALSE(c.contains(1));
+
+    // key 2 gets a second chance after a hit; key 3 is evicted
+    c.get(2);
+    c.put(5,5);
+    ASSERT_TRUE(c.contains(2));
+    ASSERT_FALSE(c.contains(3));
+}
+
+TEST(lru_cache,string_keys) {
+    tiny::lru_cache<std::string,int,2,hash_tagged<std::string>> c;
+    c.put("alpha",1);
+    c.put("beta",2);
+    c.get("alpha");
+    c.put("gamma",3);
+
+    ASSERT_TRUE(c.contains("alpha"));
+    ASSERT_FALSE(c.contains("beta"));
+    ASSERT_EQ(3,*c.get("gamma"));
+}
+
+TEST(cache,copy_partial) {
+    // copies of caches that are not full evict as the original does
+    tiny::lru_cache<int,int,3> l;
+    l.put(1,1);
+    l.put(2,2);
+    l.get(1);
+    tiny::lru_cache<int,int,3> lc(l);
+    lc.put(3,3);
+    lc.put(4,4); // evicts 2
+    ASSERT_TRUE(lc.contains(1));
+    ASSERT_FALSE(lc.contains(2));
+    ASSERT_FALSE(l.contains(3));
+
+    tiny::clock_cache<int,int,3> k;
+    k.put(1,1);
+    tiny::clock_cache<int,int,3> kc;
+    kc=k;
+    kc.put(2,2);
+    kc.put(3,3);
+    kc.put(4,4); // all referenced: evicts slot 0 (key 1)
+    ASSERT_FALSE(kc.contains(1));
+    ASSERT_TRUE(kc.contains(2));
+    ASSERT_TRUE(kc.contains(3));
+    ASSERT_TRUE(kc.contains(4));
+
+    tiny::lru_cache<std::string,int,4,hash_tagged<std::string>> s;
+    s.put("alpha",1);
+    s.put("beta",2);
+    tiny::lru_cache<std::string,int,4,hash_tagged<std::string>> sc(s);
+    ASSERT_EQ(1,*sc.get("alpha"));
+    ASSERT_EQ(2,*sc.get("beta"));
+    ASSERT_EQ(nullptr,sc.get("gamma"));
+}
@@ -0,0 +1,184 @@
+#include "little/compat.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "little/concurrent_map.h"
+
+using namespace hf;
+
+TEST(concurrent_map,read_write) {
+    tiny::concurrent_map<int,double,4> m{{1,1.5},{2,2.5},{1,3.5}};
+
+    ASSERT_EQ(2,m.size());
+    ASSERT_EQ(4,m.max_size());
+    ASSERT_EQ(3.5,m.at(1));
+    ASSERT_EQ(2.5,m.get_or(2,0.));
+    ASSERT_EQ(-1.,m.get_or(3,-1.));
+    ASSERT_THROW(m.at(3),std::out_of_range);
+
+    double v=0;
+    ASSERT_TRUE(m.get(2,v));
+    ASSERT_EQ(2.5,v);
+    ASSERT_FALSE(m.get(5,v));
+    ASSERT_EQ(2.5,v);
+
+    ASSERT_TRUE(m.insert_or_assign(3,4.5));
+    ASSERT_TRUE(m.insert_or_assign(4,5.5));
+    ASSERT_TRUE(m.insert_or_assign(4,6.5));
+    ASSERT_FALSE(m.insert_or_assign(5,7.5));
+    ASSERT_EQ(4,m.size());
+    ASSERT_EQ(0,m.count(5));
+    ASSERT_EQ(6.5,m.at(4));
+
+    ASSERT_TRUE(m.update(3,[](double &x) { x*=2; }));
+    ASSERT_FALSE(m.update(5,[](double &x) { x*=2; }));
+    ASSERT_EQ(9.,m.at(3));
+
+    // erasure moves the last entry into the erased slot
+    ASSERT_EQ(1,m.erase(1));
+    ASSERT_EQ(0,m.erase(1));
+    ASSERT_EQ(3,m.size());
+    ASSERT_EQ(6.5,m.at(4));
+    ASSERT_EQ(9.,m.at(3));
+
+    using ordered=std::map<int,double>;
+    tiny::map<int,double,4> expected{{4,6.5},{2,2.5},{3,9.}};
+    auto s=m.snapshot();
+    ASSERT_EQ(3,s.size());
+    ASSERT_EQ(ordered(expected.begin(),expected.end()),ordered(s.begin(),s.end()));
+
+    m.clear();
+    ASSERT_TRUE(m.empty());
+    ASSERT_EQ(0,m.count(2));
+
+    ASSERT_TRUE(m.assign(expected));
+    s=m.snapshot();
+    ASSERT_EQ(ordered(expected.begin(),expected.end()),ordered(s.begin(),s.end()));
+}
+
+TEST(concurrent_map,unaligned_entries) {
+    // keys and values that straddle storage words
+    struct rgb { std::uint8_t r,g,b; };
+    tiny::concurrent_map<std::uint16_t,rgb,7> m;
+
+    for (int i=0;i<7;++i) {
+        rgb c={std::uint8_t(i),std::uint8_t(2*i),std::uint8_t(3*i)};
+        ASSERT_TRUE(m.insert_or_assign(std::uint16_t(100+i),c));
+    }
+    ASSERT_EQ(1,m.erase(std::uint16_t(101)));
+
+    for (int i=0;i<7;++i) {
+        rgb c={0,0,0};
+        if (i==1) {
+            ASSERT_FALSE(m.get(std::uint16_t(100+i),c));
+            continue;
+        }
+        ASSERT_TRUE(m.get(std::uint16_t(100+i),c));
+        ASSERT_EQ(i,c.r);
+        ASSERT_EQ(2*i,c.g);
+        ASSERT_EQ(3*i,c.b);
+    }
+}
+
+namespace {
+// input iterator over pairs (k,k) for k in [0,n), throwing at k==bad
+struct throwing_iterator {
+    typedef std::input_iterator_tag iterator_category;
+    typedef std::pair<int,int> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type *pointer;
+    typedef const value_type &reference;
+
+    int k,bad;
+    value_type x;
+
+    throwing_iterator(int k_,int bad_): k(k_),bad(bad_),x(0,0) {}
+
+    reference operator*() {
+        if (k==bad) throw std::runtime_error("bad entry");
+        return x=value_type(k,k);
+    }
+    throwing_iterator &operator++() { ++k; return *this; }
+    bool operator!=(const throwing_iterator &other) const { return k!=other.k; }
+    bool operator==(const throwing_iterator &other) const { return k==other.k; }
+};
+}
+
+TEST(concurrent_map,throwing_writer) {
+    tiny::concurrent_map<int,int,4> m{{1,10},{2,20}};
+
+    ASSERT_THROW(m.update(1,[](int &v) { v=11; throw std::runtime_error("update"); }),std::runtime_error);
+    ASSERT_EQ(10,m.at(1));
+
+    // the lock was released: later writers and readers proceed
+    ASSERT_TRUE(m.update(1,[](int &v) { v+=1; }));
+    ASSERT_EQ(11,m.at(1));
+
+    ASSERT_THROW(m.assign(throwing_iterator(0,2),throwing_iterator(4,2)),std::runtime_error);
+    ASSERT_EQ(2,m.size());
+    ASSERT_EQ(0,m.at(0));
+    ASSERT_EQ(1,m.at(1));
+
+    ASSERT_TRUE(m.insert_or_assign(3,30));
+    ASSERT_EQ(30,m.at(3));
+}
+
+TEST(concurrent_map,consistent_readers) {
+    // The writer repeatedly replaces the contents with entries that all
+    // share one value, or erases and reinserts one of them; a reader
+    // should never see a mixture of values, nor a value decrease.
+
+    constexpr int n_keys=8;
+    constexpr int n_rounds=20000;
+    tiny::concurrent_map<int,std::int64_t,n_keys> m;
+
+    std::vector<std::pair<int,std::int64_t>> entries(n_keys);
+    for (int k=0;k<n_keys;++k) entries[k]={k,0};
+    m.assign(entries.begin(),entries.end());
+
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0);
+
+    auto reader=[&]() {
+        std::int64_t last=0;
+        while (!done.load()) {
+            auto s=m.snapshot();
+            if (s.size()<n_keys-1 || s.size()>n_keys) ++failures;
+
+            std::int64_t v=s.begin()->second;
+            for (const auto &e: s) if (e.second!=v) ++failures;
+            if (v<last) ++failures;
+            last=v;
+
+            std::int64_t x=-1;
+            if (m.get(0,x) && x<last) ++failures;
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i=0;i<4;++i) readers.emplace_back(reader);
+
+    for (std::int64_t r=1;r<=n_rounds;++r) {
+        for (auto &e: entries) e.second=r;
+        m.assign(entries.begin(),entries.end());
+
+        int k=1+r%(n_keys-1);
+        m.erase(k);
+        m.insert_or_assign(k,r);
+    }
+
+    done.store(true);
+    for (auto &t: readers) t.join();
+
+    ASSERT_EQ(0,failures.load());
+    ASSERT_EQ(n_rounds,m.at(0));
+}
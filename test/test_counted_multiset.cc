@@ -0,0 +1,183 @@
+#include "little/compat.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "little/counted_multiset.h"
+#include "little/multiset.h"
+
+using namespace hf;
+
+// use this to check for correct ctor, dtor behaviour
+
+int g_dtor_count=0;
+int g_ctor_count=0;
+
+void reset_counts() {
+    g_dtor_count=g_ctor_count=0;
+}
+
+struct int_nontrivial {
+    int_nontrivial(int n_): n(n_) { ++g_ctor_count; }
+    int_nontrivial(const int_nontrivial &x): n(x.n) { ++g_ctor_count; }
+    int_nontrivial(int_nontrivial &&x): n(x.n) { ++g_ctor_count; }
+
+    int_nontrivial &operator=(const int_nontrivial &x) { n=x.n; return *this; }
+    int_nontrivial &operator=(int_nontrivial &&x) { n=x.n; return *this; }
+
+    ~int_nontrivial() { ++g_dtor_count; }
+
+    operator int() const { return n; }
+    int n;
+};
+
+template <typename T>
+class xcounted_multiset: public ::testing::Test {};
+
+using counted_multiset_types=::testing::Types<small::counted_multiset<int>,small::counted_multiset<int_nontrivial>>;
+TYPED_TEST_CASE(xcounted_multiset,counted_multiset_types);
+
+template <typename C>
+std::vector<int> sorted_contents(const C &c) {
+    std::vector<int> x(c.begin(),c.end());
+    std::sort(x.begin(),x.end());
+    return x;
+}
+
+TYPED_TEST(xcounted_multiset,ctor) {
+    using mset=TypeParam;
+
+    reset_counts();
+    {
+        mset m({1,2,3,2,3,4,3,4,5});
+        ASSERT_EQ(9,m.size());
+        ASSERT_EQ(5,m.unique_size());
+        ASSERT_EQ((std::vector<int>{1,2,2,3,3,3,4,4,5}),sorted_contents(m));
+
+        mset c(m);
+        ASSERT_EQ(m,c);
+
+        mset d(std::move(c));
+        ASSERT_EQ(m,d);
+        ASSERT_TRUE(c.empty());
+
+        std::vector<int> ns={3,3,4,4,4};
+        mset r(ns.begin(),ns.end());
+        ASSERT_EQ(5,r.size());
+        ASSERT_EQ(2,r.unique_size());
+    }
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+}
+
+TYPED_TEST(xcounted_multiset,insert_count) {
+    using mset=TypeParam;
+
+    mset m;
+    ASSERT_TRUE(m.empty());
+
+    auto i=m.insert(7);
+    ASSERT_EQ(7,*i);
+    ASSERT_EQ(1,m.count(7));
+
+    m.insert(7,999);
+    m.insert(3,1000);
+    m.emplace(3);
+    m.insert(5,0);
+
+    ASSERT_EQ(2001,m.size());
+    ASSERT_EQ(2,m.unique_size());
+    ASSERT_EQ(1000,m.count(7));
+    ASSERT_EQ(1001,m.count(3));
+    ASSERT_EQ(0,m.count(5));
+    ASSERT_EQ(m.end(),m.find(5));
+    ASSERT_EQ(2001,std::distance(m.begin(),m.end()));
+
+    std::vector<std::pair<int,std::size_t>> counts;
+    for (auto c=m.counts_begin();c!=m.counts_end();++c) counts.emplace_back(c->first,c->second);
+    ASSERT_EQ((std::vector<std::pair<int,std::size_t>>{{7,1000},{3,1001}}),counts);
+
+    m.clear();
+    ASSERT_TRUE(m.empty());
+    ASSERT_EQ(m.begin(),m.end());
+}
+
+TYPED_TEST(xcounted_multiset,equality) {
+    using mset=TypeParam;
+
+    mset m1({1,2,3,2,3,4,3,4,5});
+    mset m2({5,4,4,2,3,2,3,3,1});
+    mset m3({5,4,4,2,3,2,3,3});
+    mset m4({5,4,4,2,3,2,3,3,2});
+
+    ASSERT_EQ(m1,m2);
+    ASSERT_NE(m1,m3);
+    ASSERT_NE(m1,m4);
+}
+
+TYPED_TEST(xcounted_multiset,erase) {
+    using mset=TypeParam;
+
+    mset m({1,2,3,2,3,4,3,4,5});
+
+    ASSERT_EQ(3,m.erase(3));
+    ASSERT_EQ(0,m.erase(3));
+    ASSERT_EQ(6,m.size());
+    ASSERT_EQ((std::vector<int>{1,2,2,4,4,5}),sorted_contents(m));
+
+    // erasing one copy leaves the iterator on the remaining copy
+    auto i=m.erase(m.find(2));
+    ASSERT_EQ(2,*i);
+    ASSERT_EQ(1,m.count(2));
+
+    // erasing the last copy of a key removes the entry
+    i=m.erase(m.find(2));
+    ASSERT_EQ(0,m.count(2));
+    ASSERT_EQ(3,m.unique_size());
+
+    // erasing everything by iterator
+    for (auto j=m.begin();j!=m.end();) j=m.erase(j);
+    ASSERT_TRUE(m.empty());
+    ASSERT_EQ(0,m.unique_size());
+}
+
+TYPED_TEST(xcounted_multiset,erase_if) {
+    using mset=TypeParam;
+
+    mset m({1,2,3,2,3,4,3,4,5});
+    ASSERT_EQ(5,erase_if(m,[](int x) { return x%2; }));
+    ASSERT_EQ((std::vector<int>{2,2,4,4}),sorted_contents(m));
+}
+
+TYPED_TEST(xcounted_multiset,batch_lookup) {
+    using mset=TypeParam;
+
+    mset m({1,2,3,2,3,4,3,4,5});
+    std::vector<int> queries={3,7,1,4};
+
+    std::vector<std::size_t> counts;
+    m.count_many(queries.begin(),queries.end(),std::back_inserter(counts));
+    ASSERT_EQ((std::vector<std::size_t>{3,0,1,2}),counts);
+
+    std::vector<bool> found;
+    m.contains_many(queries.begin(),queries.end(),std::back_inserter(found));
+    ASSERT_EQ((std::vector<bool>{true,false,true,true}),found);
+
+    std::vector<typename mset::const_iterator> iters;
+    m.find_many(queries.begin(),queries.end(),std::back_inserter(iters));
+    for (std::size_t i=0;i<queries.size();++i) ASSERT_EQ(m.find(queries[i]),iters[i]);
+}
+
+TEST(counted_multiset,matches_multiset) {
+    std::vector<int> values;
+    for (int i=0;i<200;++i) values.push_back((i*7)%11);
+
+    small::counted_multiset<int> counted(values.begin(),values.end());
+    small::multiset<int> plain(values.begin(),values.end());
+
+    ASSERT_EQ(plain.size(),counted.size());
+    for (int k=0;k<12;++k) ASSERT_EQ(plain.count(k),counted.count(k));
+    ASSERT_EQ(sorted_contents(plain),sorted_contents(counted));
+}
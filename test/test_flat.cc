@@ -0,0 +1,210 @@
+#include "little/compat.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+#include "little/flat.h"
+#include "little/map.h"
+#include "little/multiset.h"
+
+using namespace hf;
+
+namespace {
+// a flat image copied into suitably aligned storage
+struct image {
+    std::vector<char> buf;
+    const char *data;
+    std::size_t size;
+
+    explicit image(const std::string &s): buf(s.size()+64),size(s.size()) {
+        char *p=buf.data();
+        p+=(64-reinterpret_cast<std::uintptr_t>(p)%64)%64;
+        std::memcpy(p,s.data(),s.size());
+        data=p;
+    }
+};
+
+template <typename I>
+std::string write_image(I b,I e) {
+    std::ostringstream out;
+    tiny::write_flat(out,b,e);
+    return out.str();
+}
+}
+
+TEST(flat,multiset_round_trip) {
+    std::vector<tiny::multiset<int,5>> sets(3);
+    sets[0]={3,1,3};
+    sets[2]={7,8,9,10,11};
+
+    image img(write_image(sets.begin(),sets.end()));
+    tiny::view_array<tiny::multiset_view<int,5>> views(img.data,img.size);
+    ASSERT_EQ(3,views.size());
+
+    ASSERT_EQ(3,views[0].size());
+    ASSERT_EQ(2,views[0].count(3));
+    ASSERT_EQ(1,views[0].count(1));
+    ASSERT_EQ(0,views[0].count(7));
+    ASSERT_NE(views[0].end(),views[0].find(1));
+    ASSERT_EQ(views[0].end(),views[0].find(2));
+
+    ASSERT_TRUE(views[1].empty());
+    ASSERT_EQ(0,views[1].count(0));
+
+    ASSERT_EQ(5,views[2].size());
+    std::vector<int> keys(views[2].begin(),views[2].end());
+    ASSERT_EQ((std::vector<int>{7,8,9,10,11}),keys);
+
+    ASSERT_THROW(views.at(3),std::out_of_range);
+}
+
+TEST(flat,map_round_trip) {
+    std::vector<tiny::map<std::uint16_t,double,4>> maps(2);
+    maps[0][5]=0.5;
+    maps[0][2]=1.5;
+    maps[0][9]=2.5;
+    maps[1][1]=-1.;
+
+    image img(write_image(maps.begin(),maps.end()));
+    tiny::view_array<tiny::map_view<std::uint16_t,double,4>> views(img.data,img.size);
+    ASSERT_EQ(2,views.size());
+
+    auto v=views[0];
+    ASSERT_EQ(3,v.size());
+    ASSERT_EQ(1,v.count(2));
+    ASSERT_EQ(0,v.count(3));
+    ASSERT_EQ(1.5,v.at(2));
+    ASSERT_EQ(2.5,*v.get_ptr(9));
+    ASSERT_EQ(nullptr,v.get_ptr(4));
+    ASSERT_THROW(v.at(4),std::out_of_range);
+
+    for (std::size_t i=0;i<v.size();++i) ASSERT_EQ(maps[0].at(v.key(i)),v.value(i));
+
+    auto m=views[1].to_map();
+    ASSERT_EQ(1,m.size());
+    ASSERT_EQ(-1.,m.at(1));
+}
+
+TEST(flat,empty_array) {
+    std::vector<tiny::map<int,int,3>> maps;
+    image img(write_image(maps.begin(),maps.end()));
+    ASSERT_EQ(64,img.size);
+
+    tiny::view_array<tiny::map_view<int,int,3>> views(img.data,img.size);
+    ASSERT_TRUE(views.empty());
+}
+
+TEST(flat,header_validation) {
+    std::vector<tiny::map<int,int,3>> maps(4);
+    maps[1][1]=2;
+    std::string s=write_image(maps.begin(),maps.end());
+
+    typedef tiny::view_array<tiny::map_view<int,int,3>> int_maps;
+    {
+        image img(s);
+        ASSERT_NO_THROW(int_maps(img.data,img.size));
+
+        // truncated header or records
+        ASSERT_THROW(int_maps(img.data,32),std::runtime_error);
+        ASSERT_THROW(int_maps(img.data,img.size-1),std::runtime_error);
+
+        // misaligned image
+        ASSERT_THROW(int_maps(img.data+1,img.size-1),std::runtime_error);
+
+        // wrong capacity, value type or container kind
+        ASSERT_THROW((tiny::view_array<tiny::map_view<int,int,4>>(img.data,img.size)),std::runtime_error);
+        ASSERT_THROW((tiny::view_array<tiny::map_view<int,double,3>>(img.data,img.size)),std::runtime_error);
+        ASSERT_THROW((tiny::view_array<tiny::multiset_view<int,3>>(img.data,img.size)),std::runtime_error);
+    }
+    {
+        std::string bad=s;
+        bad[0]='X';
+        image img(bad);
+        ASSERT_THROW(int_maps(img.data,img.size),std::runtime_error);
+    }
+    {
+        // byte order tag at offset 6, version at offset 4
+        std::string bad=s;
+        std::swap(bad[6],bad[7]);
+        image img(bad);
+        ASSERT_THROW(int_maps(img.data,img.size),std::runtime_error);
+    }
+    {
+        std::string bad=s;
+        bad[4]+=1;
+        image img(bad);
+        ASSERT_THROW(int_maps(img.data,img.size),std::runtime_error);
+    }
+}
+
+TEST(flat,corrupt_count) {
+    std::vector<tiny::map<int,int,3>> maps(2);
+    maps[0][1]=10;
+    maps[1][2]=20;
+    std::vector<tiny::multiset<int,3>> sets(2);
+    sets[1]={5,6};
+
+    // patch the count of the first record, just after the header
+    std::string ms=write_image(maps.begin(),maps.end());
+    std::string ss=write_image(sets.begin(),sets.end());
+    std::uint32_t bad=1000;
+    std::memcpy(&ms[64],&bad,sizeof(bad));
+    std::memcpy(&ss[64],&bad,sizeof(bad));
+
+    // lookups stay within the record
+    image mimg(ms);
+    tiny::view_array<tiny::map_view<int,int,3>> maps_view(mimg.data,mimg.size);
+    ASSERT_EQ(3,maps_view[0].size());
+    ASSERT_EQ(10,maps_view[0].at(1));
+    ASSERT_EQ(0,maps_view[0].count(7));
+    ASSERT_EQ(20,maps_view[1].at(2));
+
+    image simg(ss);
+    tiny::view_array<tiny::multiset_view<int,3>> sets_view(simg.data,simg.size);
+    ASSERT_EQ(3,sets_view[0].size());
+    ASSERT_EQ(3,std::distance(sets_view[0].begin(),sets_view[0].end()));
+    ASSERT_EQ(0,sets_view[0].count(7));
+    ASSERT_EQ(1,sets_view[1].count(6));
+}
+
+#ifdef HF_HAVE_MMAP
+TEST(flat,mapped_file) {
+    std::vector<tiny::multiset<std::uint32_t,6>> sets(100);
+    for (std::uint32_t i=0;i<100;++i) {
+        for (std::uint32_t j=0;j<i%7;++j) sets[i].insert(i*j);
+    }
+
+    char path[]="/tmp/test_flat.XXXXXX";
+    int fd=mkstemp(path);
+    ASSERT_LE(0,fd);
+    ::close(fd);
+    {
+        std::ofstream out(path,std::ios::binary);
+        tiny::write_flat(out,sets.begin(),sets.end());
+    }
+
+    {
+        mapped_file f(path);
+        tiny::view_array<tiny::multiset_view<std::uint32_t,6>> views(f.data(),f.size());
+        ASSERT_EQ(100,views.size());
+        for (std::uint32_t i=0;i<100;++i) {
+            ASSERT_EQ(sets[i].size(),views[i].size());
+            for (std::uint32_t j=0;j<i%7;++j) ASSERT_EQ(sets[i].count(i*j),views[i].count(i*j));
+        }
+    }
+    std::remove(path);
+
+    ASSERT_THROW(mapped_file{path},std::system_error);
+}
+#endif
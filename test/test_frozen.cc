@@ -0,0 +1,79 @@
+#include "little/compat.h"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "little/frozen.h"
+
+using namespace hf;
+
+TEST(frozen_set,lookup) {
+    tiny::frozen_set<int,8> s{3,1,4,1,5,9,2,6};
+
+    ASSERT_EQ(7,s.size());
+    ASSERT_EQ(8,s.max_size());
+    for (int k: {1,2,3,4,5,6,9}) ASSERT_EQ(1,s.count(k));
+    for (int k: {0,7,8,10,-1}) ASSERT_EQ(0,s.count(k));
+
+    ASSERT_EQ(4,*s.find(4));
+    ASSERT_EQ(s.end(),s.find(7));
+
+    // entries in order of first occurrence
+    std::vector<int> keys(s.begin(),s.end());
+    ASSERT_EQ((std::vector<int>{3,1,4,5,9,2,6}),keys);
+
+    tiny::frozen_set<int,8> empty;
+    ASSERT_TRUE(empty.empty());
+    ASSERT_EQ(0,empty.count(0));
+}
+
+TEST(frozen_map,lookup) {
+    tiny::frozen_map<std::string,int,16> m{
+        {"add",1},{"sub",2},{"mul",3},{"div",4},{"mod",5},{"and",6},{"or",7},{"xor",8},{"sub",9}};
+
+    ASSERT_EQ(8,m.size());
+    ASSERT_EQ(1,m.at("add"));
+    ASSERT_EQ(9,m.at("sub"));
+    ASSERT_EQ(8,m.at("xor"));
+    ASSERT_THROW(m.at("not"),std::out_of_range);
+
+    ASSERT_EQ(nullptr,m.get_ptr("nop"));
+    ASSERT_EQ(5,*m.get_ptr("mod"));
+    ASSERT_EQ("or",m.find("or")->first);
+    ASSERT_EQ(m.end(),m.find("shl"));
+
+    auto copy=m;
+    ASSERT_EQ(m,copy);
+    ASSERT_EQ(7,copy.at("or"));
+}
+
+TEST(frozen_map,large) {
+    std::vector<std::pair<int,int>> entries;
+    for (int i=0;i<512;++i) entries.push_back({i*37-1000,i});
+
+    tiny::frozen_map<int,int,512> m(entries.begin(),entries.end());
+    ASSERT_EQ(512,m.size());
+    for (const auto &e: entries) ASSERT_EQ(e.second,m.at(e.first));
+    for (int k=-2000;k<20000;++k) {
+        bool present=k>=-1000 && k<512*37-1000 && (k+1000)%37==0;
+        ASSERT_EQ(present,m.count(k));
+    }
+}
+
+TEST(frozen_map,errors) {
+    std::vector<std::pair<int,int>> entries;
+    for (int i=0;i<5;++i) entries.push_back({i,i});
+
+    typedef tiny::frozen_map<int,int,4> map4;
+    ASSERT_THROW(map4(entries.begin(),entries.end()),std::length_error);
+
+    struct bad_hash {
+        std::size_t operator()(int k) const { return k/2; }
+    };
+    typedef tiny::frozen_map<int,int,4,bad_hash> bad_map;
+    ASSERT_THROW(bad_map({{2,0},{3,1}}),std::invalid_argument);
+    ASSERT_NO_THROW(bad_map({{2,0},{4,1}}));
+}
@@ -0,0 +1,109 @@
+#include "little/compat.h"
+
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "little/hash_tag.h"
+#include "little/interleave.h"
+#include "little/map.h"
+#include "little/multiset.h"
+
+using namespace hf;
+
+namespace {
+// n containers of up to 12 keys drawn from [0,20), with queries of
+// random keys in random containers
+template <typename C,typename Insert>
+std::vector<C> make_containers(std::size_t n,Insert insert) {
+    std::minstd_rand gen;
+    std::uniform_int_distribution<int> key(0,19),size(0,12);
+    std::vector<C> cs(n);
+    for (std::size_t i=0;i<n;++i) {
+        for (int j=size(gen);j>0;--j) insert(cs[i],key(gen));
+    }
+    return cs;
+}
+
+template <typename C,typename K=typename C::key_type>
+std::vector<std::pair<const C *,K>> make_queries(const std::vector<C> &cs,std::size_t n) {
+    std::minstd_rand gen(1);
+    std::uniform_int_distribution<std::size_t> which(0,cs.size()-1);
+    std::uniform_int_distribution<int> key(0,19);
+    std::vector<std::pair<const C *,K>> qs;
+    for (std::size_t i=0;i<n;++i) qs.emplace_back(&cs[which(gen)],key(gen));
+    return qs;
+}
+}
+
+TEST(interleave,small_map) {
+    typedef small::map<int,int> map_type;
+    auto maps=make_containers<map_type>(100,[](map_type &m,int k) { m[k]=k+1; });
+
+    for (std::size_t n: {0,1,5,16,1000}) {
+        auto qs=make_queries(maps,n);
+
+        std::vector<const int *> ptrs;
+        get_ptr_interleaved(qs.begin(),qs.end(),std::back_inserter(ptrs));
+        ASSERT_EQ(n,ptrs.size());
+
+        std::vector<std::size_t> counts;
+        count_interleaved<3>(qs.begin(),qs.end(),std::back_inserter(counts));
+        ASSERT_EQ(n,counts.size());
+
+        for (std::size_t i=0;i<n;++i) {
+            ASSERT_EQ(qs[i].first->get_ptr(qs[i].second),ptrs[i]);
+            ASSERT_EQ(qs[i].first->count(qs[i].second),counts[i]);
+        }
+    }
+}
+
+TEST(interleave,small_map_hash_tagged) {
+    typedef small::map<std::string,int,hash_tagged<std::string>> map_type;
+    auto maps=make_containers<map_type>(50,[](map_type &m,int k) { m[std::to_string(k)]=k; });
+
+    std::vector<std::pair<const map_type *,std::string>> qs;
+    for (auto q: make_queries<map_type,int>(maps,200)) qs.emplace_back(q.first,std::to_string(q.second));
+
+    std::vector<const int *> ptrs;
+    get_ptr_interleaved<1>(qs.begin(),qs.end(),std::back_inserter(ptrs));
+    for (std::size_t i=0;i<qs.size();++i) ASSERT_EQ(qs[i].first->get_ptr(qs[i].second),ptrs[i]);
+}
+
+TEST(interleave,multisets) {
+    typedef small::multiset<int> small_set;
+    typedef tiny::multiset<int,12> tiny_set;
+    auto smalls=make_containers<small_set>(100,[](small_set &s,int k) { s.insert(k); });
+    auto tinies=make_containers<tiny_set>(100,[](tiny_set &s,int k) { s.insert(k); });
+
+    // forward iterators suffice
+    auto small_qs=make_queries(smalls,500);
+    std::list<std::pair<const small_set *,int>> small_list(small_qs.begin(),small_qs.end());
+    std::vector<std::size_t> counts;
+    count_interleaved(small_list.begin(),small_list.end(),std::back_inserter(counts));
+    for (std::size_t i=0;i<small_qs.size();++i) ASSERT_EQ(small_qs[i].first->count(small_qs[i].second),counts[i]);
+
+    auto tiny_qs=make_queries(tinies,500);
+    counts.clear();
+    count_interleaved(tiny_qs.begin(),tiny_qs.end(),std::back_inserter(counts));
+    for (std::size_t i=0;i<tiny_qs.size();++i) ASSERT_EQ(tiny_qs[i].first->count(tiny_qs[i].second),counts[i]);
+}
+
+TEST(interleave,for_each) {
+    typedef tiny::map<int,int,12> map_type;
+    auto maps=make_containers<map_type>(20,[](map_type &m,int k) { m[k]=k; });
+    auto qs=make_queries(maps,100);
+
+    std::size_t i=0;
+    for_each_interleaved<4>(qs.begin(),qs.end(),[&](const map_type &m,int k) {
+        ASSERT_EQ(qs[i].first,&m);
+        ASSERT_EQ(qs[i].second,k);
+        ++i;
+    });
+    ASSERT_EQ(qs.size(),i);
+}
@@ -1,7 +1,14 @@
 #include "little/compat.h"
 
+#include <algorithm>
 #include <utility>
 #include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
 #include "little/map.h"
@@ -40,7 +47,9 @@ struct int_nontrivial {
 
 
 using map_types=::testing::Types<small::map<int,int>,small::map<int_nontrivial,int_nontrivial>,
-                                 tiny::map<int,int,20>,tiny::map<int_nontrivial,int_nontrivial,20>>;
+                                 tiny::map<int,int,20>,tiny::map<int_nontrivial,int_nontrivial,20>,
+                                 small::map<int,int,hash_tagged<int>>,tiny::map<int,int,20,hash_tagged<int>>,
+                                 small::map<int,int,hash_tagged<int>,std::allocator<std::pair<int,int>>,unordered_erase>>;
 TYPED_TEST_CASE(xmap,map_types);
 
 
@@ -128,6 +137,55 @@ TYPED_TEST(xmap,insert) {
     ASSERT_EQ(g_dtor_count,g_ctor_count);
 }
 
+TYPED_TEST(xmap,try_emplace) {
+    using map=TypeParam;
+
+    reset_counts();
+
+    {
+        map m({{1,2},{3,4}});
+
+        auto r1=m.try_emplace(5,6);
+        ASSERT_TRUE(r1.second);
+        ASSERT_EQ(5,r1.first->first);
+        ASSERT_EQ(6,r1.first->second);
+
+        // no construction of the mapped value if the key is present
+        typename map::key_type k(3);
+        int n_ctor=g_ctor_count;
+        auto r2=m.try_emplace(k,7);
+        ASSERT_FALSE(r2.second);
+        ASSERT_EQ(3,r2.first->first);
+        ASSERT_EQ(4,r2.first->second);
+        ASSERT_EQ(3,m.size());
+        ASSERT_EQ(n_ctor,g_ctor_count);
+    }
+
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+}
+
+TYPED_TEST(xmap,insert_or_assign) {
+    using map=TypeParam;
+
+    reset_counts();
+
+    {
+        map m({{1,2},{3,4}});
+
+        auto r1=m.insert_or_assign(5,6);
+        ASSERT_TRUE(r1.second);
+        ASSERT_EQ(6,m.at(5));
+
+        auto r2=m.insert_or_assign(3,7);
+        ASSERT_FALSE(r2.second);
+        ASSERT_EQ(3,r2.first->first);
+        ASSERT_EQ(7,r2.first->second);
+        ASSERT_EQ(3,m.size());
+    }
+
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+}
+
 TYPED_TEST(xmap,swap) {
     using map=TypeParam;
 
@@ -206,6 +264,53 @@ TYPED_TEST(xmap,iter_erase) {
     ASSERT_EQ(g_dtor_count,g_ctor_count);
 }
 
+TYPED_TEST(xmap,erase_if) {
+    using value_type=typename TestFixture::value_type;
+    using map=TypeParam;
+
+    reset_counts();
+
+    {
+        map m1({{1,2},{2,3},{3,4},{4,5},{5,6},{6,7}});
+        ASSERT_EQ(3,erase_if(m1,[](const value_type &x) { return x.second%2==0; }));
+        ASSERT_EQ(map({{2,3},{4,5},{6,7}}),m1);
+
+        ASSERT_EQ(0,m1.remove_if([](const value_type &x) { return x.first>6; }));
+        ASSERT_EQ(1,m1.remove_if([](const value_type &x) { return x.first==4; }));
+        ASSERT_EQ(2,m1.size());
+        ASSERT_EQ(0,m1.count(4));
+        ASSERT_EQ(7,m1.at(6));
+    }
+
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+}
+
+TYPED_TEST(xmap,batch_lookup) {
+    using map=TypeParam;
+    using key_type=typename map::key_type;
+
+    map m1({{1,2},{3,2},{4,5},{6,7},{8,9}});
+
+    // more queries than one block
+    std::vector<key_type> queries;
+    for (int i=0;i<40;++i) queries.push_back(key_type(i%11));
+
+    std::vector<std::size_t> counts;
+    m1.count_many(queries.begin(),queries.end(),std::back_inserter(counts));
+    ASSERT_EQ(queries.size(),counts.size());
+    for (std::size_t j=0;j<queries.size();++j) ASSERT_EQ(m1.count(queries[j]),counts[j]);
+
+    std::vector<typename map::const_iterator> found;
+    m1.find_many(queries.begin(),queries.end(),std::back_inserter(found));
+    ASSERT_EQ(queries.size(),found.size());
+    for (std::size_t j=0;j<queries.size();++j) ASSERT_EQ(m1.find(queries[j]),found[j]);
+
+    std::vector<bool> contains;
+    m1.contains_many(queries.begin(),queries.end(),std::back_inserter(contains));
+    ASSERT_EQ(queries.size(),contains.size());
+    for (std::size_t j=0;j<queries.size();++j) ASSERT_EQ(m1.count(queries[j])>0,contains[j]);
+}
+
 TYPED_TEST(xmap,bracket) {
     using map=TypeParam;
 
@@ -256,6 +361,387 @@ TYPED_TEST(xmap,at) {
     ASSERT_EQ(g_dtor_count,g_ctor_count);
 }
 
+TYPED_TEST(xmap,mutable_access) {
+    using map=TypeParam;
+
+    reset_counts();
+
+    {
+        map m1({{1,2},{2,3},{4,5}});
+
+        auto i=m1.find_mut(2);
+        ASSERT_NE(m1.end_mut(),i);
+        ASSERT_EQ(2,i->first);
+        i->second=7;
+        ASSERT_EQ(7,m1.at(2));
+        ASSERT_EQ(m1.end_mut(),m1.find_mut(3));
+
+        for (auto j=m1.begin_mut();j!=m1.end_mut();++j) (*j).second=(*j).second+1;
+        ASSERT_EQ(3,m1.at(1));
+        ASSERT_EQ(8,m1.at(2));
+        ASSERT_EQ(6,m1.at(4));
+        ASSERT_EQ(3,m1.end_mut()-m1.begin_mut());
+
+        ASSERT_EQ(nullptr,m1.get_ptr(3));
+        *m1.get_ptr(4)=9;
+        ASSERT_EQ(9,*static_cast<const map &>(m1).get_ptr(4));
+
+        auto incr=[](decltype(m1.at(1)) &x) { x=x+1; };
+        ASSERT_TRUE(m1.update(1,incr));
+        ASSERT_FALSE(m1.update(3,incr));
+        ASSERT_EQ(4,m1.at(1));
+        ASSERT_EQ(3,m1.size());
+
+        ASSERT_EQ(5,m1.upsert(1,0,incr));
+        ASSERT_EQ(10,m1.upsert(3,10,incr));
+        ASSERT_EQ(4,m1.size());
+        ASSERT_EQ(10,m1.at(3));
+        ASSERT_EQ(5,m1.at(1));
+    }
+
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+}
+
+TYPED_TEST(xmap,insert_existing) {
+    using map=TypeParam;
+
+    map m1({{1,2},{2,3}});
+    auto i=m1.find(2);
+    auto j=m1.insert({2,4});
+
+    // an existing entry is updated in place
+    ASSERT_EQ(i,j);
+    ASSERT_EQ(4,m1.at(2));
+    ASSERT_EQ(2,m1.size());
+}
+
+TYPED_TEST(xmap,bulk_insert) {
+    using map=TypeParam;
+
+    // 600 entries with 15 distinct keys, enough to take the bulk path
+    std::vector<std::pair<int,int>> entries;
+    for (int i=0;i<600;++i) entries.push_back({(i*7)%15,i});
+
+    reset_counts();
+
+    {
+        map last(entries.begin(),entries.end());
+        map first(entries.begin(),entries.end(),first_wins());
+
+        // same entries in the same order as element-wise insertion
+        map last_ref,first_ref;
+        for (const auto &e: entries) {
+            last_ref.insert(e);
+            first_ref.emplace(e);
+        }
+        ASSERT_EQ(15,last.size());
+        ASSERT_EQ(15,first.size());
+        ASSERT_TRUE(std::equal(last.begin(),last.end(),last_ref.begin()));
+        ASSERT_TRUE(std::equal(first.begin(),first.end(),first_ref.begin()));
+        ASSERT_EQ(594,last.at(3));
+        ASSERT_EQ(9,first.at(3));
+
+        // existing entries are assigned in place, or kept
+        map m({{3,-1},{20,-2}});
+        m.insert(entries.begin(),entries.end(),first_wins());
+        ASSERT_EQ(16,m.size());
+        ASSERT_EQ(3,m.begin()->first);
+        ASSERT_EQ(-1,m.at(3));
+        ASSERT_EQ(-2,m.at(20));
+
+        m.insert(entries.begin(),entries.end());
+        ASSERT_EQ(16,m.size());
+        ASSERT_EQ(594,m.at(3));
+
+        // ranges of other entry types are converted (std::map keeps the
+        // first value for each key)
+        std::map<int,int> source(entries.begin(),entries.end());
+        m.assign_unique(source.begin(),source.end());
+        ASSERT_EQ(15,m.size());
+        ASSERT_EQ(first,m);
+
+        m.assign_unique(entries.begin(),entries.begin()+3,first_wins());
+        ASSERT_EQ(3,m.size());
+    }
+
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+}
+
+TEST(tinymap,bulk_insert_overflow) {
+    std::vector<std::pair<int,int>> entries;
+    for (int i=0;i<600;++i) entries.push_back({i%40,i});
+
+    // bulk insertion that would overflow falls back to the policy
+    tiny::map<int,int,32,std::equal_to<int>,evict_oldest> m(entries.begin(),entries.end());
+    ASSERT_EQ(32,m.size());
+    ASSERT_EQ(599,m.at(39));
+
+    tiny::map<int,int,32,std::equal_to<int>,throw_overflow> t;
+    ASSERT_THROW(t.insert(entries.begin(),entries.end()),std::length_error);
+}
+
+// capacity overflow policies
+
+template <typename T>
+class xmap_overflow: public ::testing::Test {};
+
+using map_overflow_types=::testing::Types<int,int_nontrivial>;
+TYPED_TEST_CASE(xmap_overflow,map_overflow_types);
+
+TYPED_TEST(xmap_overflow,policies) {
+    using value_type=TypeParam;
+    using eq=std::equal_to<value_type>;
+
+    tiny::map<value_type,value_type,2,eq,throw_overflow> t({{1,10},{2,20}});
+    ASSERT_THROW(t[3],std::length_error);
+    ASSERT_THROW(t.emplace(3,30),std::length_error);
+    ASSERT_NO_THROW(t[2]=21);
+    ASSERT_EQ(2,t.size());
+
+    tiny::map<value_type,value_type,2,eq,fail_overflow> f({{1,10},{2,20}});
+    ASSERT_EQ(f.end(),f.insert({3,30}));
+    ASSERT_FALSE(f.emplace(3,30).second);
+    ASSERT_FALSE(f.try_emplace(3,30).second);
+    ASSERT_FALSE(f.insert_or_assign(3,30).second);
+    ASSERT_TRUE(f.insert_or_assign(2,21).first!=f.end());
+    ASSERT_THROW(f[3],std::length_error);
+    ASSERT_EQ(2,f.size());
+    ASSERT_EQ(0,f.count(3));
+
+    reset_counts();
+    {
+        tiny::map<value_type,value_type,2,eq,evict_oldest> e({{1,10},{2,20}});
+        e[3]=30;
+        ASSERT_EQ(2,e.size());
+        ASSERT_EQ(0,e.count(1));
+        ASSERT_EQ(20,e.at(2));
+        ASSERT_EQ(30,e.at(3));
+
+        e.emplace(4,40);
+        ASSERT_EQ(0,e.count(2));
+        ASSERT_EQ(30,e.at(3));
+        ASSERT_EQ(40,e.at(4));
+    }
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+
+    tiny::map<value_type,value_type,2> u({{1,10}});
+    ASSERT_TRUE(u.try_insert({2,20}).second);
+    ASSERT_FALSE(u.try_insert({2,21}).second);
+    ASSERT_EQ(20,u.at(2));
+
+    auto r=u.try_insert({3,30});
+    ASSERT_FALSE(r.second);
+    ASSERT_EQ(u.end(),r.first);
+}
+
+TEST(map_overflow,tagged_evict) {
+    tiny::map<int,int,3,hash_tagged<int>,evict_oldest> e({{1,10},{2,20},{3,30}});
+    for (int k=4;k<20;++k) {
+        e[k]=10*k;
+        ASSERT_EQ(3,e.size());
+        for (int j=k-2;j<=k;++j) ASSERT_EQ(10*j,e.at(j));
+        ASSERT_EQ(0,e.count(k-3));
+    }
+}
+
+// trivial copies and swaps of partly and completely full maps
+
+TEST(tinymap,copy_swap_fill) {
+    using map=tiny::map<int,int,4,hash_tagged<int>>;
+
+    map full({{1,10},{2,20},{3,30},{4,40}}),part({{5,50}});
+
+    map a(full),b(part);
+    ASSERT_EQ(full,a);
+    ASSERT_EQ(part,b);
+
+    a.swap(b);
+    ASSERT_EQ(part,a);
+    ASSERT_EQ(full,b);
+    ASSERT_EQ(50,a.at(5));
+    for (int k=1;k<=4;++k) ASSERT_EQ(10*k,b.at(k));
+
+    map c;
+    c.swap(b);
+    ASSERT_TRUE(b.empty());
+    ASSERT_EQ(full,c);
+    ASSERT_EQ(0,c.count(5));
+
+    b=part;
+    ASSERT_EQ(50,b.at(5));
+    ASSERT_EQ(0,b.count(1));
+    b=c;
+    for (int k=1;k<=4;++k) ASSERT_EQ(10*k,b.at(k));
+}
+
+// trivially relocatable entries, and non-trivial mapped types
+
+TEST(tinymap,relocate) {
+    using ptr=std::unique_ptr<int>;
+    using map=tiny::map<int,ptr,8,hash_tagged<int>>;
+
+    map a,b;
+    for (int i=0;i<5;++i) a[i]=ptr(new int(10*i));
+    b[7]=ptr(new int(70));
+
+    a.swap(b);
+    ASSERT_EQ(1,a.size());
+    ASSERT_EQ(70,*a.at(7));
+    ASSERT_EQ(5,b.size());
+    for (int i=0;i<5;++i) ASSERT_EQ(10*i,*b.at(i));
+
+    ASSERT_EQ(1,b.erase(1));
+    ASSERT_EQ(0,b.count(1));
+    for (int i: {0,2,3,4}) ASSERT_EQ(10*i,*b.at(i));
+
+    map c(std::move(b));
+    ASSERT_TRUE(b.empty());
+    for (int i: {0,2,3,4}) ASSERT_EQ(10*i,*c.at(i));
+
+    a=std::move(c);
+    ASSERT_TRUE(c.empty());
+    ASSERT_EQ(4,a.size());
+    ASSERT_EQ(30,*a.at(3));
+}
+
+TEST(tinymap,nontrivial_value) {
+    reset_counts();
+    {
+        tiny::map<int,int_nontrivial,4> m({{1,10},{2,20}});
+        m.erase(1);
+        m.clear();
+        m[3]=30;
+    }
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+}
+
+// self-organising access order
+
+template <typename T>
+class xmap_access: public ::testing::Test {};
+
+using map_access_types=::testing::Types<small::map<int,int,std::equal_to<int>,std::allocator<std::pair<int,int>>,stable_erase,move_to_front>,
+                                        small::map<int_nontrivial,int,hash_tagged<int>,std::allocator<std::pair<int_nontrivial,int>>,stable_erase,move_to_front>,
+                                        tiny::map<int,int,10,std::equal_to<int>,unchecked_overflow,move_to_front>,
+                                        tiny::map<int_nontrivial,int,10,hash_tagged<int>,unchecked_overflow,move_to_front>>;
+TYPED_TEST_CASE(xmap_access,map_access_types);
+
+template <typename M>
+std::vector<int> key_order(const M &m) {
+    std::vector<int> keys;
+    for (const auto &kv: m) keys.push_back(kv.first);
+    return keys;
+}
+
+TYPED_TEST(xmap_access,move_to_front) {
+    using map=TypeParam;
+
+    map m({{1,10},{2,20},{3,30},{4,40}});
+    const map &cm=m;
+
+    ASSERT_EQ(30,cm.find(3)->second);
+    ASSERT_EQ((std::vector<int>{1,2,3,4}),key_order(m));
+
+    auto i=m.find(3);
+    ASSERT_EQ(m.begin(),i);
+    ASSERT_EQ(30,i->second);
+    ASSERT_EQ((std::vector<int>{3,1,2,4}),key_order(m));
+
+    ASSERT_EQ(m.end(),m.find(5));
+    ASSERT_EQ((std::vector<int>{3,1,2,4}),key_order(m));
+
+    ASSERT_EQ(40,m.at(4));
+    ASSERT_EQ((std::vector<int>{4,3,1,2}),key_order(m));
+
+    m[2]=21;
+    ASSERT_EQ((std::vector<int>{2,4,3,1}),key_order(m));
+
+    // lookups still find every entry after reordering
+    for (int k=1;k<=4;++k) ASSERT_EQ(1,m.count(k));
+    ASSERT_EQ(21,cm.at(2));
+    ASSERT_EQ(10,cm.at(1));
+}
+
+TEST(map_access,transpose) {
+    small::map<int,int,hash_tagged<int>,std::allocator<std::pair<int,int>>,stable_erase,transpose> s({{1,10},{2,20},{3,30},{4,40}});
+    tiny::map<int,int,10,std::equal_to<int>,unchecked_overflow,transpose> t({{1,10},{2,20},{3,30},{4,40}});
+
+    ASSERT_EQ(40,s.find(4)->second);
+    ASSERT_EQ(40,t.find(4)->second);
+    ASSERT_EQ((std::vector<int>{1,2,4,3}),key_order(s));
+    ASSERT_EQ((std::vector<int>{1,2,4,3}),key_order(t));
+
+    s.at(4);
+    t.at(4);
+    s[1];
+    t[1];
+    ASSERT_EQ((std::vector<int>{1,4,2,3}),key_order(s));
+    ASSERT_EQ((std::vector<int>{1,4,2,3}),key_order(t));
+
+    for (int k=1;k<=4;++k) {
+        ASSERT_EQ(10*k,s.find(k)->second);
+        ASSERT_EQ(10*k,t.find(k)->second);
+    }
+}
+
+TEST(map_access,evict_oldest) {
+    // a reordering access policy evicts the coldest entry, not the hottest
+    tiny::map<int,int,3,std::equal_to<int>,evict_oldest,move_to_front> m({{1,10},{2,20},{3,30}});
+    m.find(1);
+    m.find(1);
+    m[4]=40;
+    ASSERT_EQ((std::vector<int>{1,2,4}),key_order(m));
+
+    tiny::map<int,int,3,hash_tagged<int>,evict_oldest,transpose> t({{1,10},{2,20},{3,30}});
+    t.find(3);
+    t[4]=40;
+    ASSERT_EQ((std::vector<int>{1,3,4}),key_order(t));
+    ASSERT_EQ(30,t.at(3));
+    ASSERT_EQ(40,t.at(4));
+    ASSERT_EQ(0,t.count(2));
+
+    // static order still evicts the oldest
+    tiny::map<int,int,3,std::equal_to<int>,evict_oldest> s({{1,10},{2,20},{3,30}});
+    s.find(1);
+    s[4]=40;
+    ASSERT_EQ((std::vector<int>{2,3,4}),key_order(s));
+}
+
+// equality and hashing above the sorted comparison threshold
+
+template <typename T>
+class xmap_large: public ::testing::Test {};
+
+using map_large_types=::testing::Types<small::map<int,int>,small::map<int_nontrivial,int_nontrivial>,
+                                       tiny::map<int,int,100>,tiny::map<int_nontrivial,int_nontrivial,100>,
+                                       small::map<int,int,hash_tagged<int>>>;
+TYPED_TEST_CASE(xmap_large,map_large_types);
+
+TYPED_TEST(xmap_large,equality) {
+    using map=TypeParam;
+
+    map m1,m2;
+    for (int i=0;i<90;++i) {
+        m1[i]=i*i;
+        m2[89-i]=(89-i)*(89-i);
+    }
+
+    map m3(m2);
+    m3[17]=0;
+
+    map m4(m2);
+    m4.erase(m4.find(17));
+    m4[90]=17*17;
+
+    ASSERT_EQ(m1,m2);
+    ASSERT_NE(m1,m3);
+    ASSERT_NE(m1,m4);
+
+    map_hash<map,std::hash<int>,std::hash<int>> hash;
+    ASSERT_EQ(hash(m1),hash(m2));
+    ASSERT_NE(hash(m1),hash(m3));
+}
+
 
 template <typename T>
 class xmap_nonstd_eq: public ::testing::Test {
@@ -301,3 +787,108 @@ TYPED_TEST(xmap_nonstd_eq,key_eq) {
     ASSERT_EQ(3,eq.k);
 }
 
+
+template <typename T>
+class xmap_tagged: public ::testing::Test {};
+
+using map_tagged_types=::testing::Types<small::map<std::string,int,hash_tagged<std::string>>,tiny::map<std::string,int,40,hash_tagged<std::string>>>;
+TYPED_TEST_CASE(xmap_tagged,map_tagged_types);
+
+TYPED_TEST(xmap_tagged,find) {
+    using map=TypeParam;
+
+    // enough entries to cover both the blocked and the tail tag search
+    map m;
+    for (int i=0;i<37;++i) m["key"+std::to_string(i)]=i;
+    ASSERT_EQ(37,m.size());
+
+    for (int i=0;i<37;++i) ASSERT_EQ(i,m.at("key"+std::to_string(i)));
+    ASSERT_EQ(m.end(),m.find("key37"));
+    ASSERT_EQ(m.end(),m.find(""));
+
+    ASSERT_EQ(1,m.erase("key3"));
+    ASSERT_EQ(1,m.erase("key20"));
+    ASSERT_EQ(0,m.count("key3"));
+    ASSERT_EQ(0,m.count("key20"));
+    for (int i=0;i<37;++i) {
+        if (i==3 || i==20) continue;
+        ASSERT_EQ(i,m.at("key"+std::to_string(i)));
+    }
+
+    map m2({{"a",1},{"b",2}});
+    m2.swap(m);
+    ASSERT_EQ(2,m.size());
+    ASSERT_EQ(2,m.at("b"));
+    ASSERT_EQ(35,m2.size());
+    ASSERT_EQ(36,m2.at("key36"));
+
+    map m3(m2);
+    ASSERT_EQ(m2,m3);
+    ASSERT_EQ(36,m3.at("key36"));
+}
+
+template <typename T>
+class xmap_transparent: public ::testing::Test {};
+
+// transparent equality and hash: int_nontrivial keys can be compared
+// directly with int, without constructing an int_nontrivial
+struct eq_transparent {
+    typedef void is_transparent;
+    bool operator()(int a,int b) const { return a==b; }
+};
+
+struct hash_transparent {
+    typedef void is_transparent;
+    std::size_t operator()(int a) const { return std::hash<int>()(a); }
+};
+
+using map_transparent_types=::testing::Types<
+    small::map<int_nontrivial,int,eq_transparent>,
+    tiny::map<int_nontrivial,int,20,eq_transparent>,
+    small::map<int_nontrivial,int,hash_tagged<int_nontrivial,hash_transparent,eq_transparent>>,
+    tiny::map<int_nontrivial,int,20,hash_tagged<int_nontrivial,hash_transparent,eq_transparent>>>;
+TYPED_TEST_CASE(xmap_transparent,map_transparent_types);
+
+TYPED_TEST(xmap_transparent,lookup) {
+    using map=TypeParam;
+
+    reset_counts();
+
+    {
+        map m({{1,2},{3,4},{5,6}});
+        int n_ctor=g_ctor_count;
+
+        ASSERT_EQ(1,m.count(3));
+        ASSERT_EQ(0,m.count(4));
+        ASSERT_NE(m.end(),m.find(5));
+        ASSERT_EQ(m.end(),m.find(7));
+        ASSERT_EQ(2,m.at(1));
+        ASSERT_EQ(2,static_cast<const map &>(m).at(1));
+        ASSERT_THROW(m.at(9),std::out_of_range);
+        m[1]=10;
+        ASSERT_EQ(10,m.at(1));
+        ASSERT_EQ(n_ctor,g_ctor_count);
+
+        // new key constructed in place only on insertion
+        m[7]=8;
+        ASSERT_EQ(n_ctor+1,g_ctor_count);
+        ASSERT_EQ(8,m.at(7));
+        ASSERT_EQ(4,m.size());
+
+        ASSERT_EQ(1,m.erase(3));
+        ASSERT_EQ(0,m.erase(3));
+        ASSERT_EQ(3,m.size());
+    }
+
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+}
+
+TEST(tinymap,footprint) {
+    ASSERT_EQ(13u,sizeof(tiny::map<std::uint8_t,std::uint8_t,6>));
+    ASSERT_EQ(60u,sizeof(tiny::map<int,int,7>));
+
+    tiny::map<std::uint8_t,std::uint8_t,6> m({{1,2},{3,4}});
+    m[5]=6;
+    ASSERT_EQ(3u,m.size());
+    ASSERT_EQ(6,m.at(5));
+}
@@ -0,0 +1,143 @@
+#include "little/compat.h"
+
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "little/map.h"
+#include "little/map_pool.h"
+
+using namespace hf;
+
+TEST(map_pool,map_ref) {
+    tiny::map_pool<int,float,4> pool(2);
+    ASSERT_EQ(2,pool.size());
+
+    auto m=pool[1];
+    ASSERT_TRUE(m.empty());
+    ASSERT_EQ(4,m.max_size());
+
+    ASSERT_TRUE(m.insert(3,1.5f));
+    ASSERT_FALSE(m.insert(3,2.5f));
+    ASSERT_EQ(2.5f,m.at(3));
+    m[7]=4.f;
+    m[7]+=1.f;
+    ASSERT_EQ(5.f,*m.get_ptr(7));
+    ASSERT_EQ(nullptr,m.get_ptr(8));
+    ASSERT_THROW(m.at(8),std::out_of_range);
+    ASSERT_EQ(2,m.size());
+    ASSERT_EQ(1,m.count(7));
+
+    ASSERT_TRUE(m.try_insert(8,1.f));
+    ASSERT_FALSE(m.try_insert(8,2.f));
+    ASSERT_EQ(1.f,m.at(8));
+
+    // other maps are unaffected
+    ASSERT_TRUE(pool[0].empty());
+    ASSERT_EQ(0,pool[0].count(3));
+
+    ASSERT_EQ(1,m.erase(3));
+    ASSERT_EQ(0,m.erase(3));
+    ASSERT_EQ(2,m.size());
+
+    std::vector<std::pair<int,float>> entries;
+    m.for_each([&](const int &k,float &v) { entries.emplace_back(k,v); });
+    ASSERT_EQ((std::vector<std::pair<int,float>>{{8,1.f},{7,5.f}}),entries);
+
+    const auto &cpool=pool;
+    ASSERT_EQ(5.f,cpool[1].at(7));
+
+    tiny::map_pool<int,float,4>::handle h=pool.add();
+    ASSERT_EQ(2u,h);
+    ASSERT_EQ(3,pool.size());
+    ASSERT_TRUE(pool[h].empty());
+    ASSERT_EQ(5.f,pool[1].at(7));
+
+    m.clear();
+    ASSERT_TRUE(pool[1].empty());
+}
+
+TEST(map_pool,overflow) {
+    tiny::map_pool<int,int,2,std::equal_to<int>,fail_overflow> fail_pool(2);
+    ASSERT_TRUE(fail_pool[0].insert(1,1));
+    ASSERT_TRUE(fail_pool[0].insert(2,2));
+    ASSERT_FALSE(fail_pool[0].insert(3,3));
+    ASSERT_THROW(fail_pool[0][4],std::length_error);
+    ASSERT_EQ(2,fail_pool[0].size());
+    ASSERT_TRUE(fail_pool[1].empty());
+
+    tiny::map_pool<int,int,2,std::equal_to<int>,throw_overflow> throw_pool(1);
+    throw_pool[0][1]=1;
+    throw_pool[0][2]=2;
+    ASSERT_THROW(throw_pool[0].insert(3,3),std::length_error);
+
+    tiny::map_pool<int,int,3,std::equal_to<int>,evict_oldest> evict_pool(2);
+    for (int i=1;i<=5;++i) evict_pool[0][i]=10*i;
+    ASSERT_EQ(3,evict_pool[0].size());
+    ASSERT_EQ(0,evict_pool[0].count(2));
+    ASSERT_EQ(30,evict_pool[0].at(3));
+    ASSERT_EQ(50,evict_pool[0].at(5));
+    ASSERT_TRUE(evict_pool[1].empty());
+}
+
+TEST(map_pool,bulk) {
+    tiny::map_pool<int,int,8> pool(100);
+    for (std::size_t h=0;h<pool.size();++h) {
+        for (int k=0;k<(int)(h%9);++k) pool[h][k]=(int)h;
+    }
+
+    std::size_t n=0;
+    pool.for_each([&](std::size_t h,const int &k,int &v) {
+        ASSERT_EQ((int)h,v);
+        ASSERT_LT(k,(int)(h%9));
+        ++v;
+        ++n;
+    });
+    std::size_t expected=0;
+    for (std::size_t h=0;h<100;++h) expected+=h%9;
+    ASSERT_EQ(expected,n);
+    ASSERT_EQ(43,pool[42].at(0));
+
+    pool.clear_all();
+    for (std::size_t h=0;h<pool.size();++h) ASSERT_TRUE(pool[h].empty());
+    ASSERT_EQ(100,pool.size());
+}
+
+TEST(map_pool,against_tiny_map) {
+    // random operations on a pool and on separate tiny maps agree
+    constexpr std::size_t M=50;
+    tiny::map_pool<int,int,8> pool(M);
+    std::vector<tiny::map<int,int,8>> maps(M);
+
+    std::minstd_rand gen;
+    std::uniform_int_distribution<std::size_t> which(0,M-1);
+    std::uniform_int_distribution<int> key(0,11);
+    std::uniform_int_distribution<int> op(0,2);
+
+    for (int i=0;i<20000;++i) {
+        std::size_t h=which(gen);
+        int k=key(gen);
+        switch (op(gen)) {
+        case 0:
+            if (maps[h].size()<8 || maps[h].count(k)) {
+                maps[h][k]=i;
+                pool[h][k]=i;
+            }
+            break;
+        case 1:
+            ASSERT_EQ(maps[h].erase(k),pool[h].erase(k));
+            break;
+        default:
+            ASSERT_EQ(maps[h].count(k),pool[h].count(k));
+        }
+    }
+
+    for (std::size_t h=0;h<M;++h) {
+        std::map<int,int> a(maps[h].begin(),maps[h].end()),b;
+        pool[h].for_each([&](int k,int v) { b[k]=v; });
+        ASSERT_EQ(a,b);
+    }
+}
@@ -2,6 +2,10 @@
 
 #include <utility>
 #include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
 #include <gtest/gtest.h>
 
 #include "little/multiset.h"
@@ -37,7 +41,8 @@ struct int_nontrivial {
     int n;
 };
 
-using multiset_types=::testing::Types<tiny::multiset<int,20>,tiny::multiset<int_nontrivial,20>,small::multiset<int>>;
+using multiset_types=::testing::Types<tiny::multiset<int,20>,tiny::multiset<int_nontrivial,20>,small::multiset<int>,
+                                      small::multiset<int_nontrivial,std::equal_to<int_nontrivial>,std::allocator<int_nontrivial>,unordered_erase>>;
 TYPED_TEST_CASE(xmultiset,multiset_types);
 
 
@@ -242,6 +247,285 @@ TYPED_TEST(xmultiset,iter_erase) {
     ASSERT_EQ(g_dtor_count,g_ctor_count);
 }
 
+TYPED_TEST(xmultiset,erase_if) {
+    using value_type=typename TestFixture::value_type;
+    using mset=TypeParam;
+
+    reset_counts();
+
+    {
+        mset m1({1,2,3,2,3,4,3,4,5});
+        ASSERT_EQ(5,erase_if(m1,[](const value_type &x) { return x%2==1; }));
+        ASSERT_EQ(4,m1.size());
+        ASSERT_EQ(mset({2,2,4,4}),m1);
+
+        ASSERT_EQ(0,m1.remove_if([](const value_type &x) { return x>4; }));
+        ASSERT_EQ(4,m1.remove_if([](const value_type &x) { return x<=4; }));
+        ASSERT_TRUE(m1.empty());
+    }
+
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+}
+
+TYPED_TEST(xmultiset,batch_lookup) {
+    using value_type=typename TestFixture::value_type;
+    using mset=TypeParam;
+
+    mset m1({1,2,3,2,3,4,3,4,5});
+
+    // more queries than one block
+    std::vector<value_type> queries;
+    for (int i=0;i<40;++i) queries.push_back(value_type(i%7));
+
+    std::vector<std::size_t> counts;
+    m1.count_many(queries.begin(),queries.end(),std::back_inserter(counts));
+    ASSERT_EQ(queries.size(),counts.size());
+    for (std::size_t j=0;j<queries.size();++j) ASSERT_EQ(m1.count(queries[j]),counts[j]);
+
+    std::vector<typename mset::const_iterator> found;
+    m1.find_many(queries.begin(),queries.end(),std::back_inserter(found));
+    ASSERT_EQ(queries.size(),found.size());
+    for (std::size_t j=0;j<queries.size();++j) ASSERT_EQ(m1.find(queries[j]),found[j]);
+
+    std::vector<bool> contains;
+    m1.contains_many(queries.begin(),queries.end(),std::back_inserter(contains));
+    ASSERT_EQ(queries.size(),contains.size());
+    for (std::size_t j=0;j<queries.size();++j) ASSERT_EQ(m1.count(queries[j])>0,contains[j]);
+
+    mset empty;
+    counts.clear();
+    empty.count_many(queries.begin(),queries.begin()+3,std::back_inserter(counts));
+    ASSERT_EQ(std::vector<std::size_t>(3,0),counts);
+}
+
+TEST(small_multiset,erase_policy) {
+    small::multiset<int> stable({1,2,3,2,3,4,3,4,5});
+    stable.erase(3);
+    ASSERT_TRUE(std::equal(stable.begin(),stable.end(),std::vector<int>{1,2,2,4,4,5}.begin()));
+
+    stable.erase(stable.begin());
+    ASSERT_TRUE(std::equal(stable.begin(),stable.end(),std::vector<int>{2,2,4,4,5}.begin()));
+
+    small::multiset<int,std::equal_to<int>,std::allocator<int>,unordered_erase> unordered({1,2,3,2,3,4,3,4,5});
+    unordered.erase(unordered.begin());
+    ASSERT_TRUE(std::equal(unordered.begin(),unordered.end(),std::vector<int>{5,2,3,2,3,4,3,4}.begin()));
+
+    unordered.erase(3);
+    ASSERT_EQ(5,unordered.size());
+    ASSERT_EQ(0,unordered.count(3));
+    ASSERT_EQ(2,unordered.count(4));
+}
+
+// equality and hashing above the sorted comparison threshold
+
+template <typename T>
+class xmultiset_large: public ::testing::Test {};
+
+using multiset_large_types=::testing::Types<tiny::multiset<int,100>,tiny::multiset<int_nontrivial,100>,small::multiset<int>,small::multiset<int_nontrivial>>;
+TYPED_TEST_CASE(xmultiset_large,multiset_large_types);
+
+TYPED_TEST(xmultiset_large,equality) {
+    using mset=TypeParam;
+
+    mset m1,m2;
+    for (int i=0;i<90;++i) {
+        m1.insert(i%37);
+        m2.insert((89-i)%37);
+    }
+
+    mset m3(m2);
+    m3.erase(m3.find(5));
+    m3.insert(6);
+
+    mset m4(m2);
+    m4.erase(m4.begin());
+
+    ASSERT_EQ(m1,m2);
+    ASSERT_NE(m1,m3);
+    ASSERT_NE(m1,m4);
+
+    multiset_hash<mset,std::hash<int>> hash;
+    ASSERT_EQ(hash(m1),hash(m2));
+    ASSERT_NE(hash(m1),hash(m3));
+}
+
+// capacity overflow policies
+
+template <typename T>
+class xmultiset_overflow: public ::testing::Test {};
+
+using multiset_overflow_types=::testing::Types<int,int_nontrivial>;
+TYPED_TEST_CASE(xmultiset_overflow,multiset_overflow_types);
+
+TYPED_TEST(xmultiset_overflow,policies) {
+    using value_type=TypeParam;
+
+    tiny::multiset<value_type,3,std::equal_to<value_type>,throw_overflow> t({1,2,3});
+    ASSERT_THROW(t.insert(4),std::length_error);
+    ASSERT_EQ(3,t.size());
+
+    tiny::multiset<value_type,3,std::equal_to<value_type>,fail_overflow> f({1,2,3});
+    ASSERT_EQ(f.end(),f.insert(4));
+    ASSERT_EQ(f.end(),f.emplace(4));
+    ASSERT_EQ(3,f.size());
+    ASSERT_EQ(0,f.count(4));
+
+    reset_counts();
+    {
+        tiny::multiset<value_type,3,std::equal_to<value_type>,evict_oldest> e({1,2,3});
+        ASSERT_EQ(4,*e.insert(4));
+        ASSERT_EQ(5,*e.insert(5));
+        ASSERT_EQ(3,e.size());
+        ASSERT_TRUE(std::equal(e.begin(),e.end(),std::vector<int>{3,4,5}.begin()));
+    }
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+
+    tiny::multiset<value_type,3> u({1,2});
+    auto r=u.try_insert(3);
+    ASSERT_TRUE(r.second);
+    ASSERT_EQ(3,*r.first);
+
+    r=u.try_insert(4);
+    ASSERT_FALSE(r.second);
+    ASSERT_EQ(u.end(),r.first);
+    ASSERT_EQ(3,u.size());
+}
+
+// trivial copies and swaps of partly and completely full containers
+
+TEST(tinymultiset,copy_swap_fill) {
+    using mset=tiny::multiset<int,4>;
+
+    mset full({1,2,3,4}),part({5,6}),empty;
+
+    mset a(full),b(part),c(empty);
+    ASSERT_EQ(full,a);
+    ASSERT_EQ(part,b);
+    ASSERT_TRUE(c.empty());
+
+    a.swap(b);
+    ASSERT_EQ(part,a);
+    ASSERT_EQ(full,b);
+    b.swap(c);
+    ASSERT_EQ(full,c);
+    ASSERT_TRUE(b.empty());
+    c.swap(full);
+    ASSERT_EQ(mset({1,2,3,4}),c);
+
+    a=c;
+    ASSERT_EQ(c,a);
+    a=empty;
+    ASSERT_TRUE(a.empty());
+    a=std::move(part);
+    ASSERT_EQ(mset({5,6}),a);
+}
+
+// trivially relocatable element types
+
+struct int_relocatable: int_nontrivial {
+    using int_nontrivial::int_nontrivial;
+};
+
+namespace hf {
+template <> struct is_trivially_relocatable<int_relocatable>: std::true_type {};
+}
+
+TEST(tinymultiset,relocate) {
+    using mset=tiny::multiset<int_relocatable,10>;
+
+    reset_counts();
+    {
+        mset a({1,2,3,4}),b({5,6});
+        int n_ctor=g_ctor_count;
+
+        mset c(std::move(a)),d;
+        d.swap(c);
+        d.erase(d.begin());
+        b=std::move(d);
+        ASSERT_EQ(n_ctor,g_ctor_count);
+
+        ASSERT_TRUE(a.empty());
+        ASSERT_TRUE(c.empty());
+        ASSERT_TRUE(d.empty());
+        ASSERT_EQ((std::vector<int>{4,2,3}),std::vector<int>(b.begin(),b.end()));
+    }
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+}
+
+TEST(tinymultiset,relocate_unique_ptr) {
+    using ptr=std::unique_ptr<int>;
+    static_assert(is_trivially_relocatable<ptr>::value,"unique_ptr is relocatable");
+
+    auto contents=[](const tiny::multiset<ptr,8> &m) {
+        std::vector<int> v;
+        for (const auto &p: m) v.push_back(*p);
+        return v;
+    };
+
+    tiny::multiset<ptr,8> a,b;
+    for (int i=0;i<5;++i) a.insert(ptr(new int(i)));
+    b.insert(ptr(new int(10)));
+
+    a.swap(b);
+    ASSERT_EQ(std::vector<int>{10},contents(a));
+    ASSERT_EQ((std::vector<int>{0,1,2,3,4}),contents(b));
+
+    b.erase(b.begin()+1);
+    ASSERT_EQ((std::vector<int>{0,4,2,3}),contents(b));
+
+    tiny::multiset<ptr,8> c(std::move(b));
+    ASSERT_TRUE(b.empty());
+    ASSERT_EQ((std::vector<int>{0,4,2,3}),contents(c));
+}
+
+// self-organising access order
+
+template <typename T>
+class xmultiset_access: public ::testing::Test {};
+
+using multiset_access_types=::testing::Types<int,int_nontrivial>;
+TYPED_TEST_CASE(xmultiset_access,multiset_access_types);
+
+TYPED_TEST(xmultiset_access,policies) {
+    using value_type=TypeParam;
+    using eq=std::equal_to<value_type>;
+
+    small::multiset<value_type,eq,std::allocator<value_type>,stable_erase,move_to_front> sm({1,2,3,2,4});
+    tiny::multiset<value_type,5,eq,unchecked_overflow,move_to_front> tm({1,2,3,2,4});
+
+    const auto &csm=sm;
+    ASSERT_EQ(csm.begin()+4,csm.find(4));
+
+    ASSERT_EQ(sm.begin(),sm.find(4));
+    ASSERT_EQ(tm.begin(),tm.find(4));
+    ASSERT_TRUE(std::equal(sm.begin(),sm.end(),std::vector<int>{4,1,2,3,2}.begin()));
+    ASSERT_TRUE(std::equal(tm.begin(),tm.end(),std::vector<int>{4,1,2,3,2}.begin()));
+
+    ASSERT_EQ(sm.begin(),sm.find(2));
+    ASSERT_EQ(tm.begin(),tm.find(2));
+    ASSERT_TRUE(std::equal(sm.begin(),sm.end(),std::vector<int>{2,4,1,3,2}.begin()));
+    ASSERT_TRUE(std::equal(tm.begin(),tm.end(),std::vector<int>{2,4,1,3,2}.begin()));
+    ASSERT_EQ(sm.end(),sm.find(5));
+    ASSERT_EQ(2,sm.count(2));
+
+    small::multiset<value_type,eq,std::allocator<value_type>,unordered_erase,transpose> st({1,2,3,4});
+    tiny::multiset<value_type,5,eq,unchecked_overflow,transpose> tt({1,2,3,4});
+
+    ASSERT_EQ(st.begin()+2,st.find(4));
+    ASSERT_EQ(tt.begin()+2,tt.find(4));
+    ASSERT_EQ(st.begin(),st.find(1));
+    ASSERT_TRUE(std::equal(st.begin(),st.end(),std::vector<int>{1,2,4,3}.begin()));
+    ASSERT_TRUE(std::equal(tt.begin(),tt.end(),std::vector<int>{1,2,4,3}.begin()));
+
+    // evict_oldest removes the coldest element under a reordering policy
+    tiny::multiset<value_type,3,eq,evict_oldest,move_to_front> te({1,2,3});
+    te.find(1);
+    te.find(2);
+    te.insert(4);
+    ASSERT_TRUE(std::equal(te.begin(),te.end(),std::vector<int>{2,1,4}.begin()));
+    ASSERT_EQ(0,te.count(3));
+}
+
 template <typename T>
 class xmultiset_nonstd_eq: public ::testing::Test {
 public:
@@ -303,3 +587,71 @@ TYPED_TEST(xmultiset_nonstd_eq,key_eq) {
     ASSERT_EQ(3,eq.k);
 }
 
+
+template <typename T>
+class xmultiset_transparent: public ::testing::Test {};
+
+// transparent equality: int_nontrivial keys can be compared directly
+// with int, without constructing an int_nontrivial
+struct eq_transparent {
+    typedef void is_transparent;
+    bool operator()(int a,int b) const { return a==b; }
+};
+
+using multiset_transparent_types=::testing::Types<tiny::multiset<int_nontrivial,20,eq_transparent>,small::multiset<int_nontrivial,eq_transparent>>;
+TYPED_TEST_CASE(xmultiset_transparent,multiset_transparent_types);
+
+TYPED_TEST(xmultiset_transparent,lookup) {
+    using mset=TypeParam;
+
+    reset_counts();
+
+    {
+        mset m({1,2,3,2,3,4,3,4,5});
+        int n_ctor=g_ctor_count;
+
+        ASSERT_EQ(3,m.count(3));
+        ASSERT_EQ(0,m.count(6));
+        ASSERT_NE(m.end(),m.find(5));
+        ASSERT_EQ(m.end(),m.find(7));
+        ASSERT_EQ(n_ctor,g_ctor_count);
+
+        ASSERT_EQ(2,m.erase(4));
+        ASSERT_EQ(0,m.erase(4));
+        ASSERT_EQ(7,m.size());
+        ASSERT_EQ(0,m.count(4));
+    }
+
+    ASSERT_EQ(g_dtor_count,g_ctor_count);
+}
+
+// empty but final, so cannot be an empty base
+struct eq_final final {
+    bool operator()(int a,int b) const { return a==b; }
+};
+
+TEST(tinymultiset,footprint) {
+    // element count is held in the narrowest sufficient type, and a
+    // stateless key equality takes no space
+    ASSERT_EQ(7u,sizeof(tiny::multiset<std::uint8_t,6>));
+    ASSERT_EQ(60u,sizeof(tiny::multiset<int,14>));
+    ASSERT_LE(sizeof(tiny::multiset<int,300>),300*sizeof(int)+sizeof(int));
+
+    ASSERT_GT(sizeof(tiny::multiset<int,14,eq_mod_k>),sizeof(tiny::multiset<int,14>));
+    tiny::multiset<int,14,eq_final> mf({1,2,2,3});
+    ASSERT_EQ(2u,mf.count(2));
+
+    using fit8=tiny::multiset_fit<std::uint8_t,64>;
+    ASSERT_LE(sizeof(fit8),64u);
+    ASSERT_EQ(63u,fit8().max_size());
+
+    using fit_int=tiny::multiset_fit<int,64>;
+    ASSERT_LE(sizeof(fit_int),64u);
+    ASSERT_EQ(15u,fit_int().max_size());
+    ASSERT_GT(sizeof(tiny::multiset<int,16>),64u);
+
+    fit8 m;
+    for (int i=0;i<63;++i) m.insert(static_cast<std::uint8_t>(i%7));
+    ASSERT_EQ(63u,m.size());
+    ASSERT_EQ(9u,m.count(3));
+}
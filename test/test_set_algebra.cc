@@ -0,0 +1,97 @@
+#include "little/compat.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "little/set_algebra.h"
+
+using namespace hf;
+
+struct int_nontrivial {
+    int_nontrivial(int n_): n(n_) {}
+    int_nontrivial(const int_nontrivial &x): n(x.n) {}
+    int_nontrivial(int_nontrivial &&x): n(x.n) {}
+
+    int_nontrivial &operator=(const int_nontrivial &x) { n=x.n; return *this; }
+    int_nontrivial &operator=(int_nontrivial &&x) { n=x.n; return *this; }
+
+    ~int_nontrivial() {}
+
+    operator int() const { return n; }
+    int n;
+};
+
+// non-default equality, forcing the all-pairs comparison at any size
+struct int_equal {
+    bool operator()(int a,int b) const { return a==b; }
+};
+
+template <typename C>
+std::vector<int> sorted_contents(const C &c) {
+    std::vector<int> x(c.begin(),c.end());
+    std::sort(x.begin(),x.end());
+    return x;
+}
+
+template <typename T>
+class xset_algebra: public ::testing::Test {};
+
+using set_algebra_types=::testing::Types<tiny::multiset<int,20>,tiny::multiset<int_nontrivial,20>,small::multiset<int>,
+                                         small::multiset<int_nontrivial,std::equal_to<int_nontrivial>,std::allocator<int_nontrivial>,unordered_erase>>;
+TYPED_TEST_CASE(xset_algebra,set_algebra_types);
+
+TYPED_TEST(xset_algebra,small_inputs) {
+    using mset=TypeParam;
+
+    mset a({1,2,3,2,3,4,3,4,5});
+    mset b({3,3,6,2,4,4,4,7});
+    mset empty;
+
+    ASSERT_EQ((std::vector<int>{2,3,3,4,4}),sorted_contents(set_intersection(a,b)));
+    ASSERT_EQ((std::vector<int>{1,2,3,5}),sorted_contents(set_difference(a,b)));
+    ASSERT_EQ((std::vector<int>{4,6,7}),sorted_contents(set_difference(b,a)));
+    ASSERT_EQ((std::vector<int>{1,2,2,3,3,3,4,4,4,5,6,7}),sorted_contents(set_union(a,b)));
+    ASSERT_EQ(5,intersection_size(a,b));
+    ASSERT_EQ(5,intersection_size(b,a));
+
+    ASSERT_TRUE(set_intersection(a,empty).empty());
+    ASSERT_EQ(a,set_difference(a,empty));
+    ASSERT_EQ(a,set_union(empty,a));
+    ASSERT_EQ(0,intersection_size(empty,a));
+}
+
+// large inputs take the sorted path for default equality; compare with
+// the all-pairs result under an equivalent custom equality
+
+TEST(set_algebra,large_inputs) {
+    std::vector<int> xs,ys;
+    for (int i=0;i<300;++i) {
+        xs.push_back((i*37)%101);
+        ys.push_back((i*53)%89);
+    }
+
+    small::multiset<int> a(xs.begin(),xs.end()),b(ys.begin(),ys.end());
+    small::multiset<int,int_equal> a_(xs.begin(),xs.end()),b_(ys.begin(),ys.end());
+
+    ASSERT_EQ(sorted_contents(set_intersection(a_,b_)),sorted_contents(set_intersection(a,b)));
+    ASSERT_EQ(sorted_contents(set_difference(a_,b_)),sorted_contents(set_difference(a,b)));
+    ASSERT_EQ(sorted_contents(set_union(a_,b_)),sorted_contents(set_union(a,b)));
+    ASSERT_EQ(intersection_size(a_,b_),intersection_size(a,b));
+
+    std::sort(xs.begin(),xs.end());
+    std::sort(ys.begin(),ys.end());
+    std::vector<int> expected;
+    std::set_intersection(xs.begin(),xs.end(),ys.begin(),ys.end(),std::back_inserter(expected));
+    ASSERT_EQ(expected,sorted_contents(set_intersection(a,b)));
+    ASSERT_EQ(expected.size(),intersection_size(a,b));
+}
+
+TEST(set_algebra,strings) {
+    small::multiset<std::string> a({"fish","cat","dog","cat"});
+    small::multiset<std::string> b({"cat","bird","dog"});
+
+    ASSERT_EQ((small::multiset<std::string>{"cat","dog"}),set_intersection(a,b));
+    ASSERT_EQ((small::multiset<std::string>{"cat","fish"}),set_difference(a,b));
+}
@@ -0,0 +1,156 @@
+#include "little/compat.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "little/shared_map.h"
+
+using namespace hf;
+
+TEST(shared_map,read_write) {
+    small::shared_map<std::string,int> m{{"a",1},{"b",2}};
+
+    ASSERT_EQ(2,m.size());
+    ASSERT_EQ(1,m.count("a"));
+    ASSERT_EQ(2,m.get_or("b",0));
+    ASSERT_EQ(-1,m.get_or("c",-1));
+
+    int v=0;
+    ASSERT_TRUE(m.get("a",v));
+    ASSERT_EQ(1,v);
+    ASSERT_FALSE(m.get("c",v));
+
+    m.insert_or_assign("c",3);
+    m.insert_or_assign("a",4);
+    ASSERT_EQ(3,m.size());
+    ASSERT_EQ(4,m.get_or("a",0));
+
+    ASSERT_EQ(1,m.erase("b"));
+    ASSERT_EQ(0,m.erase("b"));
+    ASSERT_EQ(2,m.size());
+
+    m.update([](small::map<std::string,int> &x) {
+        x["d"]=5;
+        x.erase("a");
+    });
+    small::map<std::string,int> expected{{"c",3},{"d",5}};
+    ASSERT_EQ(expected,*m.snapshot());
+
+    m.assign(small::map<std::string,int>{{"z",26}});
+    ASSERT_EQ(1,m.size());
+    ASSERT_EQ(26,m.get_or("z",0));
+}
+
+namespace {
+// a mapped type without a default constructor
+struct no_default {
+    explicit no_default(int x_): x(x_) {}
+    int x;
+};
+}
+
+TEST(shared_map,no_default_value) {
+    small::shared_map<int,no_default> m;
+    m.insert_or_assign(1,no_default(10));
+    m.insert_or_assign(1,no_default(11));
+    m.insert_or_assign(2,no_default(20));
+
+    ASSERT_EQ(2,m.size());
+    ASSERT_EQ(11,m.get_or(1,no_default(0)).x);
+    ASSERT_EQ(20,m.get_or(2,no_default(0)).x);
+    ASSERT_EQ(-1,m.get_or(3,no_default(-1)).x);
+}
+
+TEST(shared_map,snapshot_isolation) {
+    small::shared_map<int,int> m{{1,10},{2,20}};
+
+    auto s1=m.snapshot();
+    m.insert_or_assign(1,11);
+    m.erase(2);
+    auto s2=m.snapshot();
+
+    // an earlier snapshot is unaffected by later updates
+    ASSERT_EQ(2,s1->size());
+    ASSERT_EQ(10,s1->at(1));
+    ASSERT_EQ(20,s1->at(2));
+
+    ASSERT_EQ(1,s2->size());
+    ASSERT_EQ(11,s2->at(1));
+}
+
+namespace {
+    std::atomic<int> n_live(0);
+
+    struct counted {
+        int v;
+        counted(int v_=0): v(v_) { ++n_live; }
+        counted(const counted &o): v(o.v) { ++n_live; }
+        counted &operator=(const counted &) =default;
+        ~counted() { --n_live; }
+    };
+}
+
+TEST(shared_map,reclamation) {
+    {
+        small::shared_map<int,counted> m;
+        m.update([](small::map<int,counted> &x) {
+            for (int i=0;i<4;++i) x[i]=counted(i);
+        });
+        ASSERT_EQ(4,n_live.load());
+
+        // a held snapshot keeps its version alive
+        auto s=m.snapshot();
+        m.insert_or_assign(0,counted(7));
+        ASSERT_EQ(8,n_live.load());
+
+        s.reset();
+        ASSERT_EQ(4,n_live.load());
+    }
+    ASSERT_EQ(0,n_live.load());
+}
+
+TEST(shared_map,concurrent_readers) {
+    // The writer updates all entries to a common value in one batch;
+    // readers should never see a mixture of values, nor a value decrease.
+
+    constexpr int n_keys=16;
+    constexpr int n_rounds=5000;
+
+    small::map<int,long> init;
+    for (int k=0;k<n_keys;++k) init[k]=0;
+    small::shared_map<int,long> m(init);
+
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0);
+
+    auto reader=[&]() {
+        long last=0;
+        while (!done.load()) {
+            auto s=m.snapshot();
+            if (s->size()!=n_keys) ++failures;
+
+            long v=s->begin()->second;
+            for (const auto &e: *s) if (e.second!=v) ++failures;
+            if (v<last) ++failures;
+            last=v;
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i=0;i<4;++i) readers.emplace_back(reader);
+
+    for (long r=1;r<=n_rounds;++r) {
+        m.update([r](small::map<int,long> &x) {
+            for (int k=0;k<n_keys;++k) x[k]=r;
+        });
+    }
+
+    done.store(true);
+    for (auto &t: readers) t.join();
+
+    ASSERT_EQ(0,failures.load());
+    ASSERT_EQ(n_rounds,m.get_or(n_keys-1,0));
+}